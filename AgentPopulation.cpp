@@ -0,0 +1,54 @@
+#include "AgentPopulation.h"
+#include "CounterRng.h"
+#include <algorithm>
+
+AgentPopulation::AgentPopulation(size_t count)
+    : count(0), seed(CounterRng::getGlobalSeed()), epoch(0) {
+    resize(count);
+}
+
+void AgentPopulation::resize(size_t newCount) {
+    size_t oldCount = count;
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        dimensions[d].resize(newCount, 0.5);
+    }
+    count = newCount;
+
+    // 只初始化新增的代理，已有代理保持原状态
+    if (newCount > oldCount) {
+        randomizeRange(oldCount, newCount);
+    }
+}
+
+void AgentPopulation::randomize(size_t index) {
+    if (index >= count) {
+        return;
+    }
+    randomizeRange(index, index + 1);
+}
+
+void AgentPopulation::randomizeAll() {
+    randomizeRange(0, count);
+}
+
+void AgentPopulation::normalize(size_t index) {
+    if (index >= count) {
+        return;
+    }
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        double& value = dimensions[d][index];
+        value = std::max(0.0, std::min(1.0, value));
+    }
+}
+
+void AgentPopulation::randomizeRange(size_t first, size_t last) {
+    // 每个值只取决于 (种子, 代理ID, 轮次, 维度)，逐维度写入连续数组
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        double* values = dimensions[d].data();
+        uint64_t counter = epoch * DIMENSIONS + d;
+        for (size_t i = first; i < last; ++i) {
+            values[i] = CounterRng::toUnitDouble(CounterRng::generate(seed, i, counter));
+        }
+    }
+    ++epoch;
+}
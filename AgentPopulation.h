@@ -0,0 +1,69 @@
+#pragma once
+
+#include "BioAgent.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// 代理种群：以结构数组(SoA)方式集中存储所有代理的决策向量
+// 每个维度是一段连续的 double 数组，BioAgent 只是指向其中某个下标的轻量句柄
+class AgentPopulation {
+public:
+    // 决策向量维度
+    static constexpr int DIMENSIONS = BioAgent::DECISION_VECTOR_DIMENSIONS;
+
+    // 构造函数（新建的代理会被随机初始化）
+    explicit AgentPopulation(size_t count = 0);
+
+    // 调整代理数量（新增的代理会被随机初始化，多余的代理被丢弃）
+    void resize(size_t newCount);
+
+    // 代理数量
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // 获取代理句柄
+    BioAgent operator[](size_t index) { return BioAgent(this, static_cast<int>(index)); }
+    // 只读句柄：返回 const 句柄，只能调用 BioAgent 的 const 方法
+    const BioAgent operator[](size_t index) const {
+        return BioAgent(const_cast<AgentPopulation*>(this), static_cast<int>(index));
+    }
+
+    // 获取指定维度的连续数据（长度为 size()）
+    double* dimensionData(int dimension) { return dimensions[dimension].data(); }
+    const double* dimensionData(int dimension) const { return dimensions[dimension].data(); }
+
+    // 读写单个代理的单个维度
+    double getValue(size_t index, int dimension) const { return dimensions[dimension][index]; }
+    void setValue(size_t index, int dimension, double value) { dimensions[dimension][index] = value; }
+
+    // 随机初始化指定代理的决策向量
+    void randomize(size_t index);
+
+    // 随机初始化所有代理的决策向量
+    void randomizeAll();
+
+    // 将指定代理的决策向量限制在0.0-1.0范围内
+    void normalize(size_t index);
+
+    // 设置随机种子（默认为 CounterRng 的全局种子，只影响之后的随机初始化）
+    void setSeed(uint64_t newSeed) { seed = newSeed; }
+    uint64_t getSeed() const { return seed; }
+
+private:
+    // 代理数量
+    size_t count;
+
+    // 按维度存放的决策值：dimensions[d][i] 为第 i 个代理第 d 维的值
+    std::vector<double> dimensions[DIMENSIONS];
+
+    // 随机种子：代理 i 第 d 维的初始值由 CounterRng(seed, i, epoch * DIMENSIONS + d) 决定
+    // 不保存任何随机数生成器状态，初始化结果与顺序和线程无关
+    uint64_t seed;
+
+    // 随机初始化的轮次，每次随机初始化后递增，使重复初始化得到不同的值
+    uint64_t epoch;
+
+    // 随机初始化 [first, last) 范围内的代理
+    void randomizeRange(size_t first, size_t last);
+};
@@ -0,0 +1,209 @@
+#include "AgentSimilarity.h"
+#include "ParallelFor.h"
+#include "SimdSupport.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+    constexpr int DIMENSIONS = AgentPopulation::DIMENSIONS;
+
+    // 分块大小：一个列块（12维 * 512 * 8字节 = 48KB）在一个行块的所有行之间复用
+    constexpr size_t ROW_BLOCK = 32;
+    constexpr size_t COLUMN_BLOCK = 512;
+
+    // out[j] = Σ_d row[d] * columns[d][j]，j ∈ [0, length)
+    // 一行的12个分量常驻寄存器，每个输出只写一次
+    void dotRow(const double* const* columns, const double* row, double* out, size_t length) {
+        size_t j = 0;
+#if defined(AMPH_SIMD_AVX2)
+        __m256d r[DIMENSIONS];
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            r[d] = _mm256_set1_pd(row[d]);
+        }
+        for (; j + 4 <= length; j += 4) {
+            __m256d sum = _mm256_mul_pd(r[0], _mm256_loadu_pd(columns[0] + j));
+            for (int d = 1; d < DIMENSIONS; ++d) {
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(r[d], _mm256_loadu_pd(columns[d] + j)));
+            }
+            _mm256_storeu_pd(out + j, sum);
+        }
+#elif defined(AMPH_SIMD_SSE2)
+        __m128d r[DIMENSIONS];
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            r[d] = _mm_set1_pd(row[d]);
+        }
+        for (; j + 2 <= length; j += 2) {
+            __m128d sum = _mm_mul_pd(r[0], _mm_loadu_pd(columns[0] + j));
+            for (int d = 1; d < DIMENSIONS; ++d) {
+                sum = _mm_add_pd(sum, _mm_mul_pd(r[d], _mm_loadu_pd(columns[d] + j)));
+            }
+            _mm_storeu_pd(out + j, sum);
+        }
+#endif
+        for (; j < length; ++j) {
+            double sum = 0.0;
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                sum += row[d] * columns[d][j];
+            }
+            out[j] = sum;
+        }
+    }
+
+    // top-k 小顶堆的比较：相似度较低的在堆顶
+    bool heapOrder(const AgentSimilarity::Neighbor& a, const AgentSimilarity::Neighbor& b) {
+        return a.similarity > b.similarity;
+    }
+}
+
+AgentSimilarity::AgentSimilarity(const AgentPopulation& population, unsigned threadCount)
+    : count(0), threadCount(threadCount) {
+    if (this->threadCount == 0) {
+        this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    refresh(population);
+}
+
+void AgentSimilarity::refresh(const AgentPopulation& population) {
+    count = population.size();
+
+    // 每个代理的范数只计算一次
+    std::vector<double> norms(count, 0.0);
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        const double* values = population.dimensionData(d);
+        for (size_t i = 0; i < count; ++i) {
+            norms[i] += values[i] * values[i];
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        norms[i] = norms[i] > 0.0 ? 1.0 / std::sqrt(norms[i]) : 0.0;
+    }
+
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        const double* values = population.dimensionData(d);
+        unitDimensions[d].resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            unitDimensions[d][i] = values[i] * norms[i];
+        }
+    }
+}
+
+void AgentSimilarity::gatherRow(size_t index, double* row) const {
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        row[d] = unitDimensions[d][index];
+    }
+}
+
+double AgentSimilarity::similarity(size_t a, size_t b) const {
+    if (a >= count || b >= count) {
+        return 0.0;
+    }
+
+    double dot = 0.0;
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        dot += unitDimensions[d][a] * unitDimensions[d][b];
+    }
+    return dot;
+}
+
+void AgentSimilarity::computeMatrix(std::vector<double>& out, size_t rowBegin, size_t rowEnd) const {
+    computeMatrixImpl(out, rowBegin, rowEnd);
+}
+
+void AgentSimilarity::computeMatrix(std::vector<float>& out, size_t rowBegin, size_t rowEnd) const {
+    computeMatrixImpl(out, rowBegin, rowEnd);
+}
+
+template <typename T>
+void AgentSimilarity::computeMatrixImpl(std::vector<T>& out, size_t rowBegin, size_t rowEnd) const {
+    rowEnd = std::min(rowEnd, count);
+    if (rowBegin >= rowEnd) {
+        out.clear();
+        return;
+    }
+    out.resize((rowEnd - rowBegin) * count);
+
+    size_t rowBlocks = (rowEnd - rowBegin + ROW_BLOCK - 1) / ROW_BLOCK;
+    parallelFor(rowBlocks, threadCount, [&](size_t block) {
+        size_t r0 = rowBegin + block * ROW_BLOCK;
+        size_t r1 = std::min(rowEnd, r0 + ROW_BLOCK);
+        double acc[COLUMN_BLOCK];
+        double row[DIMENSIONS];
+
+        for (size_t c0 = 0; c0 < count; c0 += COLUMN_BLOCK) {
+            size_t length = std::min(COLUMN_BLOCK, count - c0);
+            const double* columns[DIMENSIONS];
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                columns[d] = unitDimensions[d].data() + c0;
+            }
+            for (size_t i = r0; i < r1; ++i) {
+                gatherRow(i, row);
+                dotRow(columns, row, acc, length);
+                T* target = out.data() + (i - rowBegin) * count + c0;
+                for (size_t j = 0; j < length; ++j) {
+                    target[j] = static_cast<T>(acc[j]);
+                }
+            }
+        }
+    });
+}
+
+std::vector<AgentSimilarity::Neighbor> AgentSimilarity::topK(size_t k, size_t rowBegin, size_t rowEnd) const {
+    rowEnd = std::min(rowEnd, count);
+    rowBegin = std::min(rowBegin, rowEnd);
+    std::vector<Neighbor> result((rowEnd - rowBegin) * k, Neighbor{-1, 0.0});
+    if (k == 0 || rowBegin == rowEnd) {
+        return result;
+    }
+
+    size_t rowBlocks = (rowEnd - rowBegin + ROW_BLOCK - 1) / ROW_BLOCK;
+    parallelFor(rowBlocks, threadCount, [&](size_t block) {
+        size_t r0 = rowBegin + block * ROW_BLOCK;
+        size_t r1 = std::min(rowEnd, r0 + ROW_BLOCK);
+        double acc[COLUMN_BLOCK];
+        double row[DIMENSIONS];
+
+        // 每行维护一个大小为k的小顶堆
+        std::vector<std::vector<Neighbor>> heaps(r1 - r0);
+        for (auto& heap : heaps) {
+            heap.reserve(k);
+        }
+
+        for (size_t c0 = 0; c0 < count; c0 += COLUMN_BLOCK) {
+            size_t length = std::min(COLUMN_BLOCK, count - c0);
+            const double* columns[DIMENSIONS];
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                columns[d] = unitDimensions[d].data() + c0;
+            }
+            for (size_t i = r0; i < r1; ++i) {
+                gatherRow(i, row);
+                dotRow(columns, row, acc, length);
+
+                auto& heap = heaps[i - r0];
+                for (size_t j = 0; j < length; ++j) {
+                    size_t agentId = c0 + j;
+                    if (agentId == i) {
+                        continue;
+                    }
+                    if (heap.size() < k) {
+                        heap.push_back(Neighbor{static_cast<int>(agentId), acc[j]});
+                        std::push_heap(heap.begin(), heap.end(), heapOrder);
+                    } else if (acc[j] > heap.front().similarity) {
+                        std::pop_heap(heap.begin(), heap.end(), heapOrder);
+                        heap.back() = Neighbor{static_cast<int>(agentId), acc[j]};
+                        std::push_heap(heap.begin(), heap.end(), heapOrder);
+                    }
+                }
+            }
+        }
+
+        // 堆排序后即为相似度降序
+        for (size_t i = r0; i < r1; ++i) {
+            auto& heap = heaps[i - r0];
+            std::sort_heap(heap.begin(), heap.end(), heapOrder);
+            std::copy(heap.begin(), heap.end(), result.begin() + (i - rowBegin) * k);
+        }
+    });
+
+    return result;
+}
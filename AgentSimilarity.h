@@ -0,0 +1,58 @@
+#pragma once
+
+#include "AgentPopulation.h"
+#include <vector>
+#include <cstddef>
+
+// 种群级别的代理相似度计算（余弦相似度）
+// 构造时一次性计算所有代理的单位化决策向量（按维度连续存放），之后的相似度只是点积
+// 矩阵和 top-k 计算按行块/列块分块，内层循环使用 SIMD，行块分配到多个线程
+class AgentSimilarity {
+public:
+    // 相似代理
+    struct Neighbor {
+        int agentId;        // 代理ID，不足k个时为-1
+        double similarity;  // 余弦相似度
+    };
+
+    // 构造函数（threadCount 为0时使用硬件线程数）
+    explicit AgentSimilarity(const AgentPopulation& population, unsigned threadCount = 0);
+
+    // 种群决策向量变化后重新计算单位向量
+    void refresh(const AgentPopulation& population);
+
+    // 代理数量
+    size_t size() const { return count; }
+
+    // 计算两个代理的相似度（与 BioAgent::calculateSimilarity 结果一致）
+    double similarity(size_t a, size_t b) const;
+
+    // 计算 [rowBegin, rowEnd) 行与所有代理的相似度，按行主序写入 out（out[(i - rowBegin) * size() + j]）
+    // rowEnd 超出范围时截断到 size()；全矩阵需要 size()^2 个元素，大种群请分行块计算
+    void computeMatrix(std::vector<double>& out, size_t rowBegin = 0, size_t rowEnd = static_cast<size_t>(-1)) const;
+
+    // 同上，以 float32 输出，内存占用减半
+    void computeMatrix(std::vector<float>& out, size_t rowBegin = 0, size_t rowEnd = static_cast<size_t>(-1)) const;
+
+    // 计算 [rowBegin, rowEnd) 中每个代理在整个种群中最相似的k个代理（不含自身），按相似度降序
+    // 结果为 (rowEnd - rowBegin) * k 个元素，代理 i 的结果位于 [(i - rowBegin) * k, (i - rowBegin + 1) * k)
+    // rowEnd 超出范围时截断到 size()
+    std::vector<Neighbor> topK(size_t k, size_t rowBegin = 0, size_t rowEnd = static_cast<size_t>(-1)) const;
+
+private:
+    // 代理数量
+    size_t count;
+
+    // 工作线程数
+    unsigned threadCount;
+
+    // 单位化后的决策向量：unitDimensions[d][i]，零向量保持为0
+    std::vector<double> unitDimensions[AgentPopulation::DIMENSIONS];
+
+    // 取出一个代理的单位向量（12个分量）
+    void gatherRow(size_t index, double* row) const;
+
+    // 按行主序计算相似度矩阵的通用实现
+    template <typename T>
+    void computeMatrixImpl(std::vector<T>& out, size_t rowBegin, size_t rowEnd) const;
+};
@@ -0,0 +1,145 @@
+// 代理相似度测试：分块 SIMD 计算的相似度矩阵（double 和 float32）、top-k 与逐对调用
+// BioAgent::calculateSimilarity 的标量结果比较；种群大小不是分块大小的整数倍，并包含零向量代理
+// 失败时输出原因并返回非零
+#include "AgentSimilarity.h"
+#include "AgentPopulation.h"
+#include "BioAgent.h"
+#include "CounterRng.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void expect(bool condition, const std::string& message) {
+        if (!condition) {
+            ++failures;
+            std::cout << "失败: " << message << std::endl;
+        }
+    }
+
+    // 逐对标量计算的相似度矩阵
+    std::vector<double> scalarMatrix(const AgentPopulation& population) {
+        size_t n = population.size();
+        std::vector<double> matrix(n * n);
+        for (size_t i = 0; i < n; ++i) {
+            BioAgent a = population[i];
+            for (size_t j = 0; j < n; ++j) {
+                matrix[i * n + j] = a.calculateSimilarity(population[j]);
+            }
+        }
+        return matrix;
+    }
+
+    // 矩阵的 [rowBegin, rowEnd) 行与标量结果的最大误差
+    template <typename T>
+    double maxError(const std::vector<T>& rows, const std::vector<double>& expected, size_t n, size_t rowBegin, size_t rowEnd) {
+        if (rows.size() != (rowEnd - rowBegin) * n) {
+            return INFINITY;
+        }
+        double error = 0.0;
+        for (size_t i = rowBegin; i < rowEnd; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                error = std::max(error, std::abs(static_cast<double>(rows[(i - rowBegin) * n + j]) - expected[i * n + j]));
+            }
+        }
+        return error;
+    }
+
+    // top-k 的相似度序列与标量结果排序后的前k个一致（相似度相同的代理可能以不同顺序出现），且不含自身
+    void checkTopK(const AgentSimilarity& similarity, const std::vector<double>& expected, size_t k,
+                   size_t rowBegin, size_t rowEnd, const std::string& name) {
+        size_t n = similarity.size();
+        std::vector<AgentSimilarity::Neighbor> neighbors = similarity.topK(k, rowBegin, rowEnd);
+        if (neighbors.size() != (rowEnd - rowBegin) * k) {
+            expect(false, name + ": 结果数量为 " + std::to_string(neighbors.size()));
+            return;
+        }
+        size_t mismatches = 0;
+        for (size_t i = rowBegin; i < rowEnd; ++i) {
+            std::vector<double> others;
+            for (size_t j = 0; j < n; ++j) {
+                if (j != i) {
+                    others.push_back(expected[i * n + j]);
+                }
+            }
+            std::sort(others.begin(), others.end(), [](double a, double b) { return a > b; });
+            for (size_t r = 0; r < k; ++r) {
+                const AgentSimilarity::Neighbor& neighbor = neighbors[(i - rowBegin) * k + r];
+                if (r >= others.size()) {
+                    mismatches += neighbor.agentId != -1;
+                    continue;
+                }
+                bool valid = neighbor.agentId >= 0 && static_cast<size_t>(neighbor.agentId) < n &&
+                             static_cast<size_t>(neighbor.agentId) != i;
+                if (!valid || std::abs(neighbor.similarity - others[r]) > 1e-12 ||
+                    std::abs(expected[i * n + neighbor.agentId] - neighbor.similarity) > 1e-12) {
+                    ++mismatches;
+                }
+            }
+        }
+        expect(mismatches == 0, name + ": " + std::to_string(mismatches) + " 个结果与标量计算不一致");
+    }
+}
+
+int main() {
+    // 1000 不是行块（32）和列块（512）的整数倍，也覆盖 SIMD 循环的余数部分
+    CounterRng::setGlobalSeed(7);
+    AgentPopulation population(1000);
+    for (int d = 0; d < AgentPopulation::DIMENSIONS; ++d) {
+        population.setValue(17, d, 0.0);                              // 零向量：与任何代理的相似度为0
+        population.setValue(42, d, population.getValue(41, d) * 0.5);  // 与代理41方向相同
+    }
+    const size_t n = population.size();
+    std::vector<double> expected = scalarMatrix(population);
+
+    for (unsigned threads : {1u, 4u}) {
+        std::string suffix = "（" + std::to_string(threads) + " 个线程）";
+        AgentSimilarity similarity(population, threads);
+        expect(similarity.size() == n, "size()" + suffix);
+
+        double pairError = 0.0;
+        for (size_t i = 0; i < n; i += 7) {
+            for (size_t j = 0; j < n; ++j) {
+                pairError = std::max(pairError, std::abs(similarity.similarity(i, j) - expected[i * n + j]));
+            }
+        }
+        expect(pairError < 1e-12, "similarity() 最大误差 " + std::to_string(pairError) + suffix);
+
+        std::vector<double> matrix;
+        similarity.computeMatrix(matrix);
+        double error = maxError(matrix, expected, n, 0, n);
+        expect(error < 1e-12, "double 矩阵最大误差 " + std::to_string(error) + suffix);
+
+        similarity.computeMatrix(matrix, 100, 357);
+        error = maxError(matrix, expected, n, 100, 357);
+        expect(error < 1e-12, "double 矩阵行范围 [100, 357) 最大误差 " + std::to_string(error) + suffix);
+
+        std::vector<float> matrix32;
+        similarity.computeMatrix(matrix32);
+        error = maxError(matrix32, expected, n, 0, n);
+        expect(error < 1e-6, "float32 矩阵最大误差 " + std::to_string(error) + suffix);
+
+        similarity.computeMatrix(matrix32, 990, n + 100);
+        error = maxError(matrix32, expected, n, 990, n);
+        expect(error < 1e-6, "float32 矩阵行范围超出种群时截断" + suffix);
+
+        checkTopK(similarity, expected, 5, 0, n, "top-5" + suffix);
+        checkTopK(similarity, expected, 3, 30, 70, "行范围 [30, 70) 的 top-3" + suffix);
+        expect(similarity.similarity(41, 42) > 1.0 - 1e-12, "方向相同的代理相似度应为1" + suffix);
+    }
+
+    // 代理数量少于 k 时，不足的位置为 -1
+    AgentPopulation small(3);
+    AgentSimilarity smallSimilarity(small, 1);
+    std::vector<double> smallExpected = scalarMatrix(small);
+    checkTopK(smallSimilarity, smallExpected, 5, 0, 3, "3 个代理的 top-5");
+
+    if (failures == 0) {
+        std::cout << "AgentSimilarity: 全部通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
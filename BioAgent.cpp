@@ -1,4 +1,5 @@
 #include "BioAgent.h"
+#include "AgentPopulation.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -6,39 +7,66 @@
 #include <algorithm>
 #include <iomanip>
 
-BioAgent::BioAgent(int id) 
-    : id(id), decisionVector(DECISION_VECTOR_DIMENSIONS, 0.5) {
-    rng.seed(std::random_device{}());
-    dist = std::uniform_real_distribution<double>(0.0, 1.0);
-    
-    // 随机初始化决策向量
-    randomizeDecisionVector();
+bool BioAgent::isValid() const {
+    return population != nullptr && id >= 0 && static_cast<size_t>(id) < population->size();
 }
 
-void BioAgent::updateDecisionVector(const std::vector<double>& feedback) {
-    if (feedback.size() != DECISION_VECTOR_DIMENSIONS) {
+DecisionVector BioAgent::getDecisionVector() const {
+    DecisionVector decisionVector;
+    if (!isValid()) {
+        return decisionVector;
+    }
+
+    for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
+        decisionVector[i] = population->getValue(id, i);
+    }
+    return decisionVector;
+}
+
+void BioAgent::setDecisionVector(const DecisionVector& decisions) {
+    if (!isValid()) {
+        return;
+    }
+
+    for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
+        population->setValue(id, i, decisions[i]);
+    }
+}
+
+double BioAgent::getDecisionValue(DecisionVectorDimension dimension) const {
+    if (isValid() && dimension >= 0 && dimension < DECISION_VECTOR_DIMENSIONS) {
+        return population->getValue(id, dimension);
+    }
+    return 0.0;
+}
+
+void BioAgent::setDecisionValue(DecisionVectorDimension dimension, double value) {
+    if (isValid() && dimension >= 0 && dimension < DECISION_VECTOR_DIMENSIONS) {
+        population->setValue(id, dimension, value);
+    }
+}
+
+void BioAgent::updateDecisionVector(const DecisionVector& feedback) {
+    if (!isValid()) {
         return;
     }
-    
+
     // 根据反馈更新决策向量，保持值在0.0-1.0范围内
     for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
-        double newValue = decisionVector[i] + feedback[i];
+        double newValue = population->getValue(id, i) + feedback[i];
         // 限制在0.0-1.0范围内
-        decisionVector[i] = std::max(0.0, std::min(1.0, newValue));
+        population->setValue(id, i, std::max(0.0, std::min(1.0, newValue)));
     }
-    
-    // 标准化决策向量
-    normalizeDecisionVector();
 }
 
-bool BioAgent::checkDecisionRequirement(const std::vector<double>& requirement) const {
-    if (requirement.size() != DECISION_VECTOR_DIMENSIONS) {
+bool BioAgent::checkDecisionRequirement(const DecisionVector& requirement) const {
+    if (!isValid()) {
         return false;
     }
-    
+
     // 检查每个维度是否满足要求（决策向量值 >= 要求值）
     for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
-        if (decisionVector[i] < requirement[i]) {
+        if (population->getValue(id, i) < requirement[i]) {
             return false;
         }
     }
@@ -46,60 +74,69 @@ bool BioAgent::checkDecisionRequirement(const std::vector<double>& requirement)
 }
 
 void BioAgent::randomizeDecisionVector() {
-    for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
-        decisionVector[i] = dist(rng);
+    if (!isValid()) {
+        return;
     }
-    normalizeDecisionVector();
+    population->randomize(id);
 }
 
 void BioAgent::normalizeDecisionVector() {
+    if (!isValid()) {
+        return;
+    }
     // 确保所有值在0.0-1.0范围内
-    for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
-        decisionVector[i] = std::max(0.0, std::min(1.0, decisionVector[i]));
+    population->normalize(id);
+}
+
+const char* BioAgent::getDimensionName(int dimension) {
+    static const char* dimensionNames[DECISION_VECTOR_DIMENSIONS] = {
+        "快乐", "悲伤", "愤怒", "恐惧", "厌恶", "惊讶",
+        "信任", "期待", "宁静", "效价", "唤醒度", "优势度"
+    };
+
+    if (dimension < 0 || dimension >= DECISION_VECTOR_DIMENSIONS) {
+        return "";
     }
+    return dimensionNames[dimension];
 }
 
 std::string BioAgent::getDecisionVectorString() const {
     std::stringstream ss;
     ss << std::fixed << std::setprecision(3);
-    
-    const char* dimensionNames[DECISION_VECTOR_DIMENSIONS] = {
-        "快乐", "悲伤", "愤怒", "恐惧", "厌恶", "惊讶",
-        "信任", "期待", "宁静", "效价", "唤醒度", "优势度"
-    };
-    
+
     ss << "[";
     for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
-        ss << dimensionNames[i] << ": " << decisionVector[i];
+        ss << getDimensionName(i) << ": " << getDecisionValue(static_cast<DecisionVectorDimension>(i));
         if (i < DECISION_VECTOR_DIMENSIONS - 1) {
             ss << ", ";
         }
     }
     ss << "]";
-    
+
     return ss.str();
 }
 
 double BioAgent::calculateSimilarity(const BioAgent& other) const {
-    if (decisionVector.empty() || other.decisionVector.empty() || 
-        decisionVector.size() != other.decisionVector.size()) {
+    if (!isValid() || !other.isValid()) {
         return 0.0;
     }
-    
+
     // 计算余弦相似度
     double dotProduct = 0.0;
     double normA = 0.0;
     double normB = 0.0;
-    
-    for (size_t i = 0; i < decisionVector.size(); ++i) {
-        dotProduct += decisionVector[i] * other.decisionVector[i];
-        normA += decisionVector[i] * decisionVector[i];
-        normB += other.decisionVector[i] * other.decisionVector[i];
+
+    for (int i = 0; i < DECISION_VECTOR_DIMENSIONS; ++i) {
+        double a = population->getValue(id, i);
+        double b = other.population->getValue(other.id, i);
+        dotProduct += a * b;
+        normA += a * a;
+        normB += b * b;
     }
-    
+
     if (normA == 0.0 || normB == 0.0) {
         return 0.0;
     }
-    
+
     return dotProduct / (std::sqrt(normA) * std::sqrt(normB));
-}
\ No newline at end of file
+}
@@ -1,13 +1,16 @@
 #pragma once
 
+#include "DecisionVector.h"
 #include <string>
-#include <vector>
-#include <random>
 
+class AgentPopulation;
+
+// 生物代理：指向 AgentPopulation 中某个代理的轻量句柄
+// 决策向量本身按维度连续存放在种群中，句柄只保存种群指针和代理ID
 class BioAgent {
 public:
     // 决策向量维度常量
-    static constexpr int DECISION_VECTOR_DIMENSIONS = 12;
+    static constexpr int DECISION_VECTOR_DIMENSIONS = DecisionVector::DIMENSIONS;
     
     // 决策向量维度枚举
     enum DecisionVectorDimension { 
@@ -25,45 +28,33 @@ public:
         DOMINANCE       // 优势度
     };
     
-    // 构造函数
-    BioAgent(int id = -1);
+    // 构造函数（id 即代理在种群中的下标）
+    BioAgent(AgentPopulation* population = nullptr, int id = -1)
+        : population(population), id(id) {}
     
     // 获取代理ID
     int getId() const { return id; }
     
-    // 设置代理ID
-    void setId(int newId) { id = newId; }
+    // 句柄是否指向有效代理
+    bool isValid() const;
     
-    // 获取决策向量
-    const std::vector<double>& getDecisionVector() const { return decisionVector; }
+    // 获取决策向量（从种群中按维度收集的副本）
+    DecisionVector getDecisionVector() const;
     
     // 设置决策向量
-    void setDecisionVector(const std::vector<double>& decisions) { 
-        if (decisions.size() == DECISION_VECTOR_DIMENSIONS) {
-            decisionVector = decisions;
-        }
-    }
+    void setDecisionVector(const DecisionVector& decisions);
     
     // 根据反馈更新决策向量（反馈是12维向量，正值增加，负值减少）
-    void updateDecisionVector(const std::vector<double>& feedback);
+    void updateDecisionVector(const DecisionVector& feedback);
     
     // 检查决策向量是否满足要求（每个维度 >= 要求值）
-    bool checkDecisionRequirement(const std::vector<double>& requirement) const;
+    bool checkDecisionRequirement(const DecisionVector& requirement) const;
     
     // 获取指定维度的决策值
-    double getDecisionValue(DecisionVectorDimension dimension) const {
-        if (dimension >= 0 && dimension < DECISION_VECTOR_DIMENSIONS) {
-            return decisionVector[dimension];
-        }
-        return 0.0;
-    }
+    double getDecisionValue(DecisionVectorDimension dimension) const;
     
     // 设置指定维度的决策值
-    void setDecisionValue(DecisionVectorDimension dimension, double value) {
-        if (dimension >= 0 && dimension < DECISION_VECTOR_DIMENSIONS) {
-            decisionVector[dimension] = value;
-        }
-    }
+    void setDecisionValue(DecisionVectorDimension dimension, double value);
     
     // 随机初始化决策向量
     void randomizeDecisionVector();
@@ -71,6 +62,9 @@ public:
     // 标准化决策向量（确保所有值在0.0-1.0范围内）
     void normalizeDecisionVector();
     
+    // 获取维度的中文名称
+    static const char* getDimensionName(int dimension);
+    
     // 获取决策向量的字符串表示
     std::string getDecisionVectorString() const;
     
@@ -78,13 +72,9 @@ public:
     double calculateSimilarity(const BioAgent& other) const;
 
 private:
-    // 代理ID
-    int id;
+    // 所属种群，12维决策向量（快乐、悲伤、愤怒、恐惧、厌恶、惊讶、信任、期待、宁静、效价、唤醒度、优势度，每个维度范围0.0-1.0）存放于此
+    AgentPopulation* population;
     
-    // 12维决策向量：快乐、悲伤、愤怒、恐惧、厌恶、惊讶、信任、期待、宁静、效价、唤醒度、优势度（每个维度范围0.0-1.0）
-    std::vector<double> decisionVector;
-    
-    // 随机数生成器
-    std::mt19937 rng;
-    std::uniform_real_distribution<double> dist;
+    // 代理ID（种群下标）
+    int id;
 };
\ No newline at end of file
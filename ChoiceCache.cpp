@@ -0,0 +1,203 @@
+#include "ChoiceCache.h"
+#include "FileUtils.h"
+#include "Json.h"
+#include "Logger.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+namespace {
+    // 缓存文件格式版本
+    constexpr int64_t CACHE_FILE_VERSION = 1;
+}
+
+void ChoiceCache::EventHasher::add(std::string_view text) {
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    // 段与段之间加入分隔，避免 "ab"+"c" 与 "a"+"bc" 得到相同的哈希
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+}
+
+size_t ChoiceCache::KeyHash::operator()(const Key& key) const {
+    uint64_t hash = key.eventHash;
+    for (int32_t cell : key.cells) {
+        hash = (hash ^ static_cast<uint32_t>(cell)) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    return static_cast<size_t>(hash);
+}
+
+ChoiceCache::Key ChoiceCache::makeKey(uint64_t eventHash, const DecisionVector& vector) const {
+    Key key;
+    key.eventHash = eventHash;
+    for (size_t i = 0; i < DecisionVector::DIMENSIONS; ++i) {
+        double cell = std::round(vector[i] / quantum);
+        if (!std::isfinite(cell)) {
+            cell = 0.0;
+        }
+        cell = std::clamp(cell, static_cast<double>(std::numeric_limits<int32_t>::min()),
+                          static_cast<double>(std::numeric_limits<int32_t>::max()));
+        key.cells[i] = static_cast<int32_t>(cell);
+    }
+    return key;
+}
+
+void ChoiceCache::configure(size_t newCapacity, double newQuantum) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = newCapacity;
+    quantum = newQuantum > 0.0 && std::isfinite(newQuantum) ? newQuantum : DEFAULT_QUANTUM;
+    entries.clear();
+    index.clear();
+}
+
+bool ChoiceCache::lookup(uint64_t eventHash, const DecisionVector& vector, int& choice) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0) {
+        return false;
+    }
+    auto it = index.find(makeKey(eventHash, vector));
+    if (it == index.end()) {
+        ++missCount;
+        return false;
+    }
+    // 移到最前（最近使用）
+    entries.splice(entries.begin(), entries, it->second);
+    choice = it->second->choice;
+    ++hitCount;
+    return true;
+}
+
+bool ChoiceCache::contains(uint64_t eventHash, const DecisionVector& vector) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity != 0 && index.count(makeKey(eventHash, vector)) != 0;
+}
+
+void ChoiceCache::store(uint64_t eventHash, const DecisionVector& vector, int choice) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0) {
+        return;
+    }
+    insertLocked(makeKey(eventHash, vector), choice);
+}
+
+void ChoiceCache::insertLocked(const Key& key, int choice) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        it->second->choice = choice;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    entries.push_front(Entry{key, choice});
+    index.emplace(key, entries.begin());
+    while (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++evictionCount;
+    }
+}
+
+void ChoiceCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+}
+
+bool ChoiceCache::save(const std::string& path) const {
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        text.reserve(64 + entries.size() * 96);
+        JsonWriter writer(text);
+        writer.beginObject().key("version").integer(CACHE_FILE_VERSION).key("quantum").number(quantum);
+        writer.key("entries").beginArray();
+        // 从最久未使用的开始写，加载时依次插入即可恢复淘汰顺序
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            char hex[17];
+            auto [end, ec] = std::to_chars(hex, hex + sizeof(hex), it->key.eventHash, 16);
+            writer.beginObject().key("event").string(std::string_view(hex, end - hex)).key("cells").beginArray();
+            for (int32_t cell : it->key.cells) {
+                writer.integer(cell);
+            }
+            writer.endArray().key("choice").integer(it->choice).endObject();
+        }
+        writer.endArray().endObject();
+    }
+
+    // 替换方式写入，避免中途退出留下不完整的缓存文件
+    text.push_back('\n');
+    return writeFileAtomically(path, text);
+}
+
+size_t ChoiceCache::load(const std::string& path) {
+    std::error_code existsError;
+    if (!std::filesystem::exists(path, existsError)) {
+        return 0;
+    }
+
+    JsonDocument document;
+    if (!document.load(path)) {
+        LOG_WARN("ChoiceCache: 缓存文件解析错误 " << path << ": " << document.error());
+        return 0;
+    }
+    JsonValue root = document.root();
+    if (root["version"].asInt() != CACHE_FILE_VERSION) {
+        LOG_WARN("ChoiceCache: 缓存文件版本不符，已忽略 " << path);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0) {
+        return 0;
+    }
+    double fileQuantum = root["quantum"].asDouble();
+    if (std::fabs(fileQuantum - quantum) > 1e-12) {
+        LOG_WARN("ChoiceCache: 缓存文件的量化间距 (" << fileQuantum << ") 与当前配置 (" << quantum
+                 << ") 不同，已忽略 " << path);
+        return 0;
+    }
+
+    size_t loaded = 0;
+    for (JsonValue item = root["entries"].first(); item; item = item.next()) {
+        std::string_view hex = item["event"].raw();
+        JsonValue cells = item["cells"];
+        JsonValue choice = item["choice"];
+        Key key;
+        auto [end, ec] = std::from_chars(hex.data(), hex.data() + hex.size(), key.eventHash, 16);
+        if (ec != std::errc() || end != hex.data() + hex.size() || choice.asInt(-1) < 0 ||
+            cells.size() != DecisionVector::DIMENSIONS) {
+            continue;
+        }
+        size_t i = 0;
+        for (JsonValue cell = cells.first(); cell; cell = cell.next()) {
+            key.cells[i++] = static_cast<int32_t>(cell.asInt());
+        }
+        insertLocked(key, static_cast<int>(choice.asInt()));
+        ++loaded;
+    }
+    return std::min(loaded, entries.size());
+}
+
+bool ChoiceCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity != 0;
+}
+
+size_t ChoiceCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t ChoiceCache::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+double ChoiceCache::getQuantum() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return quantum;
+}
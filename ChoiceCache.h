@@ -0,0 +1,98 @@
+#pragma once
+
+#include "DecisionVector.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// LLM选择缓存：记住 (事件内容, 量化后的决策向量) 对应的LLM选择，避免重复的网络往返
+// 决策向量每个维度按 quantum 取整到网格上，同一网格内的代理面对同一事件时共用一次LLM回答
+// 按最近使用顺序淘汰（LRU），容量为0时禁用；可以保存到文件并在下次运行时加载
+// 所有方法都可以在多个线程中同时调用
+class ChoiceCache {
+public:
+    // 默认最多缓存的选择数量
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    // 默认量化网格间距
+    static constexpr double DEFAULT_QUANTUM = 0.05;
+
+    // 事件内容哈希（FNV-1a）：依次加入LLM看到的各段文本（描述、选项文本、结果文本）
+    class EventHasher {
+    public:
+        void add(std::string_view text);
+        uint64_t value() const { return hash; }
+
+    private:
+        uint64_t hash = 14695981039346656037ull;
+    };
+
+    // 设置容量和量化网格间距（清空已有的缓存）
+    void configure(size_t capacity, double quantum);
+
+    // 查找缓存的选择，命中时写入 choice 并标记为最近使用（计入命中/未命中统计）
+    bool lookup(uint64_t eventHash, const DecisionVector& vector, int& choice);
+
+    // 是否有缓存的选择（不计入统计，也不改变淘汰顺序）
+    bool contains(uint64_t eventHash, const DecisionVector& vector) const;
+
+    // 保存一个选择（超出容量时淘汰最久未使用的选择）
+    void store(uint64_t eventHash, const DecisionVector& vector, int choice);
+
+    void clear();
+
+    // 保存到文件 / 从文件加载（量化网格不同的文件会被忽略），返回是否成功 / 加载的选择数量
+    bool save(const std::string& path) const;
+    size_t load(const std::string& path);
+
+    bool isEnabled() const;
+    size_t size() const;
+    size_t getCapacity() const;
+    double getQuantum() const;
+
+    // 统计：命中、未命中、淘汰次数
+    uint64_t getHitCount() const { return hitCount; }
+    uint64_t getMissCount() const { return missCount; }
+    uint64_t getEvictionCount() const { return evictionCount; }
+
+private:
+    struct Key {
+        uint64_t eventHash;
+        std::array<int32_t, DecisionVector::DIMENSIONS> cells;  // 各维度量化后的网格坐标
+
+        bool operator==(const Key& other) const {
+            return eventHash == other.eventHash && cells == other.cells;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        int choice;
+    };
+
+    // 计算缓存键（调用时需持有 mutex）
+    Key makeKey(uint64_t eventHash, const DecisionVector& vector) const;
+
+    // 插入或更新一个选择（调用时需持有 mutex）
+    void insertLocked(const Key& key, int choice);
+
+    mutable std::mutex mutex;
+    std::list<Entry> entries;   // 最近使用的在前
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    size_t capacity = DEFAULT_CAPACITY;
+    double quantum = DEFAULT_QUANTUM;
+
+    std::atomic<uint64_t> hitCount{0};
+    std::atomic<uint64_t> missCount{0};
+    std::atomic<uint64_t> evictionCount{0};
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <random>
+
+// 基于计数器的随机数生成器（SplitMix64 风格）
+// 每个随机数都是 (全局种子, 流ID, 计数器) 的纯函数：
+//   - 构造不做任何系统调用，状态只有三个整数
+//   - 不同的流（例如不同代理）相互独立，并行线程各自取数无需加锁
+//   - 全局种子相同时整次运行可以完全重放
+// 满足 UniformRandomBitGenerator 要求，可直接配合 std::uniform_*_distribution 使用
+class CounterRng {
+public:
+    using result_type = uint64_t;
+
+    // 预留的流ID：代理流直接使用代理ID，其余流放在高位区间以免与代理ID冲突
+    static constexpr uint64_t STREAM_ENVIRONMENT = 0xE000000000000001ULL;
+    static constexpr uint64_t STREAM_LLM_EVENT = 0xE000000000000002ULL;
+    static constexpr uint64_t STREAM_LLM_CHOICE = 0xE000000000000003ULL;
+    static constexpr uint64_t STREAM_LLM_SAVED = 0xE000000000000004ULL;
+    static constexpr uint64_t STREAM_BROADCAST = 0xE000000000000005ULL;
+    static constexpr uint64_t STREAM_LLM_RETRY = 0xE000000000000006ULL;
+
+    // 构造函数：使用当前全局种子
+    explicit CounterRng(uint64_t stream = 0, uint64_t counter = 0)
+        : seed(getGlobalSeed()), stream(stream), counter(counter) {}
+
+    // 构造函数：显式指定种子
+    CounterRng(uint64_t seed, uint64_t stream, uint64_t counter)
+        : seed(seed), stream(stream), counter(counter) {}
+
+    // 计算 (seed, stream, counter) 对应的随机数
+    static uint64_t generate(uint64_t seed, uint64_t stream, uint64_t counter) {
+        uint64_t key = mix(seed ^ mix(stream ^ 0x6A09E667F3BCC909ULL));
+        return mix(key + (counter + 1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // 由基础流和tick派生出一个新的流ID（用于“每次调用一条流”的场景）
+    static uint64_t deriveStream(uint64_t stream, uint64_t tick) {
+        return mix(stream + mix(tick ^ 0xBB67AE8584CAA73BULL));
+    }
+
+    // 将64位随机数转换为 [0, 1) 区间的 double
+    static double toUnitDouble(uint64_t bits) {
+        return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // UniformRandomBitGenerator 接口
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()() { return generate(seed, stream, counter++); }
+
+    // 取下一个 [0, 1) 区间的 double
+    double nextDouble() { return toUnitDouble((*this)()); }
+
+    // 当前计数器（已取出的随机数个数）
+    uint64_t getCounter() const { return counter; }
+
+    // 设置全局种子（应在创建代理和模拟环境之前设置）
+    static void setGlobalSeed(uint64_t newSeed) {
+        globalSeed().store(newSeed);
+        globalSeedSet().store(true);
+    }
+
+    // 获取全局种子；未设置时从 random_device 取一次并固定下来
+    static uint64_t getGlobalSeed() {
+        if (!globalSeedSet().load()) {
+            static std::mutex seedMutex;
+            std::lock_guard<std::mutex> lock(seedMutex);
+            if (!globalSeedSet().load()) {
+                std::random_device rd;
+                globalSeed().store((static_cast<uint64_t>(rd()) << 32) ^ rd());
+                globalSeedSet().store(true);
+            }
+        }
+        return globalSeed().load();
+    }
+
+private:
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t counter;
+
+    // SplitMix64 的输出混合函数
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static std::atomic<uint64_t>& globalSeed() {
+        static std::atomic<uint64_t> value{0};
+        return value;
+    }
+
+    static std::atomic<bool>& globalSeedSet() {
+        static std::atomic<bool> value{false};
+        return value;
+    }
+};
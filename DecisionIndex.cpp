@@ -0,0 +1,316 @@
+#include "DecisionIndex.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // 按距离升序排序；用作堆比较时距离最远的在堆顶
+    bool byDistance(const DecisionIndex::Match& a, const DecisionIndex::Match& b) {
+        return a.distance < b.distance;
+    }
+}
+
+DecisionIndex::DecisionIndex(const AgentPopulation& population)
+    : population(population) {
+}
+
+void DecisionIndex::rebuild() {
+    std::lock_guard<std::mutex> lock(queryMutex);
+    built = false;
+    entries.clear();
+    nodes.clear();
+    agentEntry.clear();
+    moved.clear();
+    movedAgents.clear();
+    staleQueries = 0;
+}
+
+void DecisionIndex::update(size_t agentId) {
+    if (!built || agentId >= moved.size() || moved[agentId]) {
+        return;
+    }
+
+    // 树中的旧位置作废，查询时改为扫描该代理的当前值
+    moved[agentId] = 1;
+    movedAgents.push_back(static_cast<uint32_t>(agentId));
+    entries[agentEntry[agentId]].agentId = -1;
+}
+
+void DecisionIndex::updateMasked(size_t first, const AgentMask& mask) {
+    if (!built) {
+        return;
+    }
+    for (size_t w = 0; w < mask.size(); ++w) {
+        uint64_t word = mask[w];
+        while (word != 0) {
+            update(first + w * 64 + static_cast<size_t>(std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+}
+
+std::vector<DecisionIndex::Match> DecisionIndex::nearest(const DecisionVector& target, size_t k) const {
+    std::vector<Match> result;
+    if (k == 0 || population.empty()) {
+        return result;
+    }
+
+    // result 作为大顶堆保存当前最近的k个代理（distance 暂存距离平方）
+    std::lock_guard<std::mutex> lock(queryMutex);
+    result.reserve(k);
+    if (!prepareTree()) {
+        for (size_t agentId = 0; agentId < population.size(); ++agentId) {
+            offer(result, k, static_cast<int>(agentId), distanceSquared(agentId, target));
+        }
+    } else {
+        // 先放入移动过的代理，使树的剪枝从一开始就有较小的上界
+        for (uint32_t agentId : movedAgents) {
+            offer(result, k, static_cast<int>(agentId), distanceSquared(agentId, target));
+        }
+        searchNearest(0, target, k, result);
+    }
+
+    std::sort(result.begin(), result.end(), byDistance);
+    for (auto& match : result) {
+        match.distance = std::sqrt(match.distance);
+    }
+    return result;
+}
+
+std::vector<DecisionIndex::Match> DecisionIndex::withinRadius(const DecisionVector& target, double radius) const {
+    std::vector<Match> result;
+    if (radius < 0.0 || population.empty()) {
+        return result;
+    }
+
+    double radiusSquared = radius * radius;
+    std::lock_guard<std::mutex> lock(queryMutex);
+    if (!prepareTree()) {
+        for (size_t agentId = 0; agentId < population.size(); ++agentId) {
+            double d2 = distanceSquared(agentId, target);
+            if (d2 <= radiusSquared) {
+                result.push_back(Match{static_cast<int>(agentId), d2});
+            }
+        }
+    } else {
+        for (uint32_t agentId : movedAgents) {
+            double d2 = distanceSquared(agentId, target);
+            if (d2 <= radiusSquared) {
+                result.push_back(Match{static_cast<int>(agentId), d2});
+            }
+        }
+        searchRadius(0, target, radiusSquared, result);
+    }
+
+    std::sort(result.begin(), result.end(), byDistance);
+    for (auto& match : result) {
+        match.distance = std::sqrt(match.distance);
+    }
+    return result;
+}
+
+bool DecisionIndex::prepareTree() const {
+    bool stale = !built || agentEntry.size() != population.size() ||
+                 movedAgents.size() > std::max(LEAF_SIZE, population.size() / REBUILD_DIVISOR);
+    if (!stale) {
+        return true;
+    }
+    if (++staleQueries < REBUILD_AFTER_QUERIES) {
+        return false;
+    }
+    build();
+    return true;
+}
+
+void DecisionIndex::build() const {
+    size_t count = population.size();
+    entries.resize(count);
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        const double* values = population.dimensionData(d);
+        for (size_t i = 0; i < count; ++i) {
+            entries[i].values[d] = values[i];
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        entries[i].agentId = static_cast<int32_t>(i);
+    }
+
+    nodes.clear();
+    nodes.reserve(2 * (count / LEAF_SIZE + 1));
+    nodes.emplace_back();
+    partition(0, 0, static_cast<uint32_t>(count));
+    computeBox(0);
+
+    agentEntry.resize(count);
+    for (size_t e = 0; e < count; ++e) {
+        agentEntry[entries[e].agentId] = static_cast<uint32_t>(e);
+    }
+    moved.assign(count, 0);
+    movedAgents.clear();
+    staleQueries = 0;
+    built = true;
+}
+
+void DecisionIndex::partition(uint32_t nodeIndex, uint32_t begin, uint32_t end) const {
+    nodes[nodeIndex].begin = begin;
+    nodes[nodeIndex].end = end;
+    nodes[nodeIndex].left = 0;
+    if (end - begin <= LEAF_SIZE) {
+        return;
+    }
+
+    // 按均匀抽取的最多 SPLIT_SAMPLE 个代理估计各维度的跨度，在跨度最大的维度上按中位数切分
+    uint32_t step = std::max<uint32_t>(1, (end - begin) / SPLIT_SAMPLE);
+    std::array<double, DIMENSIONS> low;
+    std::array<double, DIMENSIONS> high;
+    low.fill(std::numeric_limits<double>::infinity());
+    high.fill(-std::numeric_limits<double>::infinity());
+    for (uint32_t e = begin; e < end; e += step) {
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            low[d] = std::min(low[d], entries[e].values[d]);
+            high[d] = std::max(high[d], entries[e].values[d]);
+        }
+    }
+    int splitDimension = 0;
+    for (int d = 1; d < DIMENSIONS; ++d) {
+        if (high[d] - low[d] > high[splitDimension] - low[splitDimension]) {
+            splitDimension = d;
+        }
+    }
+
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+                     [splitDimension](const Entry& a, const Entry& b) {
+                         return a.values[splitDimension] < b.values[splitDimension];
+                     });
+
+    // 子节点成对分配（递归中 nodes 可能重新分配，只保存下标）
+    uint32_t left = static_cast<uint32_t>(nodes.size());
+    nodes[nodeIndex].left = left;
+    nodes.emplace_back();
+    nodes.emplace_back();
+    partition(left, begin, middle);
+    partition(left + 1, middle, end);
+}
+
+void DecisionIndex::computeBox(uint32_t nodeIndex) const {
+    Node& node = nodes[nodeIndex];
+    if (node.left != 0) {
+        computeBox(node.left);
+        computeBox(node.left + 1);
+        const Node& left = nodes[node.left];
+        const Node& right = nodes[node.left + 1];
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            node.low[d] = std::min(left.low[d], right.low[d]);
+            node.high[d] = std::max(left.high[d], right.high[d]);
+        }
+        return;
+    }
+
+    node.low.fill(std::numeric_limits<double>::infinity());
+    node.high.fill(-std::numeric_limits<double>::infinity());
+    for (uint32_t e = node.begin; e < node.end; ++e) {
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            node.low[d] = std::min(node.low[d], entries[e].values[d]);
+            node.high[d] = std::max(node.high[d], entries[e].values[d]);
+        }
+    }
+}
+
+double DecisionIndex::distanceSquared(size_t agentId, const DecisionVector& target) const {
+    double sum = 0.0;
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        double diff = population.getValue(agentId, d) - target[d];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+double DecisionIndex::boxDistanceSquared(const Node& node, const DecisionVector& target) {
+    double sum = 0.0;
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        double gap = 0.0;
+        if (target[d] < node.low[d]) {
+            gap = node.low[d] - target[d];
+        } else if (target[d] > node.high[d]) {
+            gap = target[d] - node.high[d];
+        }
+        sum += gap * gap;
+    }
+    return sum;
+}
+
+void DecisionIndex::offer(std::vector<Match>& heap, size_t k, int agentId, double distanceSquared) {
+    if (heap.size() < k) {
+        heap.push_back(Match{agentId, distanceSquared});
+        std::push_heap(heap.begin(), heap.end(), byDistance);
+    } else if (distanceSquared < heap.front().distance) {
+        std::pop_heap(heap.begin(), heap.end(), byDistance);
+        heap.back() = Match{agentId, distanceSquared};
+        std::push_heap(heap.begin(), heap.end(), byDistance);
+    }
+}
+
+void DecisionIndex::searchNearest(uint32_t nodeIndex, const DecisionVector& target, size_t k,
+                                  std::vector<Match>& heap) const {
+    const Node& node = nodes[nodeIndex];
+    if (node.left == 0) {
+        for (uint32_t e = node.begin; e < node.end; ++e) {
+            const Entry& entry = entries[e];
+            if (entry.agentId < 0) {
+                continue;
+            }
+            double d2 = 0.0;
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                double diff = entry.values[d] - target[d];
+                d2 += diff * diff;
+            }
+            offer(heap, k, entry.agentId, d2);
+        }
+        return;
+    }
+
+    // 先访问包围盒更近的子节点；结果已满且包围盒比第k近的代理更远时整体跳过
+    uint32_t nearChild = node.left;
+    uint32_t farChild = node.left + 1;
+    double nearDistance = boxDistanceSquared(nodes[nearChild], target);
+    double farDistance = boxDistanceSquared(nodes[farChild], target);
+    if (farDistance < nearDistance) {
+        std::swap(nearChild, farChild);
+        std::swap(nearDistance, farDistance);
+    }
+    if (heap.size() < k || nearDistance < heap.front().distance) {
+        searchNearest(nearChild, target, k, heap);
+    }
+    if (heap.size() < k || farDistance < heap.front().distance) {
+        searchNearest(farChild, target, k, heap);
+    }
+}
+
+void DecisionIndex::searchRadius(uint32_t nodeIndex, const DecisionVector& target, double radiusSquared,
+                                 std::vector<Match>& result) const {
+    const Node& node = nodes[nodeIndex];
+    if (boxDistanceSquared(node, target) > radiusSquared) {
+        return;
+    }
+    if (node.left != 0) {
+        searchRadius(node.left, target, radiusSquared, result);
+        searchRadius(node.left + 1, target, radiusSquared, result);
+        return;
+    }
+    for (uint32_t e = node.begin; e < node.end; ++e) {
+        const Entry& entry = entries[e];
+        if (entry.agentId < 0) {
+            continue;
+        }
+        double d2 = 0.0;
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            double diff = entry.values[d] - target[d];
+            d2 += diff * diff;
+        }
+        if (d2 <= radiusSquared) {
+            result.push_back(Match{entry.agentId, d2});
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "AgentPopulation.h"
+#include "DecisionKernels.h"
+#include "DecisionVector.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 决策向量最近邻索引：k-d 树，每个节点保存其中代理的紧包围盒
+// 查询时先访问包围盒更近的子树，包围盒距离超出当前结果的子树整体跳过
+// 索引延迟维护：建树后代理移动只记录下标（O(1)），查询时跳过树中这些代理的旧位置，改为直接扫描它们的当前值
+// 没有树或移动的代理过多时树视为过期：先用线性扫描回答查询，
+// 过期期间的查询达到 REBUILD_AFTER_QUERIES 次才重建，只更新不查询时没有任何建树开销
+// 查询之间互斥（可从多个线程查询），但查询不能与 update() 并发
+class DecisionIndex {
+public:
+    // 叶节点最多容纳的代理数量
+    static constexpr size_t LEAF_SIZE = 32;
+
+    // 建树后移动的代理超过 1/REBUILD_DIVISOR 时树视为过期（扫描移动代理的开销接近一次线性扫描之前）
+    static constexpr size_t REBUILD_DIVISOR = 64;
+
+    // 树过期后用线性扫描回答的查询次数上限（建树开销约为几十次线性扫描）
+    static constexpr size_t REBUILD_AFTER_QUERIES = 32;
+
+    // 选择切分维度时每个节点抽取的代理数量
+    static constexpr uint32_t SPLIT_SAMPLE = 64;
+
+    // 查询结果
+    struct Match {
+        int agentId;      // 代理ID
+        double distance;  // 欧氏距离
+    };
+
+    // 构造函数（索引引用种群，种群必须比索引存活更久）
+    explicit DecisionIndex(const AgentPopulation& population);
+
+    // 丢弃现有的树（种群大小变化后调用），之后按种群当前状态重新建树
+    void rebuild();
+
+    // 某个代理的决策向量变化后更新索引（尚未建树时什么也不做）
+    void update(size_t agentId);
+
+    // 掩码中所有代理的决策向量变化后更新索引：掩码第 i 位对应代理 first + i
+    void updateMasked(size_t first, const AgentMask& mask);
+
+    // 查找距离 target 最近的 k 个代理，按距离升序
+    std::vector<Match> nearest(const DecisionVector& target, size_t k) const;
+
+    // 查找与 target 距离不超过 radius 的所有代理，按距离升序
+    std::vector<Match> withinRadius(const DecisionVector& target, double radius) const;
+
+    // 种群中的代理数量
+    size_t size() const { return population.size(); }
+
+    // 是否已经建树
+    bool isBuilt() const { return built; }
+
+    // 建树后移动过、尚未重新放入树中的代理数量
+    size_t pendingCount() const { return movedAgents.size(); }
+
+private:
+    static constexpr int DIMENSIONS = AgentPopulation::DIMENSIONS;
+
+    // 树中的一个代理：建树时的决策向量和代理ID（移动后ID置为 -1，查询时跳过）
+    struct Entry {
+        std::array<double, DIMENSIONS> values;
+        int32_t agentId;
+    };
+
+    // 树节点：entries[begin, end) 的包围盒；内部节点的两个子节点为 left 和 left + 1
+    struct Node {
+        std::array<double, DIMENSIONS> low;
+        std::array<double, DIMENSIONS> high;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t left;      // 叶节点为 0
+    };
+
+    const AgentPopulation& population;
+
+    // 延迟建树的状态（查询时可能重建，因此为 mutable）
+    mutable std::mutex queryMutex;
+    mutable bool built = false;
+    mutable std::vector<Entry> entries;          // 按叶节点顺序排列
+    mutable std::vector<Node> nodes;             // nodes[0] 为根
+    mutable std::vector<uint32_t> agentEntry;    // 代理在 entries 中的位置
+    mutable std::vector<uint8_t> moved;          // 建树后是否移动过
+    mutable std::vector<uint32_t> movedAgents;   // 建树后移动过的代理
+    mutable size_t staleQueries = 0;             // 树过期后已用线性扫描回答的查询次数
+
+    // 树是否可用于本次查询；树过期且线性扫描已回答足够多的查询时重建。调用方持有 queryMutex
+    bool prepareTree() const;
+    void build() const;
+    void partition(uint32_t nodeIndex, uint32_t begin, uint32_t end) const;
+    void computeBox(uint32_t nodeIndex) const;
+
+    // 代理当前的决策向量与 target 的距离平方
+    double distanceSquared(size_t agentId, const DecisionVector& target) const;
+
+    // target 到节点包围盒的最小距离平方
+    static double boxDistanceSquared(const Node& node, const DecisionVector& target);
+
+    // 把一个候选加入大小为 k 的大顶堆（distance 暂存距离平方）
+    static void offer(std::vector<Match>& heap, size_t k, int agentId, double distanceSquared);
+
+    void searchNearest(uint32_t nodeIndex, const DecisionVector& target, size_t k, std::vector<Match>& heap) const;
+    void searchRadius(uint32_t nodeIndex, const DecisionVector& target, double radiusSquared, std::vector<Match>& result) const;
+};
@@ -0,0 +1,173 @@
+// 最近邻索引基准测试：比较 DecisionIndex 与暴力扫描（逐个计算距离 + partial_sort）的 k-NN 查询耗时，
+// 以及建树、代理移动后的更新和带未重建移动的查询开销；同时校验两者的结果一致
+// 用法: decision_index_benchmark [代理数量] [查询次数] [k]
+#include "AgentPopulation.h"
+#include "CounterRng.h"
+#include "DecisionIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // 暴力扫描：按维度顺序累加距离平方，再取最近的 k 个
+    std::vector<DecisionIndex::Match> bruteForce(const AgentPopulation& population, const DecisionVector& target, size_t k) {
+        std::vector<double> distances(population.size(), 0.0);
+        for (int d = 0; d < AgentPopulation::DIMENSIONS; ++d) {
+            const double* values = population.dimensionData(d);
+            for (size_t i = 0; i < population.size(); ++i) {
+                double diff = values[i] - target[d];
+                distances[i] += diff * diff;
+            }
+        }
+        std::vector<DecisionIndex::Match> matches(population.size());
+        for (size_t i = 0; i < population.size(); ++i) {
+            matches[i] = DecisionIndex::Match{static_cast<int>(i), distances[i]};
+        }
+        k = std::min(k, matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + k, matches.end(),
+                          [](const DecisionIndex::Match& a, const DecisionIndex::Match& b) { return a.distance < b.distance; });
+        matches.resize(k);
+        for (auto& match : matches) {
+            match.distance = std::sqrt(match.distance);
+        }
+        return matches;
+    }
+
+    // 距离序列相同即视为一致（距离相同的代理可能以不同顺序出现）
+    bool sameDistances(const std::vector<DecisionIndex::Match>& a, const std::vector<DecisionIndex::Match>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (std::abs(a[i].distance - b[i].distance) > 1e-12) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    DecisionVector randomTarget(CounterRng& rng) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        DecisionVector target;
+        for (int d = 0; d < DecisionVector::DIMENSIONS; ++d) {
+            target[d] = dist(rng);
+        }
+        return target;
+    }
+
+    void report(const char* name, double totalMs, size_t count, const char* unit) {
+        std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << totalMs / static_cast<double>(count) << " ms/" << unit << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t agentCount = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 1000000;
+    size_t queryCount = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 20;
+    size_t k = argc > 3 ? static_cast<size_t>(std::max(1, std::atoi(argv[3]))) : 10;
+
+    CounterRng::setGlobalSeed(42);
+    AgentPopulation population(agentCount);
+    DecisionIndex index(population);
+    CounterRng rng(42, CounterRng::STREAM_ENVIRONMENT, 0);
+
+    std::vector<DecisionVector> targets;
+    for (size_t q = 0; q < queryCount; ++q) {
+        targets.push_back(randomTarget(rng));
+    }
+
+    std::cout << "代理数量: " << agentCount << "，查询次数: " << queryCount << "，k = " << k << std::endl;
+    size_t mismatches = 0;
+
+    auto start = Clock::now();
+    std::vector<std::vector<DecisionIndex::Match>> expected;
+    for (const auto& target : targets) {
+        expected.push_back(bruteForce(population, target, k));
+    }
+    report("暴力扫描 + partial_sort", elapsedMs(start), queryCount, "查询");
+
+    // 建树前的查询由线性扫描回答，过期查询达到上限的那次查询负责建树
+    size_t staleQueries = 0;
+    double staleMs = 0.0;
+    while (!index.isBuilt()) {
+        start = Clock::now();
+        if (!sameDistances(index.nearest(targets[staleQueries % queryCount], k), expected[staleQueries % queryCount])) {
+            ++mismatches;
+        }
+        double ms = elapsedMs(start);
+        if (index.isBuilt()) {
+            report("建树（含一次查询）", ms, 1, "次");
+        } else {
+            staleQueries++;
+            staleMs += ms;
+        }
+    }
+    if (staleQueries > 0) {
+        report("建树前的查询（线性扫描）", staleMs, staleQueries, "查询");
+    }
+
+    start = Clock::now();
+    for (size_t q = 0; q < queryCount; ++q) {
+        if (!sameDistances(index.nearest(targets[q], k), expected[q])) {
+            ++mismatches;
+        }
+    }
+    report("DecisionIndex k-NN", elapsedMs(start), queryCount, "查询");
+
+    // 半径查询：取略大于第k近的距离作为半径（避免开方后再平方的舍入误差），结果的前k个应与 k-NN 相同
+    start = Clock::now();
+    for (size_t q = 0; q < queryCount; ++q) {
+        double radius = expected[q].empty() ? 0.0 : expected[q].back().distance * (1.0 + 1e-9);
+        std::vector<DecisionIndex::Match> within = index.withinRadius(targets[q], radius);
+        within.resize(std::min(within.size(), expected[q].size()));
+        if (!sameDistances(within, expected[q])) {
+            ++mismatches;
+        }
+    }
+    report("DecisionIndex 半径查询", elapsedMs(start), queryCount, "查询");
+
+    // 移动 1/64 的代理（不超过重建阈值），测量更新开销和查询时扫描移动代理的开销
+    size_t movedCount = agentCount / 64;
+    std::uniform_int_distribution<size_t> pickAgent(0, agentCount - 1);
+    std::uniform_real_distribution<double> delta(-0.05, 0.05);
+    std::vector<size_t> movedAgents;
+    for (size_t i = 0; i < movedCount; ++i) {
+        size_t agentId = pickAgent(rng);
+        for (int d = 0; d < AgentPopulation::DIMENSIONS; ++d) {
+            population.setValue(agentId, d, std::clamp(population.getValue(agentId, d) + delta(rng), 0.0, 1.0));
+        }
+        movedAgents.push_back(agentId);
+    }
+    start = Clock::now();
+    for (size_t agentId : movedAgents) {
+        index.update(agentId);
+    }
+    report("update（每1000个代理）", elapsedMs(start) * 1000.0, std::max<size_t>(1, movedCount), "1000个");
+
+    expected.clear();
+    for (const auto& target : targets) {
+        expected.push_back(bruteForce(population, target, k));
+    }
+    start = Clock::now();
+    for (size_t q = 0; q < queryCount; ++q) {
+        if (!sameDistances(index.nearest(targets[q], k), expected[q])) {
+            ++mismatches;
+        }
+    }
+    report("k-NN（1/64 代理已移动）", elapsedMs(start), queryCount, "查询");
+    std::cout << "待重建的移动代理: " << index.pendingCount() << std::endl;
+
+    std::cout << (mismatches == 0 ? "结果与暴力扫描一致" : "结果与暴力扫描不一致: ")
+              << (mismatches == 0 ? std::string() : std::to_string(mismatches) + " 次查询") << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
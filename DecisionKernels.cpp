@@ -0,0 +1,230 @@
+#include "DecisionKernels.h"
+#include "SimdSupport.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+    constexpr int DIMENSIONS = DecisionVector::DIMENSIONS;
+    constexpr size_t WORD_BITS = 64;
+
+    // 与 BioAgent::updateDecisionVector 的 std::max(0.0, std::min(1.0, value)) 逐位一致
+    // SIMD 实现中 min/max 的操作数顺序与之对应：任一操作数为 NaN 时返回第二个操作数，
+    // 因此 NaN 被限制为1.0，-0.0 被替换为0.0
+    inline double clampUnit(double value) {
+        return std::max(0.0, std::min(1.0, value));
+    }
+
+    // 对一个维度的连续数组 [first, last) 加上 delta 并限制在0.0-1.0范围内
+    void addClamped(double* values, size_t first, size_t last, double delta) {
+        size_t i = first;
+#if defined(AMPH_SIMD_AVX2)
+        const __m256d vDelta = _mm256_set1_pd(delta);
+        const __m256d vZero = _mm256_setzero_pd();
+        const __m256d vOne = _mm256_set1_pd(1.0);
+        for (; i + 4 <= last; i += 4) {
+            __m256d v = _mm256_add_pd(_mm256_loadu_pd(values + i), vDelta);
+            _mm256_storeu_pd(values + i, _mm256_max_pd(_mm256_min_pd(v, vOne), vZero));
+        }
+#elif defined(AMPH_SIMD_SSE2)
+        const __m128d vDelta = _mm_set1_pd(delta);
+        const __m128d vZero = _mm_setzero_pd();
+        const __m128d vOne = _mm_set1_pd(1.0);
+        for (; i + 2 <= last; i += 2) {
+            __m128d v = _mm_add_pd(_mm_loadu_pd(values + i), vDelta);
+            _mm_storeu_pd(values + i, _mm_max_pd(_mm_min_pd(v, vOne), vZero));
+        }
+#endif
+        for (; i < last; ++i) {
+            values[i] = clampUnit(values[i] + delta);
+        }
+    }
+
+    // 对一个64代理块中被选中的代理加上 delta（标量实现，逐个处理置位的位）
+    void addClampedBits(double* values, size_t base, uint64_t word, double delta) {
+        while (word != 0) {
+            size_t bit = static_cast<size_t>(std::countr_zero(word));
+            values[base + bit] = clampUnit(values[base + bit] + delta);
+            word &= word - 1;
+        }
+    }
+
+    // 对一个完整的64代理块中被选中的代理加上 delta（调用方保证 base + 64 不越界）
+    void addClampedWord(double* values, size_t base, uint64_t word, double delta) {
+#if defined(AMPH_SIMD_AVX2)
+        const __m256d vDelta = _mm256_set1_pd(delta);
+        const __m256d vZero = _mm256_setzero_pd();
+        const __m256d vOne = _mm256_set1_pd(1.0);
+        for (size_t j = 0; j < WORD_BITS; j += 4) {
+            unsigned lanes = static_cast<unsigned>((word >> j) & 0xF);
+            if (lanes == 0) {
+                continue;
+            }
+            double* p = values + base + j;
+            __m256d old = _mm256_loadu_pd(p);
+            __m256d updated = _mm256_max_pd(_mm256_min_pd(_mm256_add_pd(old, vDelta), vOne), vZero);
+            if (lanes != 0xF) {
+                // 未选中的通道保留原值
+                __m256d select = _mm256_castsi256_pd(_mm256_set_epi64x(
+                    -static_cast<long long>((lanes >> 3) & 1), -static_cast<long long>((lanes >> 2) & 1),
+                    -static_cast<long long>((lanes >> 1) & 1), -static_cast<long long>(lanes & 1)));
+                updated = _mm256_blendv_pd(old, updated, select);
+            }
+            _mm256_storeu_pd(p, updated);
+        }
+#elif defined(AMPH_SIMD_SSE2)
+        const __m128d vDelta = _mm_set1_pd(delta);
+        const __m128d vZero = _mm_setzero_pd();
+        const __m128d vOne = _mm_set1_pd(1.0);
+        for (size_t j = 0; j < WORD_BITS; j += 2) {
+            unsigned lanes = static_cast<unsigned>((word >> j) & 0x3);
+            if (lanes == 0) {
+                continue;
+            }
+            double* p = values + base + j;
+            __m128d old = _mm_loadu_pd(p);
+            __m128d updated = _mm_max_pd(_mm_min_pd(_mm_add_pd(old, vDelta), vOne), vZero);
+            if (lanes != 0x3) {
+                // 未选中的通道保留原值
+                __m128d select = _mm_castsi128_pd(_mm_set_epi64x(
+                    -static_cast<long long>((lanes >> 1) & 1), -static_cast<long long>(lanes & 1)));
+                updated = _mm_or_pd(_mm_and_pd(select, updated), _mm_andnot_pd(select, old));
+            }
+            _mm_storeu_pd(p, updated);
+        }
+#else
+        addClampedBits(values, base, word, delta);
+#endif
+    }
+
+    // 检查一个完整的64代理块是否满足要求，返回满足要求的代理位（调用方保证 base + 64 不越界）
+    uint64_t matchWord(const AgentPopulation& population, size_t base, const DecisionVector& requirement) {
+        uint64_t word = ~0ULL;
+        for (int d = 0; d < DIMENSIONS && word != 0; ++d) {
+            const double* values = population.dimensionData(d) + base;
+            uint64_t bits = 0;
+#if defined(AMPH_SIMD_AVX2)
+            // 使用 !(value < requirement)，与标量实现对 NaN 的处理保持一致
+            const __m256d vRequirement = _mm256_set1_pd(requirement[d]);
+            for (size_t j = 0; j < WORD_BITS; j += 4) {
+                __m256d cmp = _mm256_cmp_pd(_mm256_loadu_pd(values + j), vRequirement, _CMP_NLT_UQ);
+                bits |= static_cast<uint64_t>(_mm256_movemask_pd(cmp)) << j;
+            }
+#elif defined(AMPH_SIMD_SSE2)
+            const __m128d vRequirement = _mm_set1_pd(requirement[d]);
+            for (size_t j = 0; j < WORD_BITS; j += 2) {
+                __m128d cmp = _mm_cmpnlt_pd(_mm_loadu_pd(values + j), vRequirement);
+                bits |= static_cast<uint64_t>(_mm_movemask_pd(cmp)) << j;
+            }
+#else
+            for (size_t j = 0; j < WORD_BITS; ++j) {
+                if (!(values[j] < requirement[d])) {
+                    bits |= 1ULL << j;
+                }
+            }
+#endif
+            word &= bits;
+        }
+        return word;
+    }
+
+    // 标量检查 [first, last) 范围内的代理，返回相对 base 的代理位
+    uint64_t matchRange(const AgentPopulation& population, size_t base, size_t first, size_t last,
+                        const DecisionVector& requirement) {
+        uint64_t word = 0;
+        for (size_t i = first; i < last; ++i) {
+            bool requirementMet = true;
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                if (population.getValue(i, d) < requirement[d]) {
+                    requirementMet = false;
+                    break;
+                }
+            }
+            if (requirementMet) {
+                word |= 1ULL << (i - base);
+            }
+        }
+        return word;
+    }
+}
+
+const char* DecisionKernels::getInstructionSet() {
+#if defined(AMPH_SIMD_AVX2)
+    return "AVX2";
+#elif defined(AMPH_SIMD_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+AgentMask DecisionKernels::createMask(size_t agentCount) {
+    return AgentMask((agentCount + WORD_BITS - 1) / WORD_BITS, 0);
+}
+
+size_t DecisionKernels::countMask(const AgentMask& mask) {
+    size_t total = 0;
+    for (uint64_t word : mask) {
+        total += static_cast<size_t>(std::popcount(word));
+    }
+    return total;
+}
+
+void DecisionKernels::applyFeedback(AgentPopulation& population, size_t first, size_t count,
+                                    const DecisionVector& feedback) {
+    if (first >= population.size()) {
+        return;
+    }
+    size_t last = first + std::min(count, population.size() - first);
+
+    // 逐维度顺序扫描，每次只访问一段连续数组
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        addClamped(population.dimensionData(d), first, last, feedback[d]);
+    }
+}
+
+void DecisionKernels::applyFeedbackMasked(AgentPopulation& population, size_t first, const AgentMask& mask,
+                                          const DecisionVector& feedback) {
+    if (first >= population.size()) {
+        return;
+    }
+    size_t available = population.size() - first;
+    size_t wordCount = std::min(mask.size(), (available + WORD_BITS - 1) / WORD_BITS);
+    // 最后一个块不足64个代理时不能整块加载
+    size_t fullWords = available / WORD_BITS;
+
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        double* values = population.dimensionData(d);
+        for (size_t w = 0; w < wordCount; ++w) {
+            uint64_t word = mask[w];
+            if (word == 0) {
+                continue;
+            }
+            size_t base = first + w * WORD_BITS;
+            if (w < fullWords) {
+                addClampedWord(values, base, word, feedback[d]);
+            } else {
+                // 忽略超出种群范围的位
+                size_t valid = population.size() - base;
+                addClampedBits(values, base, word & ((1ULL << valid) - 1), feedback[d]);
+            }
+        }
+    }
+}
+
+void DecisionKernels::checkRequirement(const AgentPopulation& population, size_t first, size_t count,
+                                       const DecisionVector& requirement, AgentMask& result) {
+    result = createMask(count);
+    if (first >= population.size()) {
+        return;
+    }
+    size_t last = first + std::min(count, population.size() - first);
+
+    for (size_t w = 0; first + w * WORD_BITS < last; ++w) {
+        size_t base = first + w * WORD_BITS;
+        if (base + WORD_BITS <= last) {
+            result[w] = matchWord(population, base, requirement);
+        } else {
+            result[w] = matchRange(population, base, base, last, requirement);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "AgentPopulation.h"
+#include "DecisionVector.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 代理位掩码：覆盖从代理 first 开始的一段连续代理，第 i 个 uint64_t 的第 j 位对应代理 first + i * 64 + j
+// first 由使用掩码的调用方一并传递；掩码大小只与这段代理的数量有关，与种群大小无关
+using AgentMask = std::vector<uint64_t>;
+
+// 决策向量批量计算内核
+// 直接在 AgentPopulation 的按维度连续数组上运行，一次处理一批代理
+// 编译时按可用指令集选择 AVX2 / SSE2 实现，否则使用标量实现
+class DecisionKernels {
+public:
+    // 当前编译使用的指令集名称（"AVX2"、"SSE2" 或 "scalar"）
+    static const char* getInstructionSet();
+
+    // 创建能容纳 agentCount 个代理的空掩码
+    static AgentMask createMask(size_t agentCount);
+
+    // 统计掩码中被选中的代理数量
+    static size_t countMask(const AgentMask& mask);
+
+    // 对 [first, first + count) 范围内的代理应用同一个反馈向量
+    // 结果限制在0.0-1.0范围内（与 BioAgent::updateDecisionVector 一致）
+    static void applyFeedback(AgentPopulation& population, size_t first, size_t count,
+                              const DecisionVector& feedback);
+
+    // 对掩码中选中的代理应用同一个反馈向量（掩码第 i 位对应代理 first + i）
+    static void applyFeedbackMasked(AgentPopulation& population, size_t first, const AgentMask& mask,
+                                    const DecisionVector& feedback);
+
+    // 检查 [first, first + count) 范围内的代理是否满足决策要求（每个维度 >= 要求值）
+    // result 被重置为 createMask(count)，满足要求的代理对应位被置1（第 i 位对应代理 first + i）
+    static void checkRequirement(const AgentPopulation& population, size_t first, size_t count,
+                                 const DecisionVector& requirement, AgentMask& result);
+};
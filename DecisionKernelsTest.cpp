@@ -0,0 +1,182 @@
+// 决策向量批量内核测试：applyFeedback、applyFeedbackMasked 和 checkRequirement 与逐个代理调用
+// BioAgent::updateDecisionVector / checkDecisionRequirement 的标量结果逐位比较
+// 代理范围从非零的 first 开始，种群大小不是64的整数倍（最后一个掩码字不完整），
+// 决策值和反馈包含0、1边界值以及 -0.0、NaN、无穷大；失败时输出原因并返回非零
+#include "DecisionKernels.h"
+#include "AgentPopulation.h"
+#include "BioAgent.h"
+#include "CounterRng.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int DIMENSIONS = DecisionVector::DIMENSIONS;
+    constexpr size_t AGENT_COUNT = 300;  // 4 个完整的64代理块加44个代理
+
+    int failures = 0;
+
+    void expect(bool condition, const std::string& message) {
+        if (!condition) {
+            ++failures;
+            std::cout << "失败: " << message << std::endl;
+        }
+    }
+
+    // 特殊值：边界值、边界附近的值、-0.0、NaN 和无穷大
+    const double SPECIAL_VALUES[] = {
+        0.0, 1.0, -0.0, 0.5, 1.0 - 1e-16, 1e-300, -1e-300,
+        std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+    };
+    constexpr size_t SPECIAL_COUNT = sizeof(SPECIAL_VALUES) / sizeof(SPECIAL_VALUES[0]);
+
+    // 随机决策值，每隔几个代理放入一个特殊值
+    AgentPopulation buildPopulation() {
+        AgentPopulation population(AGENT_COUNT);
+        CounterRng rng(1234, 1, 0);
+        for (size_t i = 0; i < AGENT_COUNT; ++i) {
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                double value = rng.nextDouble();
+                if ((i + d) % 5 == 0) {
+                    value = SPECIAL_VALUES[(i * 7 + d) % SPECIAL_COUNT];
+                }
+                population.setValue(i, d, value);
+            }
+        }
+        return population;
+    }
+
+    // 反馈向量：包含把值推过0和1的增量、零增量和 NaN
+    DecisionVector buildFeedback(uint64_t stream) {
+        DecisionVector feedback;
+        CounterRng rng(1234, stream, 0);
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            feedback[d] = rng.nextDouble() * 2.0 - 1.0;
+        }
+        feedback[0] = 1.0;
+        feedback[1] = -1.0;
+        feedback[2] = 0.0;
+        feedback[3] = -0.0;
+        feedback[4] = 1e-16;
+        feedback[5] = std::numeric_limits<double>::quiet_NaN();
+        return feedback;
+    }
+
+    // 两个种群的决策值逐位相同（NaN 也按位比较）
+    void expectSameBits(const AgentPopulation& actual, const AgentPopulation& expected, const std::string& name) {
+        size_t mismatches = 0;
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            for (size_t i = 0; i < AGENT_COUNT; ++i) {
+                if (std::bit_cast<uint64_t>(actual.getValue(i, d)) != std::bit_cast<uint64_t>(expected.getValue(i, d))) {
+                    ++mismatches;
+                }
+            }
+        }
+        expect(mismatches == 0, name + ": " + std::to_string(mismatches) + " 个值与标量计算不一致");
+    }
+
+    void testApplyFeedback(size_t first, size_t count) {
+        std::string name = "applyFeedback(" + std::to_string(first) + ", " + std::to_string(count) + ")";
+        DecisionVector feedback = buildFeedback(2);
+        AgentPopulation actual = buildPopulation();
+        AgentPopulation expected = actual;
+
+        DecisionKernels::applyFeedback(actual, first, count, feedback);
+        for (size_t i = first; i < first + count && i < AGENT_COUNT; ++i) {
+            expected[i].updateDecisionVector(feedback);
+        }
+        expectSameBits(actual, expected, name);
+    }
+
+    void testApplyFeedbackMasked(size_t first, size_t count) {
+        std::string name = "applyFeedbackMasked(" + std::to_string(first) + ", " + std::to_string(count) + ")";
+        DecisionVector feedback = buildFeedback(3);
+        AgentPopulation actual = buildPopulation();
+        AgentPopulation expected = actual;
+
+        // 随机选择代理；最后一个掩码字中超出种群的位也置1，内核必须忽略
+        AgentMask mask = DecisionKernels::createMask(count);
+        CounterRng rng(1234, 4, first);
+        for (uint64_t& word : mask) {
+            word = rng();
+        }
+        mask.back() |= ~0ULL << ((AGENT_COUNT - first) % 64);
+        mask.front() |= 0xFULL;  // 第一个块中包含连续选中的通道
+
+        DecisionKernels::applyFeedbackMasked(actual, first, mask, feedback);
+        for (size_t i = first; i < AGENT_COUNT; ++i) {
+            size_t bit = i - first;
+            if (bit / 64 < mask.size() && (mask[bit / 64] >> (bit % 64)) & 1) {
+                expected[i].updateDecisionVector(feedback);
+            }
+        }
+        expectSameBits(actual, expected, name);
+    }
+
+    void testCheckRequirement(size_t first, size_t count) {
+        std::string name = "checkRequirement(" + std::to_string(first) + ", " + std::to_string(count) + ")";
+        AgentPopulation population = buildPopulation();
+
+        // 要求值取0、1边界和随机值；把一部分代理的决策值设为恰好等于要求值
+        DecisionVector requirement;
+        CounterRng rng(1234, 5, 0);
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            requirement[d] = rng.nextDouble() * 0.2;
+        }
+        requirement[0] = 0.0;
+        requirement[1] = -0.0;
+        requirement[2] = 1e-300;
+        for (size_t i = 0; i < AGENT_COUNT; i += 3) {
+            for (int d = 0; d < DIMENSIONS; ++d) {
+                if (population.getValue(i, d) < requirement[d]) {
+                    population.setValue(i, d, requirement[d]);
+                }
+            }
+        }
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            population.setValue(first, d, 1.0);  // 范围内第一个代理满足要求
+        }
+
+        AgentMask result;
+        DecisionKernels::checkRequirement(population, first, count, requirement, result);
+        expect(result.size() == DecisionKernels::createMask(count).size(), name + ": 掩码大小错误");
+        if (result.size() != DecisionKernels::createMask(count).size()) {
+            return;
+        }
+
+        size_t mismatches = 0;
+        size_t matched = 0;
+        for (size_t bit = 0; bit < result.size() * 64; ++bit) {
+            bool actual = (result[bit / 64] >> (bit % 64)) & 1;
+            size_t i = first + bit;
+            bool expected = bit < count && i < AGENT_COUNT && population[i].checkDecisionRequirement(requirement);
+            mismatches += actual != expected;
+            matched += expected;
+        }
+        expect(mismatches == 0, name + ": " + std::to_string(mismatches) + " 个代理与标量计算不一致");
+        expect(matched > 0 && matched < std::min(count, AGENT_COUNT - first), name + ": 测试数据没有同时包含满足和不满足要求的代理");
+    }
+}
+
+int main() {
+    // 范围从非零的 first 开始：37 使64代理块与数组的4/2元素对齐错开，
+    // 300 - 37 = 263 个代理时最后一个掩码字只有7个有效位；超出种群的范围被截断
+    for (size_t first : {37u, 64u, 1u}) {
+        for (size_t count : {AGENT_COUNT - first, static_cast<size_t>(130), AGENT_COUNT}) {
+            testApplyFeedback(first, count);
+            testApplyFeedbackMasked(first, count);
+            testCheckRequirement(first, count);
+        }
+    }
+
+    if (failures == 0) {
+        std::cout << "DecisionKernels（" << DecisionKernels::getInstructionSet() << "）: 全部通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
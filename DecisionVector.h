@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+
+// 12维决策向量的值类型：固定长度、内联存储，不做任何堆分配
+// 按32字节对齐，便于SIMD整体加载
+struct alignas(32) DecisionVector {
+    // 决策向量维度
+    static constexpr int DIMENSIONS = 12;
+
+    // 各维度的值，顺序与 BioAgent::DecisionVectorDimension 一致
+    std::array<double, DIMENSIONS> values;
+
+    // 构造函数：所有维度为0
+    DecisionVector() { values.fill(0.0); }
+
+    // 构造函数：所有维度填充为同一个值
+    explicit DecisionVector(double fillValue) { values.fill(fillValue); }
+
+    // 构造函数：按顺序填充，不足12个的维度补0，多余的值被忽略
+    DecisionVector(std::initializer_list<double> init) {
+        values.fill(0.0);
+        size_t i = 0;
+        for (double value : init) {
+            if (i >= values.size()) {
+                break;
+            }
+            values[i++] = value;
+        }
+    }
+
+    // 元素访问
+    double& operator[](size_t index) { return values[index]; }
+    const double& operator[](size_t index) const { return values[index]; }
+
+    // 维度数量（始终为12）
+    static constexpr size_t size() { return DIMENSIONS; }
+
+    // 连续数据指针
+    double* data() { return values.data(); }
+    const double* data() const { return values.data(); }
+
+    // 迭代器
+    double* begin() { return values.data(); }
+    double* end() { return values.data() + DIMENSIONS; }
+    const double* begin() const { return values.data(); }
+    const double* end() const { return values.data() + DIMENSIONS; }
+
+    // 所有维度填充为同一个值
+    void fill(double value) { values.fill(value); }
+
+    bool operator==(const DecisionVector& other) const { return values == other.values; }
+    bool operator!=(const DecisionVector& other) const { return values != other.values; }
+};
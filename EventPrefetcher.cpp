@@ -0,0 +1,111 @@
+#include "EventPrefetcher.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    // 请求失败后的退避时间：1秒起，每次翻倍，最多32秒
+    std::chrono::seconds failureBackoff(unsigned consecutiveFailures) {
+        unsigned shift = std::min(consecutiveFailures, 6u) - 1;
+        return std::chrono::seconds(1u << shift);
+    }
+}
+
+EventPrefetcher::~EventPrefetcher() {
+    stop();
+}
+
+void EventPrefetcher::start(size_t depth, unsigned concurrency) {
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->depth = std::max<size_t>(1, depth);
+        stopping = false;
+    }
+    stopSignal->reset();
+
+    concurrency = std::max(1u, concurrency);
+    workers.reserve(concurrency);
+    for (unsigned i = 0; i < concurrency; ++i) {
+        workers.emplace_back(&EventPrefetcher::producerLoop, this);
+    }
+}
+
+void EventPrefetcher::stop() {
+    if (workers.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeProducers.notify_all();
+    // 中止阻塞在网络读写或重试退避中的请求，join 不必等待它们超时
+    stopSignal->requestStop();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+bool EventPrefetcher::tryPop(LLMClient::EventHandle& event) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) {
+            ++missCount;
+            return false;
+        }
+        event = std::move(queue.front());
+        queue.pop_front();
+    }
+    ++hitCount;
+
+    // 队列有空位了，唤醒后台线程补充（退避中的线程会继续等待）
+    wakeProducers.notify_all();
+    return true;
+}
+
+size_t EventPrefetcher::readyCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
+
+void EventPrefetcher::producerLoop() {
+    unsigned consecutiveFailures = 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // 已就绪和正在请求的事件总数达到队列深度时等待
+        wakeProducers.wait(lock, [this]() { return stopping || queue.size() + inFlight < depth; });
+        if (stopping) {
+            return;
+        }
+
+        ++inFlight;
+        lock.unlock();
+
+        LLMClient::EventHandle event;
+        bool generated = LLMClient::getInstance().tryGenerateRandomEvent(event, stopSignal);
+
+        lock.lock();
+        --inFlight;
+        if (generated) {
+            queue.push_back(std::move(event));
+            consecutiveFailures = 0;
+            continue;
+        }
+        if (stopping) {
+            // 被停止信号中止的请求不计为失败
+            return;
+        }
+
+        // 失败后退避，避免在服务不可用时持续请求
+        ++failureCount;
+        ++consecutiveFailures;
+        if (wakeProducers.wait_for(lock, failureBackoff(consecutiveFailures), [this]() { return stopping; })) {
+            return;
+        }
+    }
+}
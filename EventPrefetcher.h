@@ -0,0 +1,69 @@
+#pragma once
+
+#include "LLMClient.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// LLM事件预取器
+// 后台线程持续通过 LLMClient::tryGenerateRandomEvent 生成事件，保存在有界队列中
+// 模拟循环只调用 tryPop 取事件，从不等待网络；队列为空时由调用方回退到保存的事件或模拟事件
+class EventPrefetcher {
+public:
+    // 默认队列深度（已就绪 + 正在请求的事件总数上限）
+    static constexpr size_t DEFAULT_DEPTH = 8;
+
+    // 默认并发请求数（后台线程数）
+    static constexpr unsigned DEFAULT_CONCURRENCY = 1;
+
+    EventPrefetcher() = default;
+    ~EventPrefetcher();
+
+    EventPrefetcher(const EventPrefetcher&) = delete;
+    EventPrefetcher& operator=(const EventPrefetcher&) = delete;
+
+    // 启动 concurrency 个后台线程，队列中最多保持 depth 个事件（已在运行时先停止）
+    void start(size_t depth = DEFAULT_DEPTH, unsigned concurrency = DEFAULT_CONCURRENCY);
+
+    // 停止后台线程：正在进行的请求立即中止（不再重试），然后等待线程退出
+    void stop();
+
+    // 是否正在运行
+    bool isRunning() const { return !workers.empty(); }
+
+    // 取出一个已就绪的事件（非阻塞），队列为空时返回 false
+    bool tryPop(LLMClient::EventHandle& event);
+
+    // 当前已就绪的事件数量
+    size_t readyCount() const;
+
+    // 统计：tryPop 成功/失败次数，后台请求失败次数
+    uint64_t getHitCount() const { return hitCount; }
+    uint64_t getMissCount() const { return missCount; }
+    uint64_t getFailureCount() const { return failureCount; }
+
+private:
+    // 后台线程主循环
+    void producerLoop();
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeProducers;
+    std::deque<LLMClient::EventHandle> queue;
+    std::vector<std::thread> workers;
+    // 后台请求共用的停止信号（对冲请求的后台线程可能晚于预取器结束，因此共享所有权）
+    std::shared_ptr<HttpStopSignal> stopSignal = std::make_shared<HttpStopSignal>();
+
+    size_t depth = DEFAULT_DEPTH;
+    size_t inFlight = 0;      // 正在请求中的事件数量
+    bool stopping = false;
+
+    std::atomic<uint64_t> hitCount{0};
+    std::atomic<uint64_t> missCount{0};
+    std::atomic<uint64_t> failureCount{0};
+};
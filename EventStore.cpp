@@ -0,0 +1,544 @@
+#include "EventStore.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // 文件头：8字节标识 + 版本 + 保留
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    constexpr char DATA_MAGIC[8] = {'A', 'M', 'P', 'H', 'E', 'V', 'T', '1'};
+    constexpr char INDEX_MAGIC[8] = {'A', 'M', 'P', 'H', 'I', 'D', 'X', '1'};
+    constexpr uint32_t FORMAT_VERSION = 1;
+
+    // 记录头，其后依次是 optionCount 个 OptionRecord、名称、描述、每个选项的文本和结果文本
+    struct RecordHeader {
+        uint32_t marker;            // RECORD_MARKER
+        uint32_t size;              // 整条记录的字节数（含记录头）
+        uint64_t contentHash;       // 事件内容哈希
+        uint32_t checksum;          // 记录头之后所有字节的 FNV-1a 校验和
+        uint16_t optionCount;
+        uint16_t reserved;
+        uint32_t nameLength;
+        uint32_t descriptionLength;
+    };
+
+    struct OptionRecord {
+        double decisionRequirement[DecisionVector::DIMENSIONS];
+        double decisionFeedback[DecisionVector::DIMENSIONS];
+        uint32_t textLength;
+        uint32_t outcomeLength;
+    };
+
+    struct IndexRecord {
+        uint64_t offset;
+        uint64_t contentHash;
+    };
+
+    constexpr uint32_t RECORD_MARKER = 0x31545645;  // "EVT1"
+
+    // 单条记录的大小上限（防止损坏的长度字段导致巨大的内存分配）
+    constexpr uint32_t MAX_RECORD_SIZE = 64u << 20;
+
+    uint32_t checksum32(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void hashBytes(uint64_t& hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    void hashString(uint64_t& hash, const std::string& text) {
+        uint64_t length = text.size();
+        hashBytes(hash, &length, sizeof(length));
+        hashBytes(hash, text.data(), text.size());
+    }
+
+    void appendBytes(std::string& out, const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    // 把事件编码为一条完整的记录
+    void encodeRecord(const LLMClient::RandomEvent& event, uint64_t contentHash, std::string& record) {
+        RecordHeader header{};
+        header.marker = RECORD_MARKER;
+        header.contentHash = contentHash;
+        header.optionCount = static_cast<uint16_t>(event.options.size());
+        header.nameLength = static_cast<uint32_t>(event.name.size());
+        header.descriptionLength = static_cast<uint32_t>(event.description.size());
+
+        record.clear();
+        record.resize(sizeof(RecordHeader));
+        for (const auto& option : event.options) {
+            OptionRecord optionRecord{};
+            for (size_t d = 0; d < DecisionVector::DIMENSIONS; ++d) {
+                optionRecord.decisionRequirement[d] = option.decisionRequirement[d];
+                optionRecord.decisionFeedback[d] = option.decisionFeedback[d];
+            }
+            optionRecord.textLength = static_cast<uint32_t>(option.text.size());
+            optionRecord.outcomeLength = static_cast<uint32_t>(option.outcomeText.size());
+            appendBytes(record, &optionRecord, sizeof(optionRecord));
+        }
+        record += event.name;
+        record += event.description;
+        for (const auto& option : event.options) {
+            record += option.text;
+            record += option.outcomeText;
+        }
+
+        header.size = static_cast<uint32_t>(record.size());
+        header.checksum = checksum32(record.data() + sizeof(RecordHeader), record.size() - sizeof(RecordHeader));
+        std::memcpy(&record[0], &header, sizeof(header));
+    }
+
+    // 检查 data 开始的记录是否完整有效（available 为可用字节数），有效时写入记录头
+    bool checkRecord(const char* data, uint64_t available, RecordHeader& header) {
+        if (available < sizeof(RecordHeader)) {
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (header.marker != RECORD_MARKER || header.size < sizeof(RecordHeader) ||
+            header.size > MAX_RECORD_SIZE || header.size > available) {
+            return false;
+        }
+        uint64_t expected = sizeof(RecordHeader) + uint64_t{header.optionCount} * sizeof(OptionRecord) +
+                            header.nameLength + header.descriptionLength;
+        if (expected > header.size) {
+            return false;
+        }
+        return checksum32(data + sizeof(RecordHeader), header.size - sizeof(RecordHeader)) == header.checksum;
+    }
+
+    // 解码一条已检查过的记录
+    bool decodeRecord(const char* data, const RecordHeader& header, LLMClient::RandomEvent& event) {
+        const char* end = data + header.size;
+        const char* cursor = data + sizeof(RecordHeader);
+
+        std::vector<OptionRecord> optionRecords(header.optionCount);
+        if (header.optionCount > 0) {
+            std::memcpy(optionRecords.data(), cursor, optionRecords.size() * sizeof(OptionRecord));
+        }
+        cursor += optionRecords.size() * sizeof(OptionRecord);
+
+        auto takeString = [&cursor, end](uint32_t length, std::string& out) {
+            if (static_cast<size_t>(end - cursor) < length) {
+                return false;
+            }
+            out.assign(cursor, length);
+            cursor += length;
+            return true;
+        };
+
+        event = LLMClient::RandomEvent();
+        if (!takeString(header.nameLength, event.name) || !takeString(header.descriptionLength, event.description)) {
+            return false;
+        }
+        event.options.resize(header.optionCount);
+        for (size_t i = 0; i < optionRecords.size(); ++i) {
+            auto& option = event.options[i];
+            for (size_t d = 0; d < DecisionVector::DIMENSIONS; ++d) {
+                option.decisionRequirement[d] = optionRecords[i].decisionRequirement[d];
+                option.decisionFeedback[d] = optionRecords[i].decisionFeedback[d];
+            }
+            if (!takeString(optionRecords[i].textLength, option.text) ||
+                !takeString(optionRecords[i].outcomeLength, option.outcomeText)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool writeHeader(std::ostream& out, const char (&magic)[8]) {
+        FileHeader header{};
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = FORMAT_VERSION;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return static_cast<bool>(out);
+    }
+
+    bool checkHeader(std::istream& in, const char (&magic)[8]) {
+        FileHeader header{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        return in && std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == FORMAT_VERSION;
+    }
+}
+
+EventStore::~EventStore() {
+    close();
+}
+
+uint64_t EventStore::computeContentHash(const LLMClient::RandomEvent& event) {
+    uint64_t hash = 14695981039346656037ull;
+    hashString(hash, event.name);
+    hashString(hash, event.description);
+    for (const auto& option : event.options) {
+        hashString(hash, option.text);
+        hashString(hash, option.outcomeText);
+        for (size_t d = 0; d < DecisionVector::DIMENSIONS; ++d) {
+            // +0.0 使 -0.0 与 0.0 得到相同的哈希
+            double requirement = option.decisionRequirement[d] + 0.0;
+            double feedback = option.decisionFeedback[d] + 0.0;
+            hashBytes(hash, &requirement, sizeof(requirement));
+            hashBytes(hash, &feedback, sizeof(feedback));
+        }
+    }
+    return hash;
+}
+
+bool EventStore::open(const std::string& path) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    directory = path;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::string dataPath = directory + "/" + DATA_FILE_NAME;
+    std::string indexPath = directory + "/" + INDEX_FILE_NAME;
+
+    // 数据文件不存在时创建
+    uint64_t fileSize = std::filesystem::exists(dataPath, ec) ? std::filesystem::file_size(dataPath, ec) : 0;
+    if (ec || fileSize == 0) {
+        std::ofstream create(dataPath, std::ios::binary | std::ios::trunc);
+        if (!create.is_open() || !writeHeader(create, DATA_MAGIC)) {
+            LOG_ERROR("EventStore: 无法创建事件库 " << dataPath);
+            return false;
+        }
+        create.close();
+        fileSize = sizeof(FileHeader);
+        std::filesystem::remove(indexPath, ec);
+    }
+
+    std::ifstream data(dataPath, std::ios::binary);
+    if (!data.is_open() || !checkHeader(data, DATA_MAGIC)) {
+        LOG_ERROR("EventStore: " << dataPath << " 不是有效的事件库文件");
+        return false;
+    }
+
+    // 读取索引：只保留指向数据文件内、且偏移递增的条目
+    entries.clear();
+    bool indexValid = false;
+    std::ifstream index(indexPath, std::ios::binary);
+    if (index.is_open() && checkHeader(index, INDEX_MAGIC)) {
+        indexValid = true;
+        IndexRecord record;
+        uint64_t previous = 0;
+        while (index.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            if (record.offset < sizeof(FileHeader) || record.offset >= fileSize ||
+                (!entries.empty() && record.offset <= previous)) {
+                indexValid = false;
+                break;
+            }
+            entries.push_back(IndexEntry{record.offset, record.contentHash});
+            previous = record.offset;
+        }
+        // 索引末尾不完整的条目
+        if (index.gcount() != 0) {
+            indexValid = false;
+        }
+    }
+    index.close();
+
+    // 从最后一个索引条目开始扫描：重新检查最后一条记录，并补齐索引之后的记录
+    uint64_t scanFrom = sizeof(FileHeader);
+    size_t indexedCount = entries.size();
+    if (!entries.empty()) {
+        scanFrom = entries.back().offset;
+        entries.pop_back();
+    }
+    uint64_t validEnd = scanRecordsLocked(data, scanFrom, fileSize);
+    data.close();
+    if (entries.size() != indexedCount) {
+        indexValid = false;
+    }
+
+    if (validEnd < fileSize) {
+        LOG_WARN("EventStore: " << dataPath << " 末尾有 " << fileSize - validEnd
+                 << " 字节不完整的记录（写入中途退出），已截掉");
+        std::filesystem::resize_file(dataPath, validEnd, ec);
+        if (ec) {
+            LOG_ERROR("EventStore: 无法截断 " << dataPath << ": " << ec.message());
+            return false;
+        }
+    }
+    dataSize = validEnd;
+
+    // 索引缺失或与数据文件不一致时重写
+    if (!indexValid) {
+        std::ofstream rebuilt(indexPath, std::ios::binary | std::ios::trunc);
+        if (!rebuilt.is_open() || !writeHeader(rebuilt, INDEX_MAGIC)) {
+            LOG_ERROR("EventStore: 无法写入索引 " << indexPath);
+            return false;
+        }
+        for (const auto& entry : entries) {
+            IndexRecord record{entry.offset, entry.contentHash};
+            rebuilt.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        if (!rebuilt) {
+            LOG_ERROR("EventStore: 无法写入索引 " << indexPath);
+            return false;
+        }
+    }
+
+    // 旧版本可能把同一个事件保存了多次：索引文件保留所有记录，内存中只保留第一次出现的
+    contentHashes.clear();
+    contentHashes.reserve(entries.size());
+    duplicateCount = 0;
+    auto unique = std::remove_if(entries.begin(), entries.end(), [this](const IndexEntry& entry) {
+        return !contentHashes.insert(entry.contentHash).second;
+    });
+    duplicateCount = static_cast<size_t>(entries.end() - unique);
+    entries.erase(unique, entries.end());
+
+    if (!mapLocked()) {
+        return false;
+    }
+
+    dataOut.open(dataPath, std::ios::binary | std::ios::app);
+    indexOut.open(indexPath, std::ios::binary | std::ios::app);
+    if (!dataOut.is_open() || !indexOut.is_open()) {
+        LOG_ERROR("EventStore: 无法以追加方式打开事件库 " << dataPath);
+        unmapLocked();
+        dataOut.close();
+        indexOut.close();
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+uint64_t EventStore::scanRecordsLocked(std::ifstream& data, uint64_t offset, uint64_t fileSize) {
+    std::vector<char> buffer;
+    while (offset < fileSize) {
+        RecordHeader header;
+        data.clear();
+        data.seekg(static_cast<std::streamoff>(offset));
+        if (fileSize - offset < sizeof(RecordHeader) ||
+            !data.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.marker != RECORD_MARKER || header.size < sizeof(RecordHeader) ||
+            header.size > MAX_RECORD_SIZE || header.size > fileSize - offset) {
+            break;
+        }
+        buffer.resize(header.size);
+        data.seekg(static_cast<std::streamoff>(offset));
+        if (!data.read(buffer.data(), header.size) || !checkRecord(buffer.data(), header.size, header)) {
+            break;
+        }
+        entries.push_back(IndexEntry{offset, header.contentHash});
+        offset += header.size;
+    }
+    return offset;
+}
+
+void EventStore::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    unmapLocked();
+    dataOut.close();
+    indexOut.close();
+    entries.clear();
+    contentHashes.clear();
+    duplicateCount = 0;
+    dataSize = 0;
+    opened = false;
+}
+
+bool EventStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return opened;
+}
+
+size_t EventStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t EventStore::getDuplicateCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return duplicateCount;
+}
+
+bool EventStore::contains(uint64_t contentHash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return contentHashes.count(contentHash) != 0;
+}
+
+uint64_t EventStore::contentHash(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < entries.size() ? entries[index].contentHash : 0;
+}
+
+std::string EventStore::getDataPath() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return directory + "/" + DATA_FILE_NAME;
+}
+
+uint64_t EventStore::getDataSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dataSize;
+}
+
+bool EventStore::read(size_t index, LLMClient::RandomEvent& event) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened || index >= entries.size()) {
+        return false;
+    }
+    uint64_t offset = entries[index].offset;
+
+    // 本次运行追加的记录不在映射范围内时重新映射
+    if (dataSize > mapping.size && !mapLocked()) {
+        return false;
+    }
+
+    // 去重后相邻的索引条目不一定是相邻的记录，记录长度由记录头确定
+    RecordHeader header;
+    const char* record = mapping.data + offset;
+    if (!checkRecord(record, dataSize - offset, header) || !decodeRecord(record, header, event)) {
+        LOG_ERROR("EventStore: 事件 #" << index << " 的记录已损坏");
+        return false;
+    }
+    return true;
+}
+
+EventStore::AppendResult EventStore::append(const LLMClient::RandomEvent& event) {
+    uint64_t hash = computeContentHash(event);
+    std::string record;
+    encodeRecord(event, hash, record);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened) {
+        return AppendResult::Failed;
+    }
+    if (contentHashes.count(hash) != 0) {
+        return AppendResult::Duplicate;
+    }
+
+    // 先写数据再写索引：中途退出时下次打开会扫描数据文件补齐索引
+    dataOut.write(record.data(), static_cast<std::streamsize>(record.size()));
+    dataOut.flush();
+    if (!dataOut) {
+        LOG_ERROR("EventStore: 写入事件库失败");
+        dataOut.clear();
+        return AppendResult::Failed;
+    }
+
+    IndexRecord indexRecord{dataSize, hash};
+    indexOut.write(reinterpret_cast<const char*>(&indexRecord), sizeof(indexRecord));
+    indexOut.flush();
+    if (!indexOut) {
+        indexOut.clear();
+    }
+
+    entries.push_back(IndexEntry{dataSize, hash});
+    contentHashes.insert(hash);
+    dataSize += record.size();
+    return AppendResult::Added;
+}
+
+#ifdef _WIN32
+
+bool EventStore::mapLocked() const {
+    unmapLocked();
+    std::string dataPath = directory + "/" + DATA_FILE_NAME;
+    HANDLE file = CreateFileA(dataPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("EventStore: 无法打开 " << dataPath);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE handle = nullptr;
+    const void* view = nullptr;
+    if (GetFileSizeEx(file, &fileSize)) {
+        handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (handle) {
+        view = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!view) {
+        LOG_ERROR("EventStore: 无法映射 " << dataPath);
+        if (handle) {
+            CloseHandle(handle);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    mapping.file = file;
+    mapping.handle = handle;
+    mapping.data = static_cast<const char*>(view);
+    mapping.size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void EventStore::unmapLocked() const {
+    if (mapping.data) {
+        UnmapViewOfFile(mapping.data);
+    }
+    if (mapping.handle) {
+        CloseHandle(mapping.handle);
+    }
+    if (mapping.file) {
+        CloseHandle(mapping.file);
+    }
+    mapping = Mapping();
+}
+
+#else
+
+bool EventStore::mapLocked() const {
+    unmapLocked();
+    std::string dataPath = directory + "/" + DATA_FILE_NAME;
+    int fd = ::open(dataPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("EventStore: 无法打开 " << dataPath);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        LOG_ERROR("EventStore: 无法映射 " << dataPath);
+        ::close(fd);
+        return false;
+    }
+    mapping.fd = fd;
+    mapping.data = static_cast<const char*>(view);
+    mapping.size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void EventStore::unmapLocked() const {
+    if (mapping.data) {
+        munmap(const_cast<char*>(mapping.data), mapping.size);
+    }
+    if (mapping.fd >= 0) {
+        ::close(mapping.fd);
+    }
+    mapping = Mapping();
+}
+
+#endif
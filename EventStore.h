@@ -0,0 +1,102 @@
+#pragma once
+
+#include "LLMClient.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// 事件库：只追加的二进制事件文件（events.bin）+ 偏移索引（events.idx）
+// 每个事件是一条定长布局的记录：记录头、每个选项的两个12维向量和字符串长度、最后是字符串内容
+// 打开时把数据文件映射到内存，只读取索引，不解析任何事件；事件在 read() 时才从映射中解码
+// 索引缺失或落后于数据文件（写入中途退出）时扫描数据文件补齐，末尾不完整的记录会被截掉
+// 按内容哈希去重：追加时拒绝已有的事件，打开时跳过旧版本写入的重复记录
+// 文件按本机字节序写入；所有方法都可以在多个线程中同时调用
+class EventStore {
+public:
+    static constexpr const char* DATA_FILE_NAME = "events.bin";
+    static constexpr const char* INDEX_FILE_NAME = "events.idx";
+
+    // 追加结果
+    enum class AppendResult {
+        Added,
+        Duplicate,      // 内容相同的事件已在库中
+        Failed          // 未打开或写入失败
+    };
+
+    EventStore() = default;
+    ~EventStore();
+
+    EventStore(const EventStore&) = delete;
+    EventStore& operator=(const EventStore&) = delete;
+
+    // 打开（不存在时创建）directory 下的事件库，失败时返回 false
+    bool open(const std::string& directory);
+    void close();
+    bool isOpen() const;
+
+    // 事件数量（不含重复记录）
+    size_t size() const;
+
+    // 打开时跳过的重复记录数
+    size_t getDuplicateCount() const;
+
+    // 读取第 index 个事件，越界或记录损坏时返回 false
+    bool read(size_t index, LLMClient::RandomEvent& event) const;
+
+    // 追加一个事件（内容相同的事件已在库中时不写入）
+    AppendResult append(const LLMClient::RandomEvent& event);
+
+    // 库中是否已有该内容哈希的事件
+    bool contains(uint64_t contentHash) const;
+
+    // 第 index 个事件的内容哈希（来自索引，不读取记录）
+    uint64_t contentHash(size_t index) const;
+
+    // 事件内容哈希：名称、描述、选项文本、结果文本和决策向量（与 JSON 中的格式和空白无关）
+    static uint64_t computeContentHash(const LLMClient::RandomEvent& event);
+
+    // 数据文件路径和大小（字节）
+    std::string getDataPath() const;
+    uint64_t getDataSize() const;
+
+private:
+    struct IndexEntry {
+        uint64_t offset;        // 记录在数据文件中的偏移
+        uint64_t contentHash;
+    };
+
+    // 只读内存映射
+    struct Mapping {
+        const char* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        void* file = nullptr;
+        void* handle = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // 映射整个数据文件（调用时需持有 mutex）
+    bool mapLocked() const;
+    void unmapLocked() const;
+
+    // 从 offset 开始扫描数据文件，补齐索引，返回最后一条完整记录的结尾
+    uint64_t scanRecordsLocked(std::ifstream& data, uint64_t offset, uint64_t fileSize);
+
+    mutable std::mutex mutex;
+    std::string directory;
+    std::vector<IndexEntry> entries;           // 不含重复记录
+    std::unordered_set<uint64_t> contentHashes;
+    size_t duplicateCount = 0;
+    uint64_t dataSize = 0;
+    bool opened = false;
+
+    mutable Mapping mapping;          // 数据文件的映射（追加后按需重新映射）
+    std::ofstream dataOut;
+    std::ofstream indexOut;
+};
@@ -0,0 +1,31 @@
+#include "FileUtils.h"
+#include "Logger.h"
+#include <filesystem>
+#include <fstream>
+
+bool writeFileAtomically(const std::string& path, std::string_view text) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("无法写入文件 " << tempPath);
+            return false;
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file) {
+            LOG_ERROR("写入文件失败 " << tempPath);
+            std::error_code ec;
+            file.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        LOG_ERROR("无法替换文件 " << path << ": " << ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// 把 text 写入 path：先写入 path + ".tmp" 再替换原文件，中途退出或读取方不会看到不完整的文件
+// 失败时记录错误日志、删除临时文件并返回 false（原文件保持不变）
+bool writeFileAtomically(const std::string& path, std::string_view text);
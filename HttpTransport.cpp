@@ -0,0 +1,860 @@
+#include "HttpTransport.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#pragma comment(lib, "winhttp.lib")
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string toLower(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    // 解析 scheme://host[:port][/path]，省略协议时按 http 处理
+    bool parseUrl(const std::string& url, std::string& scheme, std::string& host, int& port, std::string& path) {
+        std::string rest = url;
+        size_t schemeEnd = rest.find("://");
+        if (schemeEnd == std::string::npos) {
+            scheme = "http";
+        } else {
+            scheme = toLower(rest.substr(0, schemeEnd));
+            rest = rest.substr(schemeEnd + 3);
+        }
+        if (scheme != "http" && scheme != "https") {
+            return false;
+        }
+
+        size_t pathStart = rest.find('/');
+        std::string authority = rest.substr(0, pathStart);
+        path = pathStart == std::string::npos ? "" : rest.substr(pathStart);
+        while (!path.empty() && path.back() == '/') {
+            path.pop_back();
+        }
+
+        port = scheme == "https" ? 443 : 80;
+        size_t colon = authority.rfind(':');
+        if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+            try {
+                port = std::stoi(authority.substr(colon + 1));
+            } catch (...) {
+                return false;
+            }
+            authority = authority.substr(0, colon);
+        }
+        // [IPv6] 形式的地址去掉方括号
+        if (authority.size() >= 2 && authority.front() == '[' && authority.back() == ']') {
+            authority = authority.substr(1, authority.size() - 2);
+        }
+
+        host = authority;
+        return !host.empty() && port > 0 && port < 65536;
+    }
+
+    // 发送请求时使用的配置快照
+    struct RequestTarget {
+        std::string scheme;
+        std::string host;
+        int port = 0;
+        std::string path;
+        std::string bearerToken;
+        int timeoutSeconds = 30;
+        size_t maxIdleConnections = 0;
+    };
+
+    // 停止信号中止的请求
+    HttpResponse stoppedResponse() {
+        HttpResponse response;
+        response.aborted = true;
+        response.error = "Stopped";
+        return response;
+    }
+
+    // 请求进行期间登记在停止信号上的中止操作，析构时注销
+    class StopRegistration {
+    public:
+        StopRegistration(HttpStopSignal* stop, HttpStopSignal::AbortAction abort)
+            : stop(stop), id(stop ? stop->attach(std::move(abort)) : 0) {}
+        ~StopRegistration() { release(); }
+
+        StopRegistration(const StopRegistration&) = delete;
+        StopRegistration& operator=(const StopRegistration&) = delete;
+
+        // 注销之后中止操作不会再被调用，可以安全关闭连接
+        void release() {
+            if (id != 0) {
+                stop->detach(id);
+                id = 0;
+            }
+        }
+
+        // 停止信号已触发（登记前已停止，或登记期间中止操作可能已执行）
+        bool stopped() const { return stop && stop->stopRequested(); }
+
+    private:
+        HttpStopSignal* stop;
+        uint64_t id;
+    };
+
+    // 把一段响应体交给回调（2xx 响应流式接收时）或追加到 body，回调要求中止时返回 false
+    bool deliverBody(HttpResponse& response, const HttpTransport::BodyCallback& onData,
+                     const char* data, size_t size) {
+        if (size == 0) {
+            return true;
+        }
+        if (onData && response.ok()) {
+            if (!onData(data, size)) {
+                response.aborted = true;
+                response.error = "Aborted by caller";
+                return false;
+            }
+            return true;
+        }
+        response.body.append(data, size);
+        return true;
+    }
+}
+
+#ifdef _WIN32
+
+namespace {
+    std::wstring toWide(const std::string& text) {
+        if (text.empty()) return L"";
+        int size = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), NULL, 0);
+        std::wstring wide(size, 0);
+        MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wide[0], size);
+        return wide;
+    }
+}
+
+// WinHTTP 实现：会话和连接句柄常驻，WinHTTP 在会话内部维护 keep-alive 连接池
+// 句柄按引用计数关闭：基础URL变化或 closeAll() 时只放弃引用，正在使用旧连接的请求结束后才真正关闭
+struct HttpTransport::Backend {
+    // 引用计数的 WinHTTP 句柄，最后一个引用释放时 WinHttpCloseHandle
+    using Handle = std::shared_ptr<void>;
+
+    std::mutex mutex;
+    Handle session;
+    Handle connection;    // 删除器持有 session 的引用，连接关闭前会话不会关闭
+    std::string connectedHost;
+    int connectedPort = 0;
+
+    ~Backend() { closeAll(); }
+
+    void closeAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        connection.reset();
+        session.reset();
+        connectedHost.clear();
+        connectedPort = 0;
+    }
+
+    // 获取到目标主机的连接句柄（不存在时创建），返回是否新建；请求期间持有返回的引用
+    Handle getConnection(const RequestTarget& target, bool& created, std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        created = false;
+        if (!session) {
+            HINTERNET handle = WinHttpOpen(L"LLMClient/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                                           WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+            if (!handle) {
+                error = "Failed to create WinHTTP session";
+                return Handle();
+            }
+            DWORD maxConnections = static_cast<DWORD>(std::max<size_t>(1, target.maxIdleConnections));
+            WinHttpSetOption(handle, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &maxConnections, sizeof(maxConnections));
+            session = Handle(handle, [](void* h) { WinHttpCloseHandle(h); });
+        }
+        if (connection && (connectedHost != target.host || connectedPort != target.port)) {
+            // 其他线程可能仍在旧连接上发送请求，由它们的引用决定何时关闭
+            connection.reset();
+        }
+        if (!connection) {
+            HINTERNET handle = WinHttpConnect(session.get(), toWide(target.host).c_str(),
+                                              static_cast<INTERNET_PORT>(target.port), 0);
+            if (!handle) {
+                error = "Failed to connect to server";
+                return Handle();
+            }
+            Handle owner = session;
+            connection = Handle(handle, [owner](void* h) { WinHttpCloseHandle(h); });
+            connectedHost = target.host;
+            connectedPort = target.port;
+            created = true;
+        }
+        return connection;
+    }
+
+    // 空闲连接由 WinHTTP 内部管理，无法查询
+    size_t idleCount() const { return 0; }
+
+    // 发送一个请求
+    HttpResponse send(const RequestTarget& target, const std::string& body,
+                      const HttpTransport::BodyCallback& onData, std::atomic<uint64_t>& connectionCount,
+                      HttpStopSignal* stop);
+};
+
+HttpResponse HttpTransport::Backend::send(const RequestTarget& target, const std::string& body,
+                                          const HttpTransport::BodyCallback& onData,
+                                          std::atomic<uint64_t>& connectionCount,
+                                          HttpStopSignal* stop) {
+    HttpResponse response;
+    bool created = false;
+    Handle connection = getConnection(target, created, response.error);
+    if (!connection) {
+        return response;
+    }
+    if (created) {
+        ++connectionCount;
+    }
+
+    HINTERNET request = WinHttpOpenRequest(connection.get(), L"POST", toWide(target.path).c_str(),
+                                           NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                           target.scheme == "https" ? WINHTTP_FLAG_SECURE : 0);
+    if (!request) {
+        response.error = "Failed to create request";
+        return response;
+    }
+
+    // 停止时由停止信号所在线程关闭请求句柄，阻塞中的 WinHTTP 调用随即失败返回
+    bool closedByStop = false;
+    StopRegistration registration(stop, [request, &closedByStop] {
+        closedByStop = true;
+        WinHttpCloseHandle(request);
+    });
+    // 关闭请求句柄（已被停止信号关闭时不再关闭），返回最终的响应
+    auto finish = [&](HttpResponse& result) {
+        registration.release();
+        if (closedByStop) {
+            return stoppedResponse();
+        }
+        WinHttpCloseHandle(request);
+        return result;
+    };
+    if (registration.stopped()) {
+        HttpResponse stopped = stoppedResponse();
+        return finish(stopped);
+    }
+
+    DWORD timeoutMs = static_cast<DWORD>(target.timeoutSeconds) * 1000;
+    WinHttpSetTimeouts(request, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
+
+    std::wstring headers = L"Content-Type: application/json; charset=utf-8";
+    if (!target.bearerToken.empty()) {
+        headers += L"\r\nAuthorization: Bearer " + toWide(target.bearerToken);
+    }
+
+    if (!WinHttpSendRequest(request, headers.c_str(), static_cast<DWORD>(headers.length()),
+                            (LPVOID)body.data(), static_cast<DWORD>(body.size()),
+                            static_cast<DWORD>(body.size()), 0)) {
+        response.error = "Failed to send request";
+        return finish(response);
+    }
+    if (!WinHttpReceiveResponse(request, NULL)) {
+        response.error = "Failed to receive response";
+        return finish(response);
+    }
+
+    DWORD statusCode = 0;
+    DWORD statusSize = sizeof(statusCode);
+    WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                        WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &statusSize, WINHTTP_NO_HEADER_INDEX);
+    response.statusCode = static_cast<int>(statusCode);
+
+    std::vector<char> buffer;
+    while (true) {
+        DWORD available = 0;
+        if (!WinHttpQueryDataAvailable(request, &available)) {
+            response.error = "Error querying data available";
+            response.statusCode = 0;
+            return finish(response);
+        }
+        if (available == 0) {
+            break;
+        }
+        buffer.resize(available);
+        DWORD downloaded = 0;
+        if (!WinHttpReadData(request, buffer.data(), available, &downloaded)) {
+            response.error = "Error reading data";
+            response.statusCode = 0;
+            return finish(response);
+        }
+        if (!deliverBody(response, onData, buffer.data(), downloaded)) {
+            // 未读完响应体就关闭请求句柄，WinHTTP 不会复用这个连接
+            return finish(response);
+        }
+    }
+
+    // 只关闭请求句柄，底层连接留在 WinHTTP 的连接池中
+    return finish(response);
+}
+
+#else
+
+namespace {
+    void closeSocket(int fd) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+// POSIX 实现：保存空闲的 keep-alive 连接，请求时优先复用
+struct HttpTransport::Backend {
+    mutable std::mutex mutex;
+    std::vector<int> idle;
+    uint64_t generation = 0;  // 基础URL变化时递增，旧连接不再放回池中
+
+    ~Backend() { closeAll(); }
+
+    void closeAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int fd : idle) {
+            closeSocket(fd);
+        }
+        idle.clear();
+        ++generation;
+    }
+
+    // 取出一个空闲连接（reuse 为 false 时不复用），没有时返回 -1
+    int acquire(uint64_t& connectionGeneration, bool reuse) {
+        std::lock_guard<std::mutex> lock(mutex);
+        connectionGeneration = generation;
+        if (!reuse || idle.empty()) {
+            return -1;
+        }
+        int fd = idle.back();
+        idle.pop_back();
+        return fd;
+    }
+
+    // 归还连接：基础URL已变化或空闲连接已满时直接关闭
+    void release(int fd, uint64_t connectionGeneration, size_t maxIdle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (connectionGeneration != generation || idle.size() >= maxIdle) {
+            closeSocket(fd);
+            return;
+        }
+        idle.push_back(fd);
+    }
+
+    size_t idleCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return idle.size();
+    }
+
+    // 发送一个请求
+    HttpResponse send(const RequestTarget& target, const std::string& body,
+                      const HttpTransport::BodyCallback& onData, std::atomic<uint64_t>& connectionCount,
+                      HttpStopSignal* stop);
+};
+
+namespace {
+    // 中止阻塞在该套接字上的 connect/recv/send（套接字仍由原线程关闭）
+    HttpStopSignal::AbortAction shutdownSocket(int fd) {
+        return [fd] { shutdown(fd, SHUT_RDWR); };
+    }
+
+    // 建立TCP连接（带连接超时），失败返回 -1
+    int openConnection(const RequestTarget& target, std::string& error, HttpStopSignal* stop) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        std::string portText = std::to_string(target.port);
+        int rc = getaddrinfo(target.host.c_str(), portText.c_str(), &hints, &addresses);
+        if (rc != 0) {
+            error = "Failed to resolve host " + target.host + ": " + gai_strerror(rc);
+            return -1;
+        }
+
+        int fd = -1;
+        for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+            fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+
+            // 非阻塞 connect + poll 实现连接超时；停止时 shutdown 使 poll 立即返回
+            StopRegistration registration(stop, shutdownSocket(fd));
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+            int result = registration.stopped() ? -1 : connect(fd, address->ai_addr, address->ai_addrlen);
+            if (result < 0 && errno == EINPROGRESS) {
+                pollfd pfd{fd, POLLOUT, 0};
+                result = -1;
+                if (poll(&pfd, 1, target.timeoutSeconds * 1000) == 1) {
+                    int socketError = 0;
+                    socklen_t length = sizeof(socketError);
+                    getsockopt(fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+                    result = socketError == 0 ? 0 : -1;
+                }
+            }
+            registration.release();
+            if (result == 0 && !registration.stopped()) {
+                fcntl(fd, F_SETFL, flags);
+                break;
+            }
+            closeSocket(fd);
+            fd = -1;
+            if (registration.stopped()) {
+                break;
+            }
+        }
+        freeaddrinfo(addresses);
+
+        if (fd < 0) {
+            error = "Failed to connect to " + target.host + ":" + portText;
+            return -1;
+        }
+
+        timeval timeout{};
+        timeout.tv_sec = target.timeoutSeconds;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+#ifdef SO_NOSIGPIPE
+        int noSigPipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+        return fd;
+    }
+
+    bool sendAll(int fd, const std::string& data) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, flags);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // 带缓冲的套接字读取
+    class SocketReader {
+    public:
+        explicit SocketReader(int fd) : fd(fd) {}
+
+        // 读取一行（不含 \r\n）
+        bool readLine(std::string& line) {
+            while (true) {
+                size_t end = buffer.find("\r\n", position);
+                if (end != std::string::npos) {
+                    line.assign(buffer, position, end - position);
+                    position = end + 2;
+                    return true;
+                }
+                if (!fill()) {
+                    return false;
+                }
+            }
+        }
+
+        // 读取恰好 length 字节追加到 out
+        bool readExact(size_t length, std::string& out) {
+            while (buffer.size() - position < length) {
+                if (!fill()) {
+                    return false;
+                }
+            }
+            out.append(buffer, position, length);
+            position += length;
+            return true;
+        }
+
+        // 读取最多 maxLength 字节到 out（缓冲区为空时等待新数据），连接关闭时返回 false
+        bool readSome(size_t maxLength, std::string& out) {
+            if (position == buffer.size() && !fill()) {
+                return false;
+            }
+            size_t length = std::min(maxLength, buffer.size() - position);
+            out.assign(buffer, position, length);
+            position += length;
+            return true;
+        }
+
+        // 是否收到过任何数据
+        bool receivedAnything() const { return received > 0; }
+
+    private:
+        int fd;
+        std::string buffer;
+        size_t position = 0;
+        size_t received = 0;
+
+        bool fill() {
+            if (position > 0 && position == buffer.size()) {
+                buffer.clear();
+                position = 0;
+            }
+            char chunk[16384];
+            while (true) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return false;
+                }
+                buffer.append(chunk, static_cast<size_t>(n));
+                received += static_cast<size_t>(n);
+                return true;
+            }
+        }
+    };
+
+    // 读取并解析一个响应，keepAlive 表示连接之后是否还能复用
+    bool readResponse(SocketReader& reader, HttpResponse& response, bool& keepAlive,
+                      const HttpTransport::BodyCallback& onData) {
+        std::string line;
+        bool http10 = false;
+        bool chunked = false;
+        bool hasContentLength = false;
+        size_t contentLength = 0;
+        std::string connectionHeader;
+
+        // 状态行（跳过 1xx 临时响应）
+        do {
+            if (!reader.readLine(line)) {
+                response.error = "Connection closed before response";
+                return false;
+            }
+            if (line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+                response.error = "Malformed status line: " + line.substr(0, 100);
+                return false;
+            }
+            http10 = line.compare(0, 8, "HTTP/1.0") == 0;
+            response.statusCode = std::atoi(line.c_str() + 9);
+
+            // 响应头
+            while (true) {
+                if (!reader.readLine(line)) {
+                    response.error = "Connection closed while reading headers";
+                    return false;
+                }
+                if (line.empty()) {
+                    break;
+                }
+                size_t colon = line.find(':');
+                if (colon == std::string::npos) {
+                    continue;
+                }
+                std::string name = toLower(line.substr(0, colon));
+                size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+                std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+                if (name == "content-length") {
+                    hasContentLength = true;
+                    contentLength = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+                } else if (name == "transfer-encoding") {
+                    chunked = toLower(value).find("chunked") != std::string::npos;
+                } else if (name == "connection") {
+                    connectionHeader = toLower(value);
+                }
+            }
+        } while (response.statusCode >= 100 && response.statusCode < 200);
+
+        keepAlive = http10 ? connectionHeader.find("keep-alive") != std::string::npos
+                           : connectionHeader.find("close") == std::string::npos;
+
+        // 响应体（按到达的数据分段交给 deliverBody，流式接收时不必等整个响应体）
+        if (response.statusCode == 204 || response.statusCode == 304) {
+            return true;
+        }
+        std::string piece;
+        if (chunked) {
+            while (true) {
+                if (!reader.readLine(line)) {
+                    response.error = "Connection closed while reading chunk size";
+                    return false;
+                }
+                size_t remaining = static_cast<size_t>(std::strtoull(line.c_str(), nullptr, 16));
+                if (remaining == 0) {
+                    // 跳过 trailer
+                    while (reader.readLine(line) && !line.empty()) {
+                    }
+                    return true;
+                }
+                while (remaining > 0) {
+                    if (!reader.readSome(remaining, piece)) {
+                        response.error = "Connection closed while reading chunk";
+                        return false;
+                    }
+                    remaining -= piece.size();
+                    if (!deliverBody(response, onData, piece.data(), piece.size())) {
+                        return false;
+                    }
+                }
+                std::string crlf;
+                if (!reader.readExact(2, crlf)) {
+                    response.error = "Connection closed while reading chunk";
+                    return false;
+                }
+            }
+        }
+        if (hasContentLength) {
+            size_t remaining = contentLength;
+            while (remaining > 0) {
+                if (!reader.readSome(remaining, piece)) {
+                    response.error = "Connection closed before end of body";
+                    return false;
+                }
+                remaining -= piece.size();
+                if (!deliverBody(response, onData, piece.data(), piece.size())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 既没有长度也不是 chunked：读到连接关闭
+        keepAlive = false;
+        while (reader.readSome(std::string::npos, piece)) {
+            if (!deliverBody(response, onData, piece.data(), piece.size())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string buildRequest(const RequestTarget& target, const std::string& body) {
+        std::string request;
+        request.reserve(body.size() + 256);
+        request += "POST " + target.path + " HTTP/1.1\r\n";
+        request += "Host: " + target.host;
+        if (target.port != 80) {
+            request += ":" + std::to_string(target.port);
+        }
+        request += "\r\n";
+        request += "User-Agent: LLMClient/1.0\r\n";
+        request += "Content-Type: application/json; charset=utf-8\r\n";
+        if (!target.bearerToken.empty()) {
+            request += "Authorization: Bearer " + target.bearerToken + "\r\n";
+        }
+        request += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        request += "Connection: keep-alive\r\n\r\n";
+        request += body;
+        return request;
+    }
+}
+
+HttpResponse HttpTransport::Backend::send(const RequestTarget& target, const std::string& body,
+                                          const HttpTransport::BodyCallback& onData,
+                                          std::atomic<uint64_t>& connectionCount,
+                                          HttpStopSignal* stop) {
+    if (target.scheme == "https") {
+        HttpResponse response;
+        response.error = "HTTPS requires the WinHTTP backend (Windows)";
+        return response;
+    }
+
+    std::string request = buildRequest(target, body);
+
+    // 复用的连接可能已被服务器关闭：在没收到任何响应数据时换新连接重试一次
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        HttpResponse response;
+        uint64_t generation = 0;
+        int fd = acquire(generation, attempt == 0);
+        bool reused = fd >= 0;
+        if (!reused) {
+            fd = openConnection(target, response.error, stop);
+            if (fd < 0) {
+                return stop && stop->stopRequested() ? stoppedResponse() : response;
+            }
+            ++connectionCount;
+        }
+
+        // 停止时 shutdown 使阻塞中的 recv/send 立即返回；被 shutdown 过的连接不放回池中
+        StopRegistration registration(stop, shutdownSocket(fd));
+        SocketReader reader(fd);
+        bool keepAlive = false;
+        if (!registration.stopped() && sendAll(fd, request) && readResponse(reader, response, keepAlive, onData)) {
+            registration.release();
+            if (keepAlive && !registration.stopped()) {
+                release(fd, generation, target.maxIdleConnections);
+            } else {
+                closeSocket(fd);
+            }
+            return response;
+        }
+
+        registration.release();
+        closeSocket(fd);
+        if (registration.stopped()) {
+            return stoppedResponse();
+        }
+        if (response.aborted) {
+            return response;
+        }
+        if (!reused || reader.receivedAnything()) {
+            if (response.error.empty()) {
+                response.error = std::string("Failed to send request: ") + std::strerror(errno);
+            }
+            response.statusCode = 0;
+            return response;
+        }
+    }
+
+    HttpResponse response;
+    response.error = "Failed to send request";
+    return response;
+}
+
+#endif
+
+
+HttpTransport::HttpTransport() : backend(std::make_unique<Backend>()) {}
+
+HttpTransport::~HttpTransport() = default;
+
+bool HttpTransport::setBaseUrl(const std::string& baseUrl) {
+    std::string newScheme, newHost, newPath;
+    int newPort = 0;
+    if (!parseUrl(baseUrl, newScheme, newHost, newPort, newPath)) {
+        return false;
+    }
+#ifndef _WIN32
+    if (newScheme == "https") {
+        return false;
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        scheme = newScheme;
+        host = newHost;
+        port = newPort;
+        pathPrefix = newPath;
+    }
+    backend->closeAll();
+    return true;
+}
+
+void HttpTransport::setTimeoutSeconds(int seconds) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    timeoutSeconds = std::max(1, seconds);
+}
+
+void HttpTransport::setBearerToken(const std::string& token) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    bearerToken = token;
+}
+
+void HttpTransport::setMaxIdleConnections(size_t maxIdle) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    maxIdleConnections = maxIdle;
+}
+
+std::string HttpTransport::buildPath(const std::string& endpoint) const {
+    std::string path = pathPrefix;
+    if (endpoint.empty() || endpoint[0] != '/') {
+        path += "/";
+    }
+    path += endpoint;
+    return path;
+}
+
+HttpResponse HttpTransport::post(const std::string& endpoint, const std::string& body) {
+    return post(endpoint, body, BodyCallback());
+}
+
+HttpResponse HttpTransport::post(const std::string& endpoint, const std::string& body, const BodyCallback& onData,
+                                 HttpStopSignal* stop) {
+    if (stop && stop->stopRequested()) {
+        return stoppedResponse();
+    }
+    RequestTarget target;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        if (host.empty()) {
+            HttpResponse response;
+            response.error = "Base URL is not set";
+            return response;
+        }
+        target.scheme = scheme;
+        target.host = host;
+        target.port = port;
+        target.path = buildPath(endpoint);
+        target.bearerToken = bearerToken;
+        target.timeoutSeconds = timeoutSeconds;
+        target.maxIdleConnections = maxIdleConnections;
+    }
+
+    ++requestCount;
+    return backend->send(target, body, onData, connectionCount, stop);
+}
+
+void HttpStopSignal::requestStop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped.store(true, std::memory_order_release);
+    for (auto& entry : actions) {
+        entry.second();
+    }
+    actions.clear();
+    stoppedChanged.notify_all();
+}
+
+void HttpStopSignal::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped.store(false, std::memory_order_release);
+}
+
+bool HttpStopSignal::waitFor(std::chrono::milliseconds duration) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    return stoppedChanged.wait_for(lock, duration, [this] { return stopRequested(); });
+}
+
+uint64_t HttpStopSignal::attach(AbortAction abort) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopRequested()) {
+        return 0;
+    }
+    uint64_t id = nextId++;
+    actions.emplace_back(id, std::move(abort));
+    return id;
+}
+
+void HttpStopSignal::detach(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < actions.size(); ++i) {
+        if (actions[i].first == id) {
+            actions[i] = std::move(actions.back());
+            actions.pop_back();
+            return;
+        }
+    }
+}
+
+void HttpTransport::closeIdleConnections() {
+    backend->closeAll();
+}
+
+size_t HttpTransport::idleConnectionCount() const {
+    return backend->idleCount();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// HTTP响应
+struct HttpResponse {
+    int statusCode = 0;   // HTTP状态码，0 表示传输失败（无法连接、超时、响应格式错误等）
+    std::string body;     // 响应体（已按 Content-Length / chunked 解码；流式接收的 2xx 响应体不保存在这里）
+    std::string error;    // 传输失败或中止时的原因
+    bool aborted = false; // 流式接收时回调要求中止
+
+    bool ok() const { return statusCode >= 200 && statusCode < 300; }
+};
+
+// 请求的停止信号：可由多个线程中的多个请求共享
+// requestStop() 立即中止正在使用该信号的请求（关闭其连接或请求句柄），之后使用该信号的请求不再发送
+class HttpStopSignal {
+public:
+    using AbortAction = std::function<void()>;
+
+    // 请求停止；reset() 之后可以重新使用
+    void requestStop();
+    void reset();
+    bool stopRequested() const { return stopped.load(std::memory_order_acquire); }
+
+    // 等待 duration 或直到停止（用于重试退避），返回是否已停止
+    bool waitFor(std::chrono::milliseconds duration) const;
+
+    // 登记请求进行期间的中止操作，requestStop() 时调用；已停止时不登记并返回 0
+    // detach() 返回后该中止操作不会再被调用（也不会正在执行）
+    uint64_t attach(AbortAction abort);
+    void detach(uint64_t id);
+
+private:
+    mutable std::mutex mutex;
+    mutable std::condition_variable stoppedChanged;
+    std::atomic<bool> stopped{false};
+    uint64_t nextId = 1;
+    std::vector<std::pair<uint64_t, AbortAction>> actions;
+};
+
+// HTTP传输层：对一个基础URL复用持久的 HTTP/1.1 keep-alive 连接
+// Windows 下使用常驻的 WinHTTP 会话（由 WinHTTP 维护连接池，支持 https）
+// 其他平台使用 POSIX socket 实现的连接池（仅支持 http，可直接连接本地替身服务器测试）
+// post() 可以在多个线程中同时调用，每个请求独占一个连接
+class HttpTransport {
+public:
+    // 默认最多保留的空闲连接数
+    static constexpr size_t DEFAULT_MAX_IDLE_CONNECTIONS = 8;
+
+    // 流式接收响应体的回调：每收到一段（已解码的）数据调用一次，返回 false 中止请求
+    using BodyCallback = std::function<bool(const char* data, size_t size)>;
+
+    HttpTransport();
+    ~HttpTransport();
+
+    HttpTransport(const HttpTransport&) = delete;
+    HttpTransport& operator=(const HttpTransport&) = delete;
+
+    // 设置基础URL（形如 http://host:port/prefix，省略协议时按 http 处理），会关闭已有的空闲连接
+    // URL 无法解析或当前平台不支持该协议时返回 false
+    bool setBaseUrl(const std::string& baseUrl);
+
+    // 设置连接/发送/接收超时（秒）
+    void setTimeoutSeconds(int seconds);
+
+    // 设置 Authorization: Bearer 令牌（为空则不发送）
+    void setBearerToken(const std::string& token);
+
+    // 设置最多保留的空闲连接数
+    void setMaxIdleConnections(size_t maxIdle);
+
+    // 向 基础URL + "/" + endpoint 发送 JSON POST 请求
+    HttpResponse post(const std::string& endpoint, const std::string& body);
+
+    // 同上，但 2xx 响应体边接收边交给 onData（不保存在 body 中）；非 2xx 响应体仍保存在 body 中
+    // onData 返回 false 时立即中止并关闭该连接，返回的响应 aborted 为 true
+    // stop 不为空时，stop->requestStop() 同样立即中止请求（aborted 为 true）；已停止时不发送
+    HttpResponse post(const std::string& endpoint, const std::string& body, const BodyCallback& onData,
+                      HttpStopSignal* stop = nullptr);
+
+    // 关闭所有空闲连接
+    void closeIdleConnections();
+
+    // 当前空闲连接数
+    size_t idleConnectionCount() const;
+
+    // 统计：已发送的请求数、新建的连接数（两者之差即复用连接的次数）
+    uint64_t getRequestCount() const { return requestCount; }
+    uint64_t getConnectionCount() const { return connectionCount; }
+
+private:
+    // 平台相关的连接池实现（定义在 HttpTransport.cpp 中）
+    struct Backend;
+    std::unique_ptr<Backend> backend;
+
+    // 解析后的基础URL
+    std::string scheme;
+    std::string host;
+    int port = 0;
+    std::string pathPrefix;
+
+    std::string bearerToken;
+    int timeoutSeconds = 30;
+    size_t maxIdleConnections = DEFAULT_MAX_IDLE_CONNECTIONS;
+
+    // 保护以上配置（post 在发送前复制一份）
+    mutable std::mutex configMutex;
+
+    std::atomic<uint64_t> requestCount{0};
+    std::atomic<uint64_t> connectionCount{0};
+
+    // 拼接请求路径
+    std::string buildPath(const std::string& endpoint) const;
+};
@@ -0,0 +1,608 @@
+#include "Json.h"
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    // 把 Unicode 码点按 UTF-8 编码追加到 out
+    void appendUtf8(std::string& out, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    // 读取 \uXXXX 中的4位十六进制数
+    bool readHex4(std::string_view text, size_t pos, uint32_t& value) {
+        if (pos + 4 > text.size()) {
+            return false;
+        }
+        auto [end, ec] = std::from_chars(text.data() + pos, text.data() + pos + 4, value, 16);
+        return ec == std::errc() && end == text.data() + pos + 4;
+    }
+
+    bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool isNumberChar(char c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+}
+
+bool unescapeJsonString(std::string_view raw, std::string& out) {
+    out.reserve(out.size() + raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++i >= raw.size()) {
+            return false;
+        }
+        switch (raw[i]) {
+            case '"':  out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/'; break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                uint32_t codePoint = 0;
+                if (!readHex4(raw, i + 1, codePoint)) {
+                    return false;
+                }
+                i += 4;
+                // 代理对
+                uint32_t low = 0;
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 2 < raw.size() &&
+                    raw[i + 1] == '\\' && raw[i + 2] == 'u' && readHex4(raw, i + 3, low) &&
+                    low >= 0xDC00 && low < 0xE000) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// 递归下降解析器
+struct JsonDocument::Parser {
+    static constexpr int MAX_DEPTH = 256;
+
+    std::string_view text;
+    size_t pos = 0;
+    std::vector<Node>& nodes;
+    const char* failure = nullptr;
+
+    Parser(std::string_view text, std::vector<Node>& nodes) : text(text), nodes(nodes) {}
+
+    bool fail(const char* reason) {
+        if (!failure) {
+            failure = reason;
+        }
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (pos < text.size() && isWhitespace(text[pos])) {
+            ++pos;
+        }
+    }
+
+    bool peek(char c) const {
+        return pos < text.size() && text[pos] == c;
+    }
+
+    uint32_t newNode(JsonValue::Type type) {
+        nodes.emplace_back();
+        nodes.back().type = type;
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void append(uint32_t parent, uint32_t child) {
+        Node& node = nodes[parent];
+        if (node.lastChild == NO_NODE) {
+            node.firstChild = child;
+        } else {
+            nodes[node.lastChild].nextSibling = child;
+        }
+        node.lastChild = child;
+        ++node.childCount;
+    }
+
+    // pos 指向开始引号；out 为引号之间的原文
+    bool parseString(std::string_view& out, bool& hasEscapes) {
+        size_t start = ++pos;
+        hasEscapes = false;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '"') {
+                out = text.substr(start, pos - start);
+                ++pos;
+                return true;
+            }
+            if (c == '\\') {
+                hasEscapes = true;
+                if (++pos >= text.size()) {
+                    break;
+                }
+                char escape = text[pos];
+                if (escape == 'u') {
+                    uint32_t codePoint;
+                    if (!readHex4(text, pos + 1, codePoint)) {
+                        return fail("无效的 \\u 转义");
+                    }
+                    pos += 5;
+                    continue;
+                }
+                if (escape != '"' && escape != '\\' && escape != '/' && escape != 'b' &&
+                    escape != 'f' && escape != 'n' && escape != 'r' && escape != 't') {
+                    return fail("无效的转义字符");
+                }
+                ++pos;
+                continue;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("字符串中有未转义的控制字符");
+            }
+            ++pos;
+        }
+        return fail("字符串未结束");
+    }
+
+    bool parseLiteral(std::string_view literal) {
+        if (text.substr(pos, literal.size()) != literal) {
+            return fail("无法识别的值");
+        }
+        pos += literal.size();
+        return true;
+    }
+
+    bool parseValue(uint32_t& index, int depth) {
+        skipWhitespace();
+        if (pos >= text.size()) {
+            return fail("意外的结尾");
+        }
+        if (depth > MAX_DEPTH) {
+            return fail("嵌套层数过多");
+        }
+
+        char c = text[pos];
+        switch (c) {
+            case '{': {
+                index = newNode(JsonValue::Type::Object);
+                ++pos;
+                skipWhitespace();
+                if (peek('}')) {
+                    ++pos;
+                    return true;
+                }
+                while (true) {
+                    skipWhitespace();
+                    if (!peek('"')) {
+                        return fail("缺少对象成员的键");
+                    }
+                    std::string_view key;
+                    bool keyEscapes;
+                    if (!parseString(key, keyEscapes)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (!peek(':')) {
+                        return fail("缺少 ':'");
+                    }
+                    ++pos;
+                    uint32_t child;
+                    if (!parseValue(child, depth + 1)) {
+                        return false;
+                    }
+                    nodes[child].key = key;
+                    append(index, child);
+                    skipWhitespace();
+                    if (peek(',')) {
+                        ++pos;
+                        continue;
+                    }
+                    if (peek('}')) {
+                        ++pos;
+                        return true;
+                    }
+                    return fail("缺少 ',' 或 '}'");
+                }
+            }
+            case '[': {
+                index = newNode(JsonValue::Type::Array);
+                ++pos;
+                skipWhitespace();
+                if (peek(']')) {
+                    ++pos;
+                    return true;
+                }
+                while (true) {
+                    uint32_t child;
+                    if (!parseValue(child, depth + 1)) {
+                        return false;
+                    }
+                    append(index, child);
+                    skipWhitespace();
+                    if (peek(',')) {
+                        ++pos;
+                        continue;
+                    }
+                    if (peek(']')) {
+                        ++pos;
+                        return true;
+                    }
+                    return fail("缺少 ',' 或 ']'");
+                }
+            }
+            case '"': {
+                index = newNode(JsonValue::Type::String);
+                std::string_view value;
+                bool hasEscapes;
+                if (!parseString(value, hasEscapes)) {
+                    return false;
+                }
+                nodes[index].text = value;
+                nodes[index].hasEscapes = hasEscapes;
+                return true;
+            }
+            case 't':
+                index = newNode(JsonValue::Type::Bool);
+                nodes[index].boolean = true;
+                return parseLiteral("true");
+            case 'f':
+                index = newNode(JsonValue::Type::Bool);
+                return parseLiteral("false");
+            case 'n':
+                index = newNode(JsonValue::Type::Null);
+                return parseLiteral("null");
+            default: {
+                if (c != '-' && (c < '0' || c > '9')) {
+                    return fail("意外的字符");
+                }
+                size_t start = pos;
+                while (pos < text.size() && isNumberChar(text[pos])) {
+                    ++pos;
+                }
+                double value = 0.0;
+                auto [end, ec] = std::from_chars(text.data() + start, text.data() + pos, value);
+                if (ec != std::errc() || end != text.data() + pos) {
+                    pos = start;
+                    return fail("无效的数值");
+                }
+                index = newNode(JsonValue::Type::Number);
+                nodes[index].text = text.substr(start, pos - start);
+                nodes[index].number = value;
+                return true;
+            }
+        }
+    }
+};
+
+bool JsonDocument::parse(std::string_view text, bool allowTrailing) {
+    nodes.clear();
+    errorMessage.clear();
+
+    // 跳过 UTF-8 BOM
+    size_t offset = text.substr(0, 3) == "\xEF\xBB\xBF" ? 3 : 0;
+
+    // 节点数大致与数值和字符串的数量成正比，预留空间以减少扩容
+    nodes.reserve(text.size() / 6 + 4);
+
+    Parser parser(text, nodes);
+    parser.pos = offset;
+    uint32_t rootIndex = 0;
+    bool ok = parser.parseValue(rootIndex, 0);
+    if (ok && !allowTrailing) {
+        parser.skipWhitespace();
+        if (parser.pos < text.size()) {
+            ok = parser.fail("根值之后还有多余的内容");
+        }
+    }
+
+    if (!ok) {
+        // 计算出错位置的行列号
+        size_t line = 1;
+        size_t column = 1;
+        for (size_t i = 0; i < parser.pos && i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                ++line;
+                column = 1;
+            } else {
+                ++column;
+            }
+        }
+        errorMessage = "JSON解析错误（第" + std::to_string(line) + "行第" + std::to_string(column) + "列）: " + parser.failure;
+        nodes.clear();
+        return false;
+    }
+    return true;
+}
+
+bool JsonDocument::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        nodes.clear();
+        errorMessage = "无法打开文件 " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    ownedText = buffer.str();
+    return parse(ownedText);
+}
+
+JsonValue JsonDocument::root() const {
+    return nodes.empty() ? JsonValue() : JsonValue(this, 0);
+}
+
+JsonValue::Type JsonValue::type() const {
+    if (!document || index >= document->nodes.size()) {
+        return Type::Missing;
+    }
+    return document->nodes[index].type;
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const {
+    if (!isObject()) {
+        return JsonValue();
+    }
+    for (uint32_t child = document->nodes[index].firstChild; child != JsonDocument::NO_NODE;
+         child = document->nodes[child].nextSibling) {
+        if (document->nodes[child].key == key) {
+            return JsonValue(document, child);
+        }
+    }
+    return JsonValue();
+}
+
+size_t JsonValue::size() const {
+    Type t = type();
+    return t == Type::Array || t == Type::Object ? document->nodes[index].childCount : 0;
+}
+
+JsonValue JsonValue::first() const {
+    Type t = type();
+    if ((t != Type::Array && t != Type::Object) || document->nodes[index].firstChild == JsonDocument::NO_NODE) {
+        return JsonValue();
+    }
+    return JsonValue(document, document->nodes[index].firstChild);
+}
+
+JsonValue JsonValue::next() const {
+    if (!exists() || document->nodes[index].nextSibling == JsonDocument::NO_NODE) {
+        return JsonValue();
+    }
+    return JsonValue(document, document->nodes[index].nextSibling);
+}
+
+std::string_view JsonValue::key() const {
+    return exists() ? document->nodes[index].key : std::string_view();
+}
+
+double JsonValue::asDouble(double fallback) const {
+    return isNumber() ? document->nodes[index].number : fallback;
+}
+
+int64_t JsonValue::asInt(int64_t fallback) const {
+    if (!isNumber()) {
+        return fallback;
+    }
+    std::string_view text = document->nodes[index].text;
+    int64_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && end == text.data() + text.size()) {
+        return value;
+    }
+    // 1.0、1e3 之类的整数值
+    double number = document->nodes[index].number;
+    if (std::floor(number) == number && std::fabs(number) < 9.0e15) {
+        return static_cast<int64_t>(number);
+    }
+    return fallback;
+}
+
+uint64_t JsonValue::asUnsigned(uint64_t fallback) const {
+    if (!isNumber()) {
+        return fallback;
+    }
+    std::string_view text = document->nodes[index].text;
+    uint64_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && end == text.data() + text.size()) {
+        return value;
+    }
+    double number = document->nodes[index].number;
+    if (number >= 0.0 && std::floor(number) == number && number < 9.0e15) {
+        return static_cast<uint64_t>(number);
+    }
+    return fallback;
+}
+
+bool JsonValue::asBool(bool fallback) const {
+    return isBool() ? document->nodes[index].boolean : fallback;
+}
+
+std::string JsonValue::asString(const std::string& fallback) const {
+    if (!isString()) {
+        return fallback;
+    }
+    const JsonDocument::Node& node = document->nodes[index];
+    if (!node.hasEscapes) {
+        return std::string(node.text);
+    }
+    std::string result;
+    if (!unescapeJsonString(node.text, result)) {
+        return fallback;
+    }
+    return result;
+}
+
+std::string_view JsonValue::raw() const {
+    return exists() ? document->nodes[index].text : std::string_view();
+}
+
+void appendJsonEscaped(std::string& out, std::string_view text) {
+    static const char hexDigits[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // 不需要转义的连续字符整段追加
+        out.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+}
+
+void JsonWriter::beforeValue() {
+    if (current.afterKey) {
+        current.afterKey = false;
+        return;
+    }
+    if (current.depth == 0 || current.depth > 64) {
+        return;
+    }
+    uint64_t bit = uint64_t{1} << (current.depth - 1);
+    if (current.hasElements & bit) {
+        out += ',';
+    }
+    current.hasElements |= bit;
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    beforeValue();
+    out += '{';
+    ++current.depth;
+    if (current.depth <= 64) {
+        current.hasElements &= ~(uint64_t{1} << (current.depth - 1));
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out += '}';
+    --current.depth;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    beforeValue();
+    out += '[';
+    ++current.depth;
+    if (current.depth <= 64) {
+        current.hasElements &= ~(uint64_t{1} << (current.depth - 1));
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out += ']';
+    --current.depth;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    beforeValue();
+    out += '"';
+    appendJsonEscaped(out, name);
+    out += "\":";
+    current.afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::string(std::string_view text) {
+    return beginString().stringPart(text).endString();
+}
+
+JsonWriter& JsonWriter::integer(int64_t value) {
+    beforeValue();
+    char digits[24];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+    return *this;
+}
+
+JsonWriter& JsonWriter::number(double value) {
+    if (!std::isfinite(value)) {
+        return null();
+    }
+    beforeValue();
+    char digits[32];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+    return *this;
+}
+
+JsonWriter& JsonWriter::boolean(bool value) {
+    beforeValue();
+    out += value ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    beforeValue();
+    out += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginString() {
+    beforeValue();
+    out += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::stringPart(std::string_view text) {
+    appendJsonEscaped(out, text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::stringPart(int64_t value) {
+    char digits[24];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endString() {
+    out += '"';
+    return *this;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class JsonDocument;
+
+// JSON值句柄：指向 JsonDocument 中的一个节点，复制开销很小，文档销毁后失效
+// 访问不存在的成员或类型不符时不会抛异常，而是返回 Missing 值或调用方给出的默认值
+class JsonValue {
+public:
+    enum class Type : uint8_t { Missing, Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+
+    Type type() const;
+    bool exists() const { return type() != Type::Missing; }
+    explicit operator bool() const { return exists(); }
+
+    bool isNull() const { return type() == Type::Null; }
+    bool isBool() const { return type() == Type::Bool; }
+    bool isNumber() const { return type() == Type::Number; }
+    bool isString() const { return type() == Type::String; }
+    bool isArray() const { return type() == Type::Array; }
+    bool isObject() const { return type() == Type::Object; }
+
+    // 对象成员（按原文比较键，不存在或不是对象时返回 Missing）
+    JsonValue operator[](std::string_view key) const;
+
+    // 数组元素或对象成员的数量
+    size_t size() const;
+
+    // 遍历数组元素/对象成员：for (JsonValue item = array.first(); item; item = item.next())
+    JsonValue first() const;
+    JsonValue next() const;
+
+    // 对象成员的键（原文，未还原转义）
+    std::string_view key() const;
+
+    // 数值（不是数值时返回 fallback）
+    double asDouble(double fallback = 0.0) const;
+    int64_t asInt(int64_t fallback = 0) const;        // 非整数时返回 fallback
+    uint64_t asUnsigned(uint64_t fallback = 0) const; // 负数或非整数时返回 fallback
+    bool asBool(bool fallback = false) const;
+
+    // 字符串（还原转义字符，不是字符串时返回 fallback）
+    std::string asString(const std::string& fallback = std::string()) const;
+
+    // 字符串原文（不含引号，未还原转义）或数值原文
+    std::string_view raw() const;
+
+private:
+    friend class JsonDocument;
+    JsonValue(const JsonDocument* document, uint32_t index) : document(document), index(index) {}
+
+    const JsonDocument* document = nullptr;
+    uint32_t index = 0;
+};
+
+// JSON文档：单遍解析为连续存放的节点数组
+// 字符串和数值只记录其在原文中的位置（string_view），数值在解析时用 std::from_chars 转换
+// 因此 parse() 的原文必须在文档使用期间保持有效；load() 读取的文件内容由文档自己保存
+class JsonDocument {
+public:
+    JsonDocument() = default;
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    // 解析 text（开头的 UTF-8 BOM 会被跳过）；allowTrailing 为 true 时允许根值之后还有其他内容
+    // 失败时返回 false，error() 给出行列位置和原因
+    bool parse(std::string_view text, bool allowTrailing = false);
+
+    // 读取并解析文件
+    bool load(const std::string& path);
+
+    // 根值（解析失败时为 Missing）
+    JsonValue root() const;
+
+    const std::string& error() const { return errorMessage; }
+
+    // 节点数量（用于统计）
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    friend class JsonValue;
+    struct Parser;
+
+    static constexpr uint32_t NO_NODE = 0xFFFFFFFFu;
+
+    struct Node {
+        JsonValue::Type type = JsonValue::Type::Null;
+        bool hasEscapes = false;        // 字符串中含有转义字符
+        bool boolean = false;
+        uint32_t firstChild = NO_NODE;
+        uint32_t lastChild = NO_NODE;
+        uint32_t nextSibling = NO_NODE;
+        uint32_t childCount = 0;
+        std::string_view key;           // 作为对象成员时的键
+        std::string_view text;          // 字符串/数值原文
+        double number = 0.0;
+    };
+
+    std::vector<Node> nodes;
+    std::string ownedText;
+    std::string errorMessage;
+};
+
+// 把JSON字符串原文（不含引号）中的转义字符还原后追加到 out，格式错误时返回 false
+bool unescapeJsonString(std::string_view raw, std::string& out);
+
+// 把 text 转义为JSON字符串内容（不含引号）追加到 out
+void appendJsonEscaped(std::string& out, std::string_view text);
+
+// JSON写入器：把JSON文本追加到调用方提供的缓冲区，自动处理逗号和字符串转义
+// 缓冲区可以在多次请求之间复用（clear/assign 后容量保留），容量足够时写入过程不分配内存
+// 字符串值可以分段写入（beginString / stringPart / endString），拼接提示词时不必先生成中间字符串
+class JsonWriter {
+public:
+    // 写入器的嵌套状态：在某个位置保存状态，之后可以在内容相同的缓冲区上继续写入（预编译的请求模板）
+    struct State {
+        uint64_t hasElements = 0;   // 每层容器是否已写入元素（按位，最多64层）
+        uint8_t depth = 0;
+        bool afterKey = false;      // 刚写完键，下一个值前不加逗号
+    };
+
+    explicit JsonWriter(std::string& out) : out(out) {}
+    JsonWriter(std::string& out, const State& state) : out(out), current(state) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    // 对象成员的键
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& string(std::string_view text);
+    JsonWriter& integer(int64_t value);
+    JsonWriter& number(double value);     // 非有限值写为 null
+    JsonWriter& boolean(bool value);
+    JsonWriter& null();
+
+    // 分段写入一个字符串值：beginString()、若干次 stringPart()、endString()
+    JsonWriter& beginString();
+    JsonWriter& stringPart(std::string_view text);
+    JsonWriter& stringPart(int64_t value);
+    JsonWriter& endString();
+
+    State state() const { return current; }
+
+private:
+    std::string& out;
+    State current;
+
+    // 写入值之前：按需加逗号
+    void beforeValue();
+};
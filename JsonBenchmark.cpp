@@ -0,0 +1,195 @@
+// JSON基准测试：测量 LLM 响应、批量响应和配置文件的解析耗时与内存分配次数，以及请求体的构建开销
+// 用法: json_benchmark [迭代次数]
+#include "Json.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+// 统计全局 operator new 的调用次数
+static std::atomic<uint64_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    std::string escapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            switch (c) {
+                case '"':  escaped += "\\\""; break;
+                case '\\': escaped += "\\\\"; break;
+                case '\n': escaped += "\\n"; break;
+                default:   escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+
+    // 一个包含10个选项、每个选项两个12维向量的事件（与 LLMClient 请求的格式相同）
+    std::string buildEvent(int id) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "{\n  \"name\": \"事件" << id << "\",\n  \"description\": \"一段用于测试的\\\"事件\\\"描述\",\n  \"options\": [\n";
+        for (int i = 0; i < 10; ++i) {
+            out << "    {\n      \"text\": \"选项" << i << "\",\n      \"decisionRequirement\": [";
+            for (int d = 0; d < 12; ++d) {
+                out << (d ? ", " : "") << (0.05 * ((i + d) % 20));
+            }
+            out << "],\n      \"decisionFeedback\": [";
+            for (int d = 0; d < 12; ++d) {
+                out << (d ? ", " : "") << (0.01 * ((i * d) % 21) - 0.1);
+            }
+            out << "],\n      \"outcomeText\": \"结果" << i << "\"\n    }" << (i < 9 ? "," : "") << "\n";
+        }
+        out << "  ]\n}";
+        return out.str();
+    }
+
+    // OpenAI 兼容响应：content 为转义后的事件JSON
+    std::string buildResponse(const std::string& content) {
+        return "{\"id\": \"chatcmpl-1\", \"object\": \"chat.completion\", \"choices\": [{\"index\": 0, "
+               "\"message\": {\"role\": \"assistant\", \"content\": \"" + escapeJson(content) + "\"}, "
+               "\"finish_reason\": \"stop\"}], \"usage\": {\"prompt_tokens\": 512, \"completion_tokens\": 1400}}";
+    }
+
+    // 遍历整个文档，读取所有字符串和数值（模拟把事件转换为 RandomEvent）
+    double walk(const JsonValue& value, size_t& strings) {
+        double sum = 0.0;
+        if (value.isNumber()) {
+            return value.asDouble();
+        }
+        if (value.isString()) {
+            strings += value.asString().size();
+            return 0.0;
+        }
+        for (JsonValue child = value.first(); child; child = child.next()) {
+            sum += walk(child, strings);
+        }
+        return sum;
+    }
+
+    template <typename Body>
+    void run(const char* name, size_t bytes, int iterations, Body body) {
+        body();  // 预热
+        uint64_t allocationsBefore = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            body();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t allocations = allocationCount - allocationsBefore;
+
+        std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(10) << seconds * 1e6 / iterations << " us/次"
+                  << std::setw(10) << bytes * iterations / seconds / 1e6 << " MB/s"
+                  << std::setw(10) << static_cast<double>(allocations) / iterations << " 次分配/次" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+
+    std::string event = buildEvent(0);
+    std::string response = buildResponse(event);
+
+    std::string batch = "[";
+    for (int i = 0; i < 16; ++i) {
+        batch += (i ? ",\n" : "") + buildEvent(i);
+    }
+    batch += "]";
+    std::string batchResponse = buildResponse(batch);
+
+    std::string config = "\xEF\xBB\xBF{\n  \"openai_api_key\": \"your_api_key_here\",\n  \"openai_model\": \"gpt-3.5-turbo\",\n"
+                         "  \"llm_timeout_seconds\": 30,\n  \"max_retries\": 3,\n  \"num_agents\": 12,\n"
+                         "  \"random_seed\": 18446744073709551615,\n  \"broadcast_events\": false,\n  \"llm_system_prompt\": \"\"\n}\n";
+
+    std::cout << "迭代次数: " << iterations << "，事件响应 " << response.size() << " 字节，批量响应 "
+              << batchResponse.size() << " 字节" << std::endl;
+
+    volatile double sink = 0.0;
+    JsonDocument reused;
+    JsonDocument content;
+
+    run("响应解析（复用文档）", response.size(), iterations, [&]() {
+        reused.parse(response);
+        sink = sink + static_cast<double>(reused.nodeCount());
+    });
+
+    run("响应解析（新建文档）", response.size(), iterations, [&]() {
+        JsonDocument document;
+        document.parse(response);
+        sink = sink + static_cast<double>(document.nodeCount());
+    });
+
+    run("事件解码（响应+content）", response.size(), iterations, [&]() {
+        reused.parse(response);
+        std::string text = reused.root()["choices"].first()["message"]["content"].asString();
+        content.parse(text);
+        size_t strings = 0;
+        sink = sink + walk(content.root(), strings) + static_cast<double>(strings);
+    });
+
+    run("批量事件解码（16个）", batchResponse.size(), std::max(1, iterations / 16), [&]() {
+        reused.parse(batchResponse);
+        std::string text = reused.root()["choices"].first()["message"]["content"].asString();
+        content.parse(text);
+        size_t strings = 0;
+        sink = sink + walk(content.root(), strings) + static_cast<double>(strings);
+    });
+
+    run("配置读取", config.size(), iterations, [&]() {
+        reused.parse(config);
+        JsonValue root = reused.root();
+        sink = sink + static_cast<double>(root["random_seed"].asUnsigned() & 1) + root["max_retries"].asInt()
+                    + static_cast<double>(root["openai_model"].raw().size());
+    });
+
+    // 请求体构建：每次拼接并重新转义系统提示 vs. 预编译模板 + 复用缓冲区
+    std::string systemPrompt;
+    for (int i = 0; i < 24; ++i) {
+        systemPrompt += "请生成一个随机事件，用于12维决策向量的模拟。\n{\"name\": \"事件名称\", \"options\": [...]}\n";
+    }
+    std::string model = "gpt-3.5-turbo";
+
+    run("请求体拼接（每次转义）", systemPrompt.size(), iterations, [&]() {
+        std::string body = "{\"model\": \"" + model + "\", \"messages\": [{\"role\": \"user\", \"content\": \"" +
+                           escapeJson(systemPrompt) + "\"}], \"stream\": false, \"max_tokens\": " + std::to_string(1500) + "}";
+        sink = sink + static_cast<double>(body.size());
+    });
+
+    std::string prefix;
+    JsonWriter templateWriter(prefix);
+    templateWriter.beginObject().key("model").string(model).key("messages").beginArray();
+    templateWriter.beginObject().key("role").string("user").key("content").beginString().stringPart(systemPrompt);
+    JsonWriter::State prefixState = templateWriter.state();
+    std::string buffer;
+
+    run("请求体构建（预编译模板）", systemPrompt.size(), iterations, [&]() {
+        buffer.assign(prefix);
+        JsonWriter writer(buffer, prefixState);
+        writer.endString().endObject().endArray().key("stream").boolean(false).key("max_tokens").integer(1500).endObject();
+        sink = sink + static_cast<double>(buffer.size());
+    });
+
+    return sink == -1.0 ? 1 : 0;
+}
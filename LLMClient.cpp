@@ -1,4 +1,10 @@
 #include "LLMClient.h"
+#include "CounterRng.h"
+#include "EventStore.h"
+#include "StreamingEventParser.h"
+#include "Json.h"
+#include "Logger.h"
+#include "ParallelFor.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -6,63 +12,151 @@
 #include <chrono>
 #include <thread>
 #include <stdexcept>
-
-#ifdef _WIN32
-#include <windows.h>
-#include <winhttp.h>
-#pragma comment(lib, "winhttp.lib")
-#endif
-
-// Unicode转换辅助函数
-#ifdef _WIN32
-namespace {
-    std::string wideStringToString(const std::wstring& wstr) {
-        if (wstr.empty()) return "";
-        int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-        std::string strTo(size_needed, 0);
-        WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-        return strTo;
-    }
-    
-    std::wstring stringToWideString(const std::string& str) {
-        if (str.empty()) return L"";
-        int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-        std::wstring wstrTo(size_needed, 0);
-        MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
-        return wstrTo;
-    }
-}
-#endif
+#include <algorithm>
+#include <filesystem>
+#include <charconv>
+#include <cstdio>
 
 // JSON转义辅助函数
 namespace {
     std::string escapeJsonString(const std::string& str) {
         std::string escaped;
-        escaped.reserve(str.length() * 2); // 粗略估计
-        for (char c : str) {
-            switch (c) {
-                case '"':  escaped += "\\\""; break;
-                case '\\': escaped += "\\\\"; break;
-                case '/':  escaped += "\\/"; break;
-                case '\b': escaped += "\\b"; break;
-                case '\f': escaped += "\\f"; break;
-                case '\n': escaped += "\\n"; break;
-                case '\r': escaped += "\\r"; break;
-                case '\t': escaped += "\\t"; break;
-                default:
-                    // 转义控制字符 (0x00-0x1F)
-                    if (c >= 0 && c <= 0x1F) {
-                        char buf[7];
-                        snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
-                        escaped += buf;
-                    } else {
-                        escaped += c;
-                    }
-                    break;
+        appendJsonEscaped(escaped, str);
+        return escaped;
+    }
+    
+    // 每个线程复用的请求体缓冲区（容量保留，稳定后构建请求体不再分配内存）
+    std::string& requestBuffer() {
+        thread_local std::string buffer;
+        return buffer;
+    }
+    
+    // 读取决策向量：缺失时保留原值（默认值）并返回 true；
+    // 不是恰好12个数值的数组时返回 false（与 StreamingEventParser 拒绝的输入一致）
+    bool readDecisionVector(const JsonValue& array, DecisionVector& target) {
+        if (!array) {
+            return true;
+        }
+        if (!array.isArray() || array.size() != DecisionVector::DIMENSIONS) {
+            return false;
+        }
+        DecisionVector values;
+        size_t i = 0;
+        for (JsonValue item = array.first(); item; item = item.next()) {
+            if (!item.isNumber()) {
+                return false;
             }
+            values[i++] = item.asDouble();
         }
-        return escaped;
+        target = values;
+        return true;
     }
+    
+    // 把一个事件对象转换为 RandomEvent，缺少名称、描述或选项，或决策向量格式错误时返回 false
+    bool readEvent(const JsonValue& object, LLMClient::RandomEvent& event) {
+        event.name = object["name"].asString();
+        event.description = object["description"].asString();
+        if (event.name.empty() || event.description.empty()) {
+            return false;
+        }
+        
+        JsonValue options = object["options"];
+        event.options.clear();
+        event.options.reserve(options.size());
+        for (JsonValue item = options.first(); item; item = item.next()) {
+            LLMClient::EventOption option;
+            // 向量缺失时使用默认值
+            option.decisionRequirement.fill(0.5);
+            option.decisionFeedback.fill(0.1);
+            option.text = item["text"].asString();
+            option.outcomeText = item["outcomeText"].asString();
+            if (!readDecisionVector(item["decisionRequirement"], option.decisionRequirement) ||
+                !readDecisionVector(item["decisionFeedback"], option.decisionFeedback)) {
+                return false;
+            }
+            event.options.push_back(std::move(option));
+        }
+        return !event.options.empty();
+    }
+    
+    // 模型输出中JSON开始的位置：跳过 <think> 段、说明文字和代码块标记
+    size_t findJsonStart(const std::string& content) {
+        size_t thinkEnd = content.find("</think>");
+        return content.find_first_of("{[", thinkEnd == std::string::npos ? 0 : thinkEnd + 8);
+    }
+    
+    // 第一个choice的内容：非流式响应为 message.content，流式片段为 delta.content
+    JsonValue choiceContent(const JsonValue& root, const char* field) {
+        JsonValue content = root["choices"].first()[field]["content"];
+        if (!content) {
+            // 不带 choices 的旧格式
+            content = root[field]["content"];
+        }
+        return content;
+    }
+    
+    // 服务器推送事件（SSE）解码：按行切分响应体，把每个 "data:" 行的内容交给回调
+    class SseDecoder {
+    public:
+        // 输入一段响应体，回调返回 false 时停止并返回 false
+        template <typename Callback>
+        bool feed(const char* data, size_t size, Callback&& onPayload) {
+            pending.append(data, size);
+            size_t lineStart = 0;
+            size_t lineEnd;
+            bool keepGoing = true;
+            while (keepGoing && (lineEnd = pending.find('\n', lineStart)) != std::string::npos) {
+                std::string line = pending.substr(lineStart, lineEnd - lineStart);
+                lineStart = lineEnd + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (line.compare(0, 5, "data:") != 0) {
+                    continue;
+                }
+                size_t payloadStart = line.size() > 5 && line[5] == ' ' ? 6 : 5;
+                ++payloadCount;
+                if (line.compare(payloadStart, std::string::npos, "[DONE]") == 0) {
+                    continue;
+                }
+                keepGoing = onPayload(line.substr(payloadStart));
+            }
+            pending.erase(0, lineStart);
+            return keepGoing;
+        }
+        
+        // 收到的 data 行数量（为0说明服务器没有使用流式响应）
+        size_t getPayloadCount() const { return payloadCount; }
+        
+    private:
+        std::string pending;
+        size_t payloadCount = 0;
+    };
+    
+    // 选择请求中LLM看到的事件内容（描述、选项文本和结果文本）的哈希
+    uint64_t hashChoiceEvent(const std::string& eventDescription, const std::vector<LLMClient::EventOption>& options) {
+        ChoiceCache::EventHasher hasher;
+        hasher.add(eventDescription);
+        for (const auto& option : options) {
+            hasher.add(option.text);
+            hasher.add(option.outcomeText);
+        }
+        return hasher.value();
+    }
+    
+    // 事件生成请求中的 system 消息
+    constexpr const char* EVENT_GENERATOR_ROLE = "你是一个情感决策模拟系统的事件生成器。";
+    
+    // 把响应（或流式片段）中的 usage 计入 token 用量，没有 usage 时不记录
+    void recordUsage(LLMMetrics& metrics, RetryPolicy::RequestKind kind, const JsonValue& root) {
+        JsonValue usage = root["usage"];
+        if (usage.isObject()) {
+            metrics.recordTokens(kind, usage["prompt_tokens"].asInt(0), usage["completion_tokens"].asInt(0));
+        }
+    }
+    
+    // 保存LLM生成事件的目录（事件库和旧版本的JSON事件文件）
+    constexpr const char* SAVED_EVENTS_DIRECTORY = "llm_events";
 }
 
 // JSON解析简化
@@ -75,6 +169,96 @@ LLMClient& LLMClient::getInstance() {
     return instance;
 }
 
+LLMClient::~LLMClient() {
+    healthMonitor.stopProbing();
+    
+    // 等待落后的对冲请求结束
+    {
+        std::unique_lock<std::mutex> lock(backgroundMutex);
+        backgroundDone.wait(lock, [this]() { return backgroundRequests == 0; });
+    }
+    
+    // 停止后台线程池（等待已提交的任务执行完）
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncStopping = true;
+    }
+    asyncTaskReady.notify_all();
+    for (auto& worker : asyncWorkers) {
+        worker.join();
+    }
+}
+
+void LLMClient::setMaxInFlight(size_t limit) {
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex);
+        maxInFlight = std::max<size_t>(1, limit);
+    }
+    inFlightReleased.notify_all();
+    transport.setMaxIdleConnections(std::max(HttpTransport::DEFAULT_MAX_IDLE_CONNECTIONS, limit));
+}
+
+size_t LLMClient::getMaxInFlight() const {
+    std::lock_guard<std::mutex> lock(inFlightMutex);
+    return maxInFlight;
+}
+
+void LLMClient::setEventBatchSize(size_t size) {
+    eventBatchSize = std::max<size_t>(1, std::min(size, MAX_EVENT_BATCH_SIZE));
+}
+
+size_t LLMClient::getInFlightCount() const {
+    std::lock_guard<std::mutex> lock(inFlightMutex);
+    return inFlight;
+}
+
+void LLMClient::submitAsync(std::function<void()> task) {
+    size_t limit = getMaxInFlight();
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncTasks.push_back(std::move(task));
+        // 按需扩充线程池，最多 maxInFlight 个线程
+        if (asyncWorkers.size() < limit) {
+            asyncWorkers.emplace_back(&LLMClient::asyncWorkerLoop, this);
+        }
+    }
+    asyncTaskReady.notify_one();
+}
+
+void LLMClient::asyncWorkerLoop() {
+    std::unique_lock<std::mutex> lock(asyncMutex);
+    while (true) {
+        asyncTaskReady.wait(lock, [this]() { return asyncStopping || !asyncTasks.empty(); });
+        if (asyncTasks.empty()) {
+            return;
+        }
+        std::function<void()> task = std::move(asyncTasks.front());
+        asyncTasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+std::future<LLMClient::EventHandle> LLMClient::generateRandomEventAsync() {
+    auto task = std::make_shared<std::packaged_task<EventHandle()>>([this]() {
+        return generateRandomEvent();
+    });
+    std::future<EventHandle> result = task->get_future();
+    submitAsync([task]() { (*task)(); });
+    return result;
+}
+
+std::future<int> LLMClient::getLLMChoiceAsync(int agentId, const DecisionVector& decisionVector, EventHandle event) {
+    auto task = std::make_shared<std::packaged_task<int()>>(
+        [this, agentId, decisionVector, event = std::move(event)]() {
+            return getLLMChoice(agentId, decisionVector, event->description, event->options);
+        });
+    std::future<int> result = task->get_future();
+    submitAsync([task]() { (*task)(); });
+    return result;
+}
+
 bool LLMClient::initialize(const std::string& configPath) {
     simulationMode = true; // 默认模拟模式
     apiKey = "";
@@ -85,78 +269,67 @@ bool LLMClient::initialize(const std::string& configPath) {
     maxRetries = 3;
     
     // 尝试读取配置文件
-    std::ifstream configFile(configPath);
-    if (!configFile.is_open()) {
-        std::cerr << "警告: 无法打开配置文件 " << configPath << "，使用模拟模式。" << std::endl;
+    std::error_code existsError;
+    if (!std::filesystem::exists(configPath, existsError)) {
+        LOG_WARN("警告: 无法打开配置文件 " << configPath << "，使用模拟模式。");
         return true; // 模拟模式仍然可用
     }
     
     try {
-        // 简单JSON解析（实际项目应使用JSON库）
-        std::string line;
-        while (std::getline(configFile, line)) {
-            if (line.find("\"openai_api_key\"") != std::string::npos) {
-                size_t colonPos = line.find(':');
-                size_t quoteStart = line.find('"', colonPos + 1);
-                size_t quoteEnd = line.find('"', quoteStart + 1);
-                if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-                    apiKey = line.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                }
-            }
-            else if (line.find("\"openai_model\"") != std::string::npos) {
-                size_t colonPos = line.find(':');
-                size_t quoteStart = line.find('"', colonPos + 1);
-                size_t quoteEnd = line.find('"', quoteStart + 1);
-                if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-                    model = line.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                }
-            }
-            else if (line.find("\"openai_base_url\"") != std::string::npos) {
-                size_t colonPos = line.find(':');
-                size_t quoteStart = line.find('"', colonPos + 1);
-                size_t quoteEnd = line.find('"', quoteStart + 1);
-                if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-                    baseUrl = line.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                }
-            }
-            else if (line.find("\"llm_timeout_seconds\"") != std::string::npos) {
-                size_t colonPos = line.find(':');
-                size_t valueStart = line.find_first_not_of(" \t", colonPos + 1);
-                size_t valueEnd = line.find_last_not_of(" \t,}");
-                if (valueStart != std::string::npos) {
-                    timeoutSeconds = std::stoi(line.substr(valueStart, valueEnd - valueStart + 1));
-                }
-            }
-            else if (line.find("\"max_retries\"") != std::string::npos) {
-                size_t colonPos = line.find(':');
-                size_t valueStart = line.find_first_not_of(" \t", colonPos + 1);
-                size_t valueEnd = line.find_last_not_of(" \t,}");
-                if (valueStart != std::string::npos) {
-                    maxRetries = std::stoi(line.substr(valueStart, valueEnd - valueStart + 1));
-                }
-            }
-            else if (line.find("\"llm_system_prompt\"") != std::string::npos) {
-                size_t colonPos = line.find(':');
-                size_t quoteStart = line.find('"', colonPos + 1);
-                size_t quoteEnd = line.find('"', quoteStart + 1);
-                if (quoteStart != std::string::npos && quoteEnd != std::string::npos) {
-                    systemPrompt = line.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                    // 处理转义字符
-                    size_t escapePos;
-                    while ((escapePos = systemPrompt.find("\\n")) != std::string::npos) {
-                        systemPrompt.replace(escapePos, 2, "\n");
-                    }
-                    while ((escapePos = systemPrompt.find("\\\"")) != std::string::npos) {
-                        systemPrompt.replace(escapePos, 2, "\"");
-                    }
-                    while ((escapePos = systemPrompt.find("\\\\")) != std::string::npos) {
-                        systemPrompt.replace(escapePos, 2, "\\");
-                    }
-                }
+        JsonDocument document;
+        if (!document.load(configPath)) {
+            throw std::runtime_error(document.error());
+        }
+        
+        // 未配置的项保留默认值
+        JsonValue config = document.root();
+        apiKey = config["openai_api_key"].asString(apiKey);
+        model = config["openai_model"].asString(model);
+        baseUrl = config["openai_base_url"].asString(baseUrl);
+        timeoutSeconds = static_cast<int>(config["llm_timeout_seconds"].asInt(timeoutSeconds));
+        maxRetries = static_cast<int>(config["max_retries"].asInt(maxRetries));
+        RetryPolicy::Settings retrySettings;
+        retrySettings.maxRetries = maxRetries;
+        retrySettings.baseDelaySeconds = config["llm_retry_base_delay_ms"].asDouble(retrySettings.baseDelaySeconds * 1000.0) / 1000.0;
+        retrySettings.maxDelaySeconds = config["llm_retry_max_delay_ms"].asDouble(retrySettings.maxDelaySeconds * 1000.0) / 1000.0;
+        retrySettings.deadlineSeconds = config["llm_request_deadline_seconds"].asDouble(retrySettings.deadlineSeconds);
+        retrySettings.hedgePercentile = config["llm_hedge_percentile"].asDouble(retrySettings.hedgePercentile);
+        retryPolicy.configure(retrySettings);
+        if (JsonValue maxInFlightValue = config["llm_max_in_flight"]) {
+            setMaxInFlight(static_cast<size_t>(std::max<int64_t>(1, maxInFlightValue.asInt(DEFAULT_MAX_IN_FLIGHT))));
+        }
+        if (JsonValue batchSizeValue = config["llm_event_batch_size"]) {
+            setEventBatchSize(static_cast<size_t>(std::max<int64_t>(1, batchSizeValue.asInt(DEFAULT_EVENT_BATCH_SIZE))));
+        }
+        streamEvents = config["llm_stream_events"].asBool(false);
+        eventLoadThreads = static_cast<unsigned>(std::max<int64_t>(0, config["llm_event_load_threads"].asInt(0)));
+        eventMaxTokens = static_cast<size_t>(std::max<int64_t>(1, config["llm_event_max_tokens"].asInt(DEFAULT_EVENT_MAX_TOKENS)));
+        batchMaxTokens = static_cast<size_t>(std::max<int64_t>(1, config["llm_batch_max_tokens"].asInt(DEFAULT_BATCH_MAX_TOKENS)));
+        
+        // 提示为空时使用默认提示
+        std::string configuredPrompt = config["llm_system_prompt"].asString();
+        if (!configuredPrompt.empty()) {
+            systemPrompt = configuredPrompt;
+        }
+        buildRequestTemplates();
+        
+        // LLM选择缓存（容量为0时禁用）
+        int64_t cacheSize = config["llm_choice_cache_size"].asInt(static_cast<int64_t>(ChoiceCache::DEFAULT_CAPACITY));
+        choiceCache.configure(static_cast<size_t>(std::max<int64_t>(0, cacheSize)),
+                              config["llm_choice_cache_quantum"].asDouble(ChoiceCache::DEFAULT_QUANTUM));
+        choiceCacheFile = config["llm_choice_cache_file"].asString();
+        metricsFile = config["llm_metrics_file"].asString();
+        if (!choiceCacheFile.empty() && choiceCache.isEnabled()) {
+            size_t loaded = choiceCache.load(choiceCacheFile);
+            if (loaded > 0) {
+                LOG_INFO("已从 " << choiceCacheFile << " 加载 " << loaded << " 个缓存的LLM选择");
             }
         }
         
-        configFile.close();
+        // 配置HTTP传输层（保持持久连接）
+        bool transportReady = transport.setBaseUrl(baseUrl);
+        transport.setTimeoutSeconds(timeoutSeconds);
+        transport.setBearerToken(apiKey);
         
         // 决定是否使用模拟模式
         // 规则：如果baseUrl指向本地服务，或apiKey不是默认值，则尝试API模式
@@ -176,33 +349,46 @@ bool LLMClient::initialize(const std::string& configPath) {
             if (isLocalService) {
                 // 本地LLM服务，即使apiKey为默认值也尝试连接
                 simulationMode = false;
-                std::cout << "检测到本地LLM服务，将尝试API连接" << std::endl;
+                LOG_INFO("检测到本地LLM服务，将尝试API连接");
             } else if (isDefaultOpenAI && apiKey != "your_api_key_here" && !apiKey.empty()) {
                 // OpenAI服务且有有效API密钥
                 simulationMode = false;
-                std::cout << "检测到有效OpenAI API配置" << std::endl;
+                LOG_INFO("检测到有效OpenAI API配置");
             } else if (!isDefaultOpenAI && !baseUrl.empty()) {
                 // 其他自定义API端点，尝试连接
                 simulationMode = false;
-                std::cout << "检测到自定义API端点，将尝试连接" << std::endl;
+                LOG_INFO("检测到自定义API端点，将尝试连接");
             }
         }
         
+        if (!simulationMode && !transportReady) {
+            LOG_WARN("LLMClient: 当前平台无法使用API地址 " << baseUrl << "（非Windows平台仅支持 http），使用模拟模式");
+            simulationMode = true;
+        }
+        
+        // 健康监测：连续失败后熔断，API模式下由后台线程探测恢复
+        healthMonitor.configure(
+            static_cast<int>(config["llm_failure_threshold"].asInt(LLMHealthMonitor::DEFAULT_FAILURE_THRESHOLD)),
+            config["llm_circuit_open_seconds"].asDouble(LLMHealthMonitor::DEFAULT_OPEN_SECONDS));
+        if (!simulationMode && config["llm_health_probe"].asBool(true)) {
+            healthMonitor.startProbing([this]() { return probeConnection(); });
+        }
+        
         // 加载已保存的LLM生成事件
         loadSavedEvents();
         
         if (!simulationMode) {
-            std::cout << "LLM客户端初始化成功，使用API模式。" << std::endl;
-            std::cout << "已加载 " << savedEvents.size() << " 个保存的LLM事件作为备用" << std::endl;
+            LOG_INFO("LLM客户端初始化成功，使用API模式。");
+            LOG_INFO("已加载 " << getSavedEventCount() << " 个保存的LLM事件作为备用");
         } else {
-            std::cout << "LLM客户端使用模拟模式。" << std::endl;
-            std::cout << "已加载 " << savedEvents.size() << " 个保存的LLM事件备用" << std::endl;
+            LOG_INFO("LLM客户端使用模拟模式。");
+            LOG_INFO("已加载 " << getSavedEventCount() << " 个保存的LLM事件备用");
         }
         
         return true;
     }
     catch (const std::exception& e) {
-        std::cerr << "配置文件解析错误: " << e.what() << "，使用模拟模式。" << std::endl;
+        LOG_ERROR("配置文件解析错误: " << e.what() << "，使用模拟模式。");
         simulationMode = true;
         return true;
     }
@@ -214,7 +400,8 @@ bool LLMClient::testConnection() {
         return true;
     }
     
-    // 实际API测试
+    // 实际API测试（界面输出直接写控制台，先写完之前的日志）
+    Logger::instance().flush();
     std::cout << "\n=== 测试API连接 ===" << std::endl;
     std::cout << "API地址: " << baseUrl << std::endl;
     std::cout << "模型: " << model << std::endl;
@@ -225,6 +412,7 @@ bool LLMClient::testConnection() {
     std::string testBody = "{\"model\": \"" + model + "\", \"messages\": [{\"role\": \"user\", \"content\": \"Hello\"}], \"stream\": false}";
     std::cout << "测试请求体: " << testBody << std::endl;
     std::string response = sendRequest("v1/chat/completions", testBody);
+    Logger::instance().flush();
     
     if (response.empty()) {
         std::cout << "\nAPI连接测试失败: 服务器无响应" << std::endl;
@@ -247,53 +435,141 @@ bool LLMClient::testConnection() {
     return true;
 }
 
-LLMClient::RandomEvent LLMClient::generateRandomEvent() {
+LLMClient::EventHandle LLMClient::generateRandomEvent() {
     // 首先尝试使用API生成事件
     if (!simulationMode) {
-        try {
-            // 使用配置中的systemPrompt
-            std::string prompt = systemPrompt;
-            
-            // 构建请求体
-            std::string requestBody = "{\"model\": \"" + model + "\", \"messages\": [{\"role\": \"system\", \"content\": \"你是一个情感决策模拟系统的事件生成器。\"}, {\"role\": \"user\", \"content\": \"" + escapeJsonString(prompt) + "\"}], \"stream\": false, \"max_tokens\": 1500}";
+        EventHandle event;
+        if (tryGenerateRandomEvent(event)) {
+            return event;
+        }
+        LOG_WARN("LLMClient: API未生成有效事件，使用备用事件");
+    }
+    
+    // 模拟模式或无API连接时，使用保存的事件或生成模拟事件
+    return getSavedRandomEvent();
+}
+
+bool LLMClient::tryGenerateRandomEvent(EventHandle& result, const std::shared_ptr<HttpStopSignal>& stop) {
+    if (simulationMode) {
+        return false;
+    }
+    
+    // 优先返回上一次批量请求留下的事件
+    {
+        std::lock_guard<std::mutex> lock(pendingEventsMutex);
+        if (!pendingEvents.empty()) {
+            result = std::move(pendingEvents.front());
+            pendingEvents.pop_front();
+            return true;
+        }
+    }
+    
+    size_t batchSize = eventBatchSize;
+    if (batchSize > 1) {
+        std::vector<RandomEvent> events;
+        if (tryGenerateRandomEvents(batchSize, events, stop) == 0) {
+            return false;
+        }
+        result = std::make_shared<const RandomEvent>(std::move(events.front()));
+        std::lock_guard<std::mutex> lock(pendingEventsMutex);
+        for (size_t i = 1; i < events.size(); ++i) {
+            pendingEvents.push_back(std::make_shared<const RandomEvent>(std::move(events[i])));
+        }
+        return true;
+    }
+    
+    try {
+        RandomEvent event;
+        
+        if (streamEvents) {
+            LOG_DEBUG("LLMClient: 正在以流式请求生成包含10个选项的事件...");
+            std::vector<RandomEvent> events = generateEventsStreaming(1, eventRequestMaxTokens(1), stop);
+            if (events.empty()) {
+                return false;
+            }
+            event = std::move(events.front());
+        } else {
+            const std::string& requestBody = buildEventRequest(1, eventRequestMaxTokens(1), false);
             
-            std::cout << "LLMClient: 正在向LLM请求生成包含10个选项的事件..." << std::endl;
-            std::string response = sendRequest("v1/chat/completions", requestBody);
+            LOG_DEBUG("LLMClient: 正在向LLM请求生成包含10个选项的事件...");
+            std::string response = sendRequest("v1/chat/completions", requestBody, RetryPolicy::RequestKind::Event, stop);
             
             if (response.empty()) {
-                std::cerr << "LLMClient: API响应为空，使用备用事件" << std::endl;
-                // 尝试使用保存的事件
-                return getSavedRandomEvent();
+                if (!(stop && stop->stopRequested())) {
+                    LOG_WARN("LLMClient: API响应为空");
+                }
+                return false;
             }
             
             // 尝试解析LLM响应为JSON事件
-            RandomEvent event = parseEventResponse(response);
+            event = parseEventResponse(response);
+        }
+        
+        // 验证事件是否符合要求（10个选项，12维向量）
+        if (validateEvent(event)) {
+            metrics.countOutcome(LLMMetrics::Outcome::EventValid);
+            LOG_DEBUG("LLMClient: 成功使用API生成有效事件，正在保存...");
+            // 保存事件到事件库，以便后续使用
+            saveEvent(event);
+            result = std::make_shared<const RandomEvent>(std::move(event));
+            return true;
+        } else {
+            metrics.countOutcome(LLMMetrics::Outcome::EventInvalid);
+            LOG_WARN("LLMClient: LLM生成的事件无效");
+            return false;
+        }
+        
+    } catch (const std::exception& e) {
+        LOG_ERROR("LLMClient: Exception in generateRandomEvent: " << e.what());
+        return false;
+    }
+}
+
+size_t LLMClient::tryGenerateRandomEvents(size_t count, std::vector<RandomEvent>& events,
+                                          const std::shared_ptr<HttpStopSignal>& stop) {
+    if (simulationMode || count == 0) {
+        return 0;
+    }
+    count = std::min(count, MAX_EVENT_BATCH_SIZE);
+    
+    try {
+        // 一次请求多个事件，分摊提示词和请求延迟
+        std::vector<RandomEvent> batch;
+        
+        if (streamEvents) {
+            LOG_DEBUG("LLMClient: 正在以流式请求一次生成 " << count << " 个事件...");
+            batch = generateEventsStreaming(count, eventRequestMaxTokens(count), stop);
+        } else {
+            const std::string& requestBody = buildEventRequest(count, eventRequestMaxTokens(count), false);
             
-            // 验证事件是否符合要求（10个选项，12维向量）
-            if (validateEvent(event)) {
-                std::cout << "LLMClient: 成功使用API生成有效事件，正在保存..." << std::endl;
-                // 保存事件到文件，以便后续使用
-                saveEventToFile(event);
-                // 添加到内存缓存
-                savedEvents.push_back(event);
-                std::cout << "LLMClient: 事件已保存并缓存" << std::endl;
-                return event;
-            } else {
-                std::cerr << "LLMClient: LLM生成的事件无效，使用备用事件" << std::endl;
-                return getSavedRandomEvent();
+            LOG_DEBUG("LLMClient: 正在向LLM请求一次生成 " << count << " 个事件...");
+            std::string response = sendRequest("v1/chat/completions", requestBody, RetryPolicy::RequestKind::Event, stop);
+            
+            if (response.empty()) {
+                if (!(stop && stop->stopRequested())) {
+                    LOG_WARN("LLMClient: API响应为空");
+                }
+                return 0;
             }
             
-        } catch (const std::exception& e) {
-            std::cerr << "LLMClient: Exception in generateRandomEvent: " << e.what() << ", using saved events" << std::endl;
-            return getSavedRandomEvent();
+            batch = parseEventBatchResponse(response);
+        }
+        LOG_DEBUG("LLMClient: 批量请求得到 " << batch.size() << "/" << count << " 个有效事件");
+        metrics.countOutcome(LLMMetrics::Outcome::EventValid, batch.size());
+        
+        for (auto& event : batch) {
+            saveEvent(event);
+            events.push_back(std::move(event));
         }
+        return batch.size();
+        
+    } catch (const std::exception& e) {
+        LOG_ERROR("LLMClient: Exception in generateRandomEvents: " << e.what());
+        return 0;
     }
-    
-    // 模拟模式或无API连接时，使用保存的事件或生成模拟事件
-    return getSavedRandomEvent();
 }
 
-int LLMClient::getLLMChoice(int agentId, const std::vector<double>& decisionVector,
+int LLMClient::getLLMChoice(int agentId, const DecisionVector& decisionVector,
                            const std::string& eventDescription,
                            const std::vector<EventOption>& options) {
     if (simulationMode) {
@@ -306,68 +582,99 @@ int LLMClient::getLLMChoice(int agentId, const std::vector<double>& decisionVect
             return -1;
         }
         
-        // 构建提示
-        std::string prompt = "作为情感决策代理#" + std::to_string(agentId) + "，请根据以下情况做出选择：\n";
-        prompt += "事件描述: " + eventDescription + "\n";
-        prompt += "可用选项:\n";
-        for (size_t i = 0; i < options.size(); ++i) {
-            prompt += std::to_string(i + 1) + ". " + options[i].text + " (结果: " + options[i].outcomeText + ")\n";
+        // 相同事件、相近决策向量的选择直接使用缓存
+        uint64_t eventHash = hashChoiceEvent(eventDescription, options);
+        int cachedChoice = -1;
+        if (choiceCache.lookup(eventHash, decisionVector, cachedChoice) && cachedChoice < static_cast<int>(options.size())) {
+            metrics.countOutcome(LLMMetrics::Outcome::ChoiceCached);
+            return cachedChoice;
         }
-        prompt += "请只返回选择的选项编号（1-" + std::to_string(options.size()) + "），不要包含其他文字。";
         
-        // 构建请求体
-        std::string requestBody = "{\"model\": \"" + model + "\", \"messages\": [{\"role\": \"user\", \"content\": \"" + escapeJsonString(prompt) + "\"}], \"stream\": false, \"max_tokens\": 50}";
+        // 构建请求体：固定部分来自预编译模板，提示词直接转义写入复用的缓冲区
+        std::string& requestBody = requestBuffer();
+        requestBody.assign(choiceRequestTemplate.prefix);
+        JsonWriter writer(requestBody, choiceRequestTemplate.state);
+        writer.stringPart("作为情感决策代理#").stringPart(agentId).stringPart("，请根据以下情况做出选择：\n");
+        writer.stringPart("事件描述: ").stringPart(eventDescription).stringPart("\n");
+        writer.stringPart("可用选项:\n");
+        for (size_t i = 0; i < options.size(); ++i) {
+            writer.stringPart(static_cast<int64_t>(i + 1)).stringPart(". ").stringPart(options[i].text)
+                  .stringPart(" (结果: ").stringPart(options[i].outcomeText).stringPart(")\n");
+        }
+        writer.stringPart("请只返回选择的选项编号（1-").stringPart(static_cast<int64_t>(options.size()))
+              .stringPart("），不要包含其他文字。");
+        writer.endString().endObject().endArray().endObject();
         
-        std::string response = sendRequest("v1/chat/completions", requestBody);
+        std::string response = sendRequest("v1/chat/completions", requestBody, RetryPolicy::RequestKind::Choice);
         
         if (response.empty()) {
-            std::cerr << "LLMClient: Empty response for choice, falling back to simulation" << std::endl;
+            LOG_WARN("LLMClient: Empty response for choice, falling back to simulation");
+            metrics.countOutcome(LLMMetrics::Outcome::ChoiceFallback);
             return generateSimulatedChoice(agentId, decisionVector, options);
         }
         
         // 尝试解析响应中的数字
-        size_t contentPos = response.find("\"content\"");
-        if (contentPos == std::string::npos) {
-            std::cerr << "LLMClient: No content in choice response, falling back to simulation" << std::endl;
-            return generateSimulatedChoice(agentId, decisionVector, options);
-        }
-        
-        size_t quoteStart = response.find('"', contentPos + 9);
-        size_t quoteEnd = response.find('"', quoteStart + 1);
-        if (quoteStart == std::string::npos || quoteEnd == std::string::npos) {
-            std::cerr << "LLMClient: Malformed choice response, falling back to simulation" << std::endl;
+        std::string content = extractResponseContent(response, RetryPolicy::RequestKind::Choice);
+        if (content.empty()) {
+            LOG_WARN("LLMClient: No content in choice response, falling back to simulation");
+            metrics.countOutcome(LLMMetrics::Outcome::ChoiceInvalid);
             return generateSimulatedChoice(agentId, decisionVector, options);
         }
         
-        std::string content = response.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-        
-        // 提取数字
+        // 提取 <think> 段之后的第一个整数
         int choice = -1;
-        for (char c : content) {
-            if (c >= '1' && c <= '9') {
-                choice = c - '0';
-                break;
-            }
+        size_t thinkEnd = content.find("</think>");
+        size_t digitPos = content.find_first_of("0123456789", thinkEnd == std::string::npos ? 0 : thinkEnd + 8);
+        if (digitPos != std::string::npos) {
+            std::from_chars(content.data() + digitPos, content.data() + content.size(), choice);
         }
         
         if (choice >= 1 && choice <= options.size()) {
-            std::cout << "LLMClient: API选择选项 " << choice << std::endl;
+            LOG_DEBUG("LLMClient: API选择选项 " << choice);
+            metrics.countOutcome(LLMMetrics::Outcome::ChoiceValid);
+            choiceCache.store(eventHash, decisionVector, choice - 1);
             return choice - 1; // 转换为0-based索引
         } else {
-            std::cerr << "LLMClient: Invalid choice from API: " << content << ", falling back to simulation" << std::endl;
+            LOG_WARN("LLMClient: Invalid choice from API: " << content << ", falling back to simulation");
+            metrics.countOutcome(LLMMetrics::Outcome::ChoiceInvalid);
             return generateSimulatedChoice(agentId, decisionVector, options);
         }
         
     } catch (const std::exception& e) {
-        std::cerr << "LLMClient: Exception in getLLMChoice: " << e.what() << ", falling back to simulation" << std::endl;
+        LOG_ERROR("LLMClient: Exception in getLLMChoice: " << e.what() << ", falling back to simulation");
+        metrics.countOutcome(LLMMetrics::Outcome::ChoiceFallback);
         return generateSimulatedChoice(agentId, decisionVector, options);
     }
 }
 
+bool LLMClient::hasCachedChoice(const DecisionVector& decisionVector, const std::string& eventDescription,
+                                const std::vector<EventOption>& options) const {
+    return !simulationMode && !options.empty() &&
+           choiceCache.contains(hashChoiceEvent(eventDescription, options), decisionVector);
+}
+
+void LLMClient::saveChoiceCache() {
+    if (choiceCacheFile.empty() || choiceCache.size() == 0) {
+        return;
+    }
+    if (choiceCache.save(choiceCacheFile)) {
+        LOG_INFO("已保存 " << choiceCache.size() << " 个缓存的LLM选择到 " << choiceCacheFile);
+    }
+}
+
+void LLMClient::saveMetrics() {
+    if (metricsFile.empty()) {
+        return;
+    }
+    if (metrics.saveJson(metricsFile)) {
+        LOG_INFO("已保存LLM请求遥测到 " << metricsFile);
+    }
+}
+
 // 模拟事件生成
 LLMClient::RandomEvent LLMClient::generateSimulatedEvent() {
-    static std::mt19937 rng(std::random_device{}());
-    static std::uniform_int_distribution<int> eventDist(0, 7);
+    CounterRng rng(CounterRng::deriveStream(CounterRng::STREAM_LLM_EVENT, randomTick++));
+    std::uniform_int_distribution<int> eventDist(0, 7);
     
     RandomEvent event;
     int eventType = eventDist(rng);
@@ -417,14 +724,12 @@ LLMClient::RandomEvent LLMClient::generateSimulatedEvent() {
         option.text = optionTexts[(i + eventType) % 8];
         
         // 生成12维决策要求（随机）
-        option.decisionRequirement.resize(12, 0.0);
         std::uniform_real_distribution<double> reqDist(0.0, 0.6);
         for (int d = 0; d < 12; ++d) {
             option.decisionRequirement[d] = reqDist(rng);
         }
         
         // 生成12维决策反馈（随机，在-0.2到0.2之间）
-        option.decisionFeedback.resize(12, 0.0);
         std::uniform_real_distribution<double> feedbackDist(-0.2, 0.2);
         for (int d = 0; d < 12; ++d) {
             option.decisionFeedback[d] = feedbackDist(rng);
@@ -440,24 +745,20 @@ LLMClient::RandomEvent LLMClient::generateSimulatedEvent() {
 }
 
 // 模拟选择生成
-int LLMClient::generateSimulatedChoice(int agentId, const std::vector<double>& decisionVector,
+int LLMClient::generateSimulatedChoice(int agentId, const DecisionVector& decisionVector,
                                       const std::vector<EventOption>& options) {
     if (options.empty()) {
         return -1;
     }
     
-    static std::mt19937 rng(std::random_device{}());
+    CounterRng rng(CounterRng::deriveStream(CounterRng::STREAM_LLM_CHOICE, randomTick++));
     
     // 首先检查是否有满足决策要求的选项
     std::vector<int> availableOptions;
     for (int i = 0; i < options.size(); ++i) {
         bool requirementMet = true;
         const auto& req = options[i].decisionRequirement;
-        if (req.size() != decisionVector.size()) {
-            continue;
-        }
-        
-        for (int d = 0; d < req.size(); ++d) {
+        for (int d = 0; d < DecisionVector::DIMENSIONS; ++d) {
             if (decisionVector[d] < req[d]) {
                 requirementMet = false;
                 break;
@@ -480,13 +781,8 @@ int LLMClient::generateSimulatedChoice(int agentId, const std::vector<double>& d
     std::vector<double> similarities(options.size(), 0.0);
     for (int i = 0; i < options.size(); ++i) {
         const auto& req = options[i].decisionRequirement;
-        if (req.size() != decisionVector.size()) {
-            similarities[i] = 0.0;
-            continue;
-        }
-        
         double dot = 0.0, normA = 0.0, normB = 0.0;
-        for (int d = 0; d < decisionVector.size(); ++d) {
+        for (int d = 0; d < DecisionVector::DIMENSIONS; ++d) {
             dot += decisionVector[d] * req[d];
             normA += decisionVector[d] * decisionVector[d];
             normB += req[d] * req[d];
@@ -519,403 +815,460 @@ int LLMClient::generateSimulatedChoice(int agentId, const std::vector<double>& d
 }
 
 // 发送HTTP请求（完整实现）
-std::string LLMClient::sendRequest(const std::string& endpoint, const std::string& body) {
-#ifdef _WIN32
-    HINTERNET hSession = NULL;
-    HINTERNET hConnect = NULL;
-    HINTERNET hRequest = NULL;
+void LLMClient::buildRequestTemplates() {
+    // 事件生成：{"model":...,"messages":[{"role":"system",...},{"role":"user","content":"<系统提示>
+    eventRequestTemplate.prefix.clear();
+    JsonWriter eventWriter(eventRequestTemplate.prefix);
+    eventWriter.beginObject().key("model").string(model).key("messages").beginArray();
+    eventWriter.beginObject().key("role").string("system").key("content").string(EVENT_GENERATOR_ROLE).endObject();
+    eventWriter.beginObject().key("role").string("user").key("content").beginString().stringPart(systemPrompt);
+    eventRequestTemplate.state = eventWriter.state();
     
-    try {
-        // 构建完整URL
-        std::string fullUrl = baseUrl;
-        if (!endpoint.empty() && endpoint[0] != '/') {
-            fullUrl += "/";
+    // 选项选择：{"model":...,"stream":false,"max_tokens":50,"messages":[{"role":"user","content":"
+    choiceRequestTemplate.prefix.clear();
+    JsonWriter choiceWriter(choiceRequestTemplate.prefix);
+    choiceWriter.beginObject().key("model").string(model).key("stream").boolean(false).key("max_tokens").integer(50);
+    choiceWriter.key("messages").beginArray().beginObject().key("role").string("user").key("content").beginString();
+    choiceRequestTemplate.state = choiceWriter.state();
+}
+
+size_t LLMClient::eventRequestMaxTokens(size_t count) const {
+    // 本地模型服务器常常拒绝或截断过大的 max_tokens，批量请求的总量限制在 batchMaxTokens 以内
+    return std::max(eventMaxTokens, std::min(eventMaxTokens * count, batchMaxTokens));
+}
+
+const std::string& LLMClient::buildEventRequest(size_t count, size_t maxTokens, bool stream) {
+    std::string& body = requestBuffer();
+    body.assign(eventRequestTemplate.prefix);
+    JsonWriter writer(body, eventRequestTemplate.state);
+    if (count > 1) {
+        // 在事件生成提示后追加批量要求
+        writer.stringPart("\n\n请一次生成").stringPart(static_cast<int64_t>(count))
+              .stringPart("个互不相同的事件，每个事件的结构与上面的要求完全相同。"
+                          "把这些事件放在一个JSON数组中返回：[事件1, 事件2, ...]，不要包含数组以外的任何文字。");
+    }
+    writer.endString().endObject().endArray();
+    writer.key("stream").boolean(stream).key("max_tokens").integer(static_cast<int64_t>(maxTokens));
+    if (stream) {
+        // 流式响应默认不带 usage，要求服务器在最后一个片段中返回整个请求的 token 用量
+        writer.key("stream_options").beginObject().key("include_usage").boolean(true).endObject();
+    }
+    writer.endObject();
+    return body;
+}
+
+HttpResponse LLMClient::postWithLimit(const std::string& endpoint, const std::string& body,
+                                      const HttpTransport::BodyCallback& onData, RetryPolicy::RequestKind kind,
+                                      const std::shared_ptr<HttpStopSignal>& stop) {
+    // 调试输出
+    LOG_DEBUG("LLMClient: 发送请求到 URL: " << baseUrl << "/" << endpoint);
+    LOG_DEBUG("LLMClient: 端点: " << endpoint);
+    LOG_DEBUG("LLMClient: 请求体前100字符: " << (body.length() > 100 ? body.substr(0, 100) + "..." : body));
+    
+    // 熔断期间立即失败，由调用方使用本地回退
+    if (!healthMonitor.allowRequest()) {
+        metrics.requestRejected(kind);
+        HttpResponse rejected;
+        rejected.error = "LLM服务不可用（熔断中），跳过请求";
+        return rejected;
+    }
+    
+    // 等待空闲的请求名额（同时进行的请求数不超过 maxInFlight）；停止时放弃等待
+    {
+        uint64_t wakeOnStop = stop ? stop->attach([this]() {
+            std::lock_guard<std::mutex> lock(inFlightMutex);
+            inFlightReleased.notify_all();
+        }) : 0;
+        std::unique_lock<std::mutex> lock(inFlightMutex);
+        inFlightReleased.wait(lock, [this, &stop]() { return inFlight < maxInFlight || (stop && stop->stopRequested()); });
+        bool stopped = stop && stop->stopRequested();
+        if (!stopped) {
+            ++inFlight;
         }
-        fullUrl += endpoint;
-        
-        // 调试输出
-        std::cout << "LLMClient: 发送请求到 URL: " << fullUrl << std::endl;
-        std::cout << "LLMClient: 端点: " << endpoint << std::endl;
-        std::cout << "LLMClient: 请求体前100字符: " << (body.length() > 100 ? body.substr(0, 100) + "..." : body) << std::endl;
-        
-        // 解析URL
-        URL_COMPONENTS urlComp;
-        ZeroMemory(&urlComp, sizeof(urlComp));
-        urlComp.dwStructSize = sizeof(urlComp);
-        
-        urlComp.dwSchemeLength = -1;
-        urlComp.dwHostNameLength = -1;
-        urlComp.dwUrlPathLength = -1;
-        urlComp.dwExtraInfoLength = -1;
-        
-        std::wstring wideUrl = stringToWideString(fullUrl);
-        
-        if (!WinHttpCrackUrl(wideUrl.c_str(), wideUrl.length(), 0, &urlComp)) {
-            std::cerr << "LLMClient: Failed to parse URL: " << fullUrl << std::endl;
-            return "";
+        lock.unlock();
+        if (wakeOnStop != 0) {
+            stop->detach(wakeOnStop);
         }
-        
-        // 提取主机和端口
-        std::wstring hostName(urlComp.lpszHostName, urlComp.dwHostNameLength);
-        INTERNET_PORT port = urlComp.nPort;
-        
-        // 提取路径
-        std::wstring path;
-        if (urlComp.dwUrlPathLength > 0) {
-            path = std::wstring(urlComp.lpszUrlPath, urlComp.dwUrlPathLength);
+        if (stopped) {
+            HttpResponse cancelled;
+            cancelled.aborted = true;
+            cancelled.error = "Stopped";
+            return cancelled;
+        }
+    }
+    
+    // 通过持久连接发送（连接建立只在第一次请求或连接被服务器关闭后发生）
+    metrics.requestStarted(kind);
+    auto start = std::chrono::steady_clock::now();
+    HttpResponse httpResponse = transport.post(endpoint, body, onData, stop.get());
+    metrics.requestFinished(kind, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), httpResponse);
+    
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex);
+        --inFlight;
+    }
+    inFlightReleased.notify_one();
+    
+    // 传输失败、服务器错误和限流计为失败；主动中止的流式请求说明服务正常
+    if ((httpResponse.statusCode == 0 && !httpResponse.aborted) ||
+        httpResponse.statusCode == 429 || httpResponse.statusCode >= 500) {
+        healthMonitor.recordFailure();
+    } else {
+        healthMonitor.recordSuccess();
+    }
+    return httpResponse;
+}
+
+HttpResponse LLMClient::postWithRetry(const std::string& endpoint, const std::string& body,
+                                      const HttpTransport::BodyCallback& onData, RetryPolicy::RequestKind kind,
+                                      const std::shared_ptr<HttpStopSignal>& stop) {
+    using Clock = std::chrono::steady_clock;
+    
+    // 调用的总耗时（含重试和退避等待）在返回时计入遥测
+    struct CallTimer {
+        LLMMetrics& metrics;
+        RetryPolicy::RequestKind kind;
+        Clock::time_point start;
+        ~CallTimer() { metrics.recordCall(kind, std::chrono::duration<double>(Clock::now() - start).count()); }
+    } callTimer{metrics, kind, Clock::now()};
+    
+    RetryPolicy::Settings settings = retryPolicy.getSettings();
+    bool hasDeadline = settings.deadlineSeconds > 0.0;
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(settings.deadlineSeconds));
+    
+    // 流式请求：已经交给回调的数据无法撤回，收到数据后不再重试
+    bool delivered = false;
+    HttpTransport::BodyCallback trackedCallback;
+    if (onData) {
+        trackedCallback = [&delivered, &onData](const char* data, size_t size) {
+            delivered = true;
+            return onData(data, size);
+        };
+    }
+    
+    for (int retry = 0; ; ++retry) {
+        Clock::time_point attemptStart = Clock::now();
+        std::chrono::milliseconds hedgeAfter{0};
+        HttpResponse response;
+        if (!onData && retryPolicy.hedgeDelay(kind, hedgeAfter)) {
+            response = postHedged(endpoint, body, hedgeAfter, kind, hasDeadline, deadline, stop);
         } else {
-            path = L"/";
+            response = postWithLimit(endpoint, body, trackedCallback, kind, stop);
+            if (!onData && response.ok()) {
+                retryPolicy.recordLatency(kind, std::chrono::duration<double>(Clock::now() - attemptStart).count());
+            }
         }
         
-        // 创建会话
-        hSession = WinHttpOpen(L"LLMClient/1.0", 
-                               WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                               WINHTTP_NO_PROXY_NAME, 
-                               WINHTTP_NO_PROXY_BYPASS, 0);
-        if (!hSession) {
-            std::cerr << "LLMClient: Failed to create WinHTTP session" << std::endl;
-            return "";
+        if (!RetryPolicy::isRetryable(response)) {
+            return response;
         }
-        
-        // 设置超时（将秒转换为毫秒）
-        DWORD timeoutMs = timeoutSeconds * 1000;
-        WinHttpSetTimeouts(hSession, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
-        
-        // 连接到服务器
-        hConnect = WinHttpConnect(hSession, hostName.c_str(), port, 0);
-        if (!hConnect) {
-            std::cerr << "LLMClient: Failed to connect to server" << std::endl;
-            WinHttpCloseHandle(hSession);
-            return "";
+        // 熔断期间或熔断器刚刚打开时不再重试，交给调用方的本地回退
+        if (delivered || healthMonitor.getState() != LLMHealthMonitor::State::Closed) {
+            return response;
         }
-        
-        // 创建请求
-        hRequest = WinHttpOpenRequest(hConnect, L"POST", path.c_str(),
-                                     NULL, WINHTTP_NO_REFERER,
-                                     WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
-        if (!hRequest) {
-            std::cerr << "LLMClient: Failed to create request" << std::endl;
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            return "";
+        if (retry >= settings.maxRetries) {
+            if (settings.maxRetries > 0) {
+                retryPolicy.countExhausted();
+            }
+            return response;
         }
         
-        // 准备请求头
-        std::wstring headers = L"Content-Type: application/json; charset=utf-8";
-        if (!apiKey.empty()) {
-            headers += L"\r\nAuthorization: Bearer " + stringToWideString(apiKey);
+        std::chrono::milliseconds delay = retryPolicy.backoffDelay(retry);
+        if (hasDeadline && Clock::now() + delay >= deadline) {
+            retryPolicy.countDeadlineExceeded();
+            LOG_WARN("LLMClient: 请求超过截止时间，不再重试");
+            return response;
         }
-        
-        // 发送请求
-        if (!WinHttpSendRequest(hRequest, headers.c_str(), headers.length(),
-                               (LPVOID)body.c_str(), body.length(),
-                               body.length(), 0)) {
-            std::cerr << "LLMClient: Failed to send request" << std::endl;
-            WinHttpCloseHandle(hRequest);
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            return "";
+        LOG_WARN("LLMClient: 请求失败（" << (response.statusCode == 0 ? response.error : "HTTP " + std::to_string(response.statusCode))
+                 << "），" << delay.count() << " 毫秒后重试（" << retry + 1 << "/" << settings.maxRetries << "）");
+        // 停止时不再等待退避，也不再重试
+        if (stop) {
+            if (stop->waitFor(delay)) {
+                return response;
+            }
+        } else {
+            std::this_thread::sleep_for(delay);
         }
-        
-        // 接收响应
-        if (!WinHttpReceiveResponse(hRequest, NULL)) {
-            std::cerr << "LLMClient: Failed to receive response" << std::endl;
-            WinHttpCloseHandle(hRequest);
-            WinHttpCloseHandle(hConnect);
-            WinHttpCloseHandle(hSession);
-            return "";
+        retryPolicy.countRetry();
+    }
+}
+
+HttpResponse LLMClient::postHedged(const std::string& endpoint, const std::string& body,
+                                   std::chrono::milliseconds hedgeAfter, RetryPolicy::RequestKind kind,
+                                   bool hasDeadline, std::chrono::steady_clock::time_point deadline,
+                                   const std::shared_ptr<HttpStopSignal>& stop) {
+    // 两个请求共享的结果：第一个不需重试的响应胜出；都失败时取最后一个失败的响应
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable finished;
+        int running = 0;
+        bool decided = false;
+        int winner = -1;
+        HttpResponse result;
+    };
+    auto race = std::make_shared<Race>();
+    
+    // 落后的请求在后台继续，持有停止信号的引用，停止时同样被中止
+    auto launch = [this, race, &endpoint, &body, kind, &stop](int id) {
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            ++race->running;
         }
-        
-        // 读取响应数据
-        DWORD dwSize = 0;
-        DWORD dwDownloaded = 0;
-        std::string response;
-        
-        do {
-            dwSize = 0;
-            if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) {
-                std::cerr << "LLMClient: Error querying data available" << std::endl;
-                break;
+        {
+            std::lock_guard<std::mutex> lock(backgroundMutex);
+            ++backgroundRequests;
+        }
+        std::thread([this, race, endpoint, body, kind, id, stop]() {
+            auto start = std::chrono::steady_clock::now();
+            HttpResponse response = postWithLimit(endpoint, body, HttpTransport::BodyCallback(), kind, stop);
+            if (response.ok()) {
+                retryPolicy.recordLatency(kind, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
             }
-            
-            if (dwSize == 0) break;
-            
-            std::vector<char> buffer(dwSize + 1);
-            if (!WinHttpReadData(hRequest, (LPVOID)buffer.data(), dwSize, &dwDownloaded)) {
-                std::cerr << "LLMClient: Error reading data" << std::endl;
-                break;
+            {
+                std::lock_guard<std::mutex> lock(race->mutex);
+                --race->running;
+                if (!race->decided && (!RetryPolicy::isRetryable(response) || race->running == 0)) {
+                    race->decided = true;
+                    race->winner = id;
+                    race->result = std::move(response);
+                }
             }
+            race->finished.notify_all();
             
-            buffer[dwDownloaded] = '\0';
-            response.append(buffer.data());
-            
-        } while (dwSize > 0);
-        
-        // 调试输出：显示响应信息
-        std::cout << "LLMClient: 收到响应，长度: " << response.length() << " 字节" << std::endl;
-        if (!response.empty()) {
-            std::cout << "LLMClient: 响应前200字符: " << (response.length() > 200 ? response.substr(0, 200) + "..." : response) << std::endl;
-        } else {
-            std::cout << "LLMClient: 响应为空" << std::endl;
+            std::lock_guard<std::mutex> lock(backgroundMutex);
+            --backgroundRequests;
+            backgroundDone.notify_all();
+        }).detach();
+    };
+    
+    launch(0);
+    std::unique_lock<std::mutex> lock(race->mutex);
+    auto decided = [&race]() { return race->decided; };
+    if (!race->finished.wait_for(lock, hedgeAfter, decided)) {
+        // 超过延迟分位数仍未返回：再发送一个相同的请求，落后的请求在后台继续直到结束
+        lock.unlock();
+        retryPolicy.countHedge();
+        launch(1);
+        lock.lock();
+    }
+    if (hasDeadline) {
+        if (!race->finished.wait_until(lock, deadline, decided)) {
+            HttpResponse timedOut;
+            timedOut.error = "请求超过截止时间";
+            return timedOut;
+        }
+    } else {
+        race->finished.wait(lock, decided);
+    }
+    
+    if (race->winner == 1) {
+        retryPolicy.countHedgeWin();
+    }
+    return race->result;
+}
+
+bool LLMClient::probeConnection() {
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().key("model").string(model).key("messages").beginArray();
+    writer.beginObject().key("role").string("user").key("content").string("Hello").endObject();
+    writer.endArray().key("stream").boolean(false).key("max_tokens").integer(1).endObject();
+    
+    HttpResponse response = transport.post("v1/chat/completions", body);
+    return response.statusCode != 0 && response.statusCode != 429 && response.statusCode < 500;
+}
+
+bool LLMClient::isAvailable() const {
+    return simulationMode || healthMonitor.isAvailable();
+}
+
+std::string LLMClient::sendRequest(const std::string& endpoint, const std::string& body, RetryPolicy::RequestKind kind,
+                                   const std::shared_ptr<HttpStopSignal>& stop) {
+    HttpResponse httpResponse = postWithRetry(endpoint, body, HttpTransport::BodyCallback(), kind, stop);
+    if (httpResponse.statusCode == 0) {
+        if (!(stop && stop->stopRequested())) {
+            LOG_WARN("LLMClient: " << httpResponse.error);
         }
-        
-        // 清理资源
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        
-        return response;
-        
-    } catch (const std::exception& e) {
-        std::cerr << "LLMClient: Exception in sendRequest: " << e.what() << std::endl;
-        if (hRequest) WinHttpCloseHandle(hRequest);
-        if (hConnect) WinHttpCloseHandle(hConnect);
-        if (hSession) WinHttpCloseHandle(hSession);
         return "";
     }
-#else
-    std::cerr << "LLMClient: HTTP requests require Windows platform" << std::endl;
-    return "";
-#endif
+    if (!httpResponse.ok()) {
+        LOG_WARN("LLMClient: 服务器返回HTTP状态码 " << httpResponse.statusCode);
+    }
+    
+    const std::string& response = httpResponse.body;
+    
+    // 调试输出：显示响应信息
+    LOG_DEBUG("LLMClient: 收到响应，长度: " << response.length() << " 字节");
+    if (!response.empty()) {
+        LOG_DEBUG("LLMClient: 响应前200字符: " << (response.length() > 200 ? response.substr(0, 200) + "..." : response));
+    } else {
+        LOG_DEBUG("LLMClient: 响应为空");
+    }
+    
+    return response;
 }
 
 // 解析LLM响应
 LLMClient::RandomEvent LLMClient::parseEventResponse(const std::string& response) {
     RandomEvent event;
     
-    std::cout << "LLMClient: 开始解析LLM响应..." << std::endl;
+    LOG_DEBUG("LLMClient: 开始解析LLM响应...");
     
-    try {
-        // 首先尝试从OpenAI兼容响应中提取content字段
-        // OpenAI格式: {"choices": [{"message": {"content": "..."}}]}
-        std::string content;
-        
-        // 查找choices数组
-        size_t choicesPos = response.find("\"choices\"");
-        if (choicesPos != std::string::npos) {
-            // 找到第一个choice中的message
-            size_t messagePos = response.find("\"message\"", choicesPos);
-            if (messagePos != std::string::npos) {
-                // 在message对象中查找content
-                size_t contentPos = response.find("\"content\"", messagePos);
-                if (contentPos != std::string::npos) {
-                    // 找到content字段的开始引号
-                    size_t quoteStart = response.find('"', contentPos + 9); // 跳过"content":
-                    if (quoteStart != std::string::npos) {
-                        size_t quoteEnd = response.find('"', quoteStart + 1);
-                        if (quoteEnd != std::string::npos) {
-                            content = response.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                        }
-                    }
-                }
-            }
+    // 首先从OpenAI兼容响应中提取content字段，content应该是我们请求的JSON字符串
+    std::string content = extractResponseContent(response, RetryPolicy::RequestKind::Event);
+    if (content.empty()) {
+        LOG_WARN("LLMClient: 响应中未找到content字段");
+        return RandomEvent();
+    }
+    LOG_DEBUG("LLMClient: 提取到content长度：" << content.length());
+    
+    size_t jsonStart = findJsonStart(content);
+    JsonDocument document;
+    if (jsonStart == std::string::npos ||
+        !document.parse(std::string_view(content).substr(jsonStart), true)) {
+        LOG_WARN("LLMClient: content不是有效的JSON " << document.error());
+        return RandomEvent();
+    }
+    
+    if (!readEvent(document.root(), event)) {
+        LOG_WARN("LLMClient: 无法解析事件名称、描述、选项或决策向量");
+        return RandomEvent();
+    }
+    
+    LOG_DEBUG("LLMClient: 解析到事件：" << event.name);
+    LOG_DEBUG("LLMClient: 解析完成，找到 " << event.options.size() << " 个选项");
+    return event;
+}
+
+std::vector<LLMClient::RandomEvent> LLMClient::generateEventsStreaming(size_t count, size_t maxTokens,
+                                                                      const std::shared_ptr<HttpStopSignal>& stop) {
+    std::vector<RandomEvent> events;
+    const std::string& requestBody = buildEventRequest(count, maxTokens, true);
+    
+    // 每个 data 行形如 {"choices": [{"delta": {"content": "..."}}]}，把 content 片段交给解析器
+    // 解析器判定结构无效时回调返回 false，传输层立即中止请求
+    StreamingEventParser parser;
+    SseDecoder sse;
+    std::string plainBody;  // 服务器不支持流式响应时收到的普通响应体
+    auto onData = [&](const char* data, size_t size) {
+        if (sse.getPayloadCount() == 0) {
+            plainBody.append(data, size);
         }
-        
-        // 如果通过choices没有找到，尝试直接查找content字段（旧格式）
-        if (content.empty()) {
-            size_t contentPos = response.find("\"content\"");
-            if (contentPos == std::string::npos) {
-                std::cerr << "LLMClient: 响应中未找到content字段" << std::endl;
-                return generateSimulatedEvent();
+        return sse.feed(data, size, [&](const std::string& payload) {
+            JsonDocument chunk;
+            if (!chunk.parse(payload)) {
+                return true;
             }
-            
-            // 找到content字段的开始引号
-            size_t quoteStart = response.find('"', contentPos + 9); // 跳过"content":
-            if (quoteStart == std::string::npos) {
-                std::cerr << "LLMClient: 格式错误：未找到content字段的开始引号" << std::endl;
-                return generateSimulatedEvent();
-            }
-            
-            // 找到content字段的结束引号
-            size_t quoteEnd = response.find('"', quoteStart + 1);
-            if (quoteEnd == std::string::npos) {
-                std::cerr << "LLMClient: 格式错误：未找到content字段的结束引号" << std::endl;
-                return generateSimulatedEvent();
+            // 服务器支持时最后一个片段带有整个请求的 usage
+            recordUsage(metrics, RetryPolicy::RequestKind::Event, chunk.root());
+            JsonValue delta = choiceContent(chunk.root(), "delta");
+            if (!delta.isString()) {
+                // 角色、结束原因等不含内容的片段
+                return true;
             }
-            
-            content = response.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-        }
-        
-        // 现在content应该是我们请求的JSON字符串
-        // 我们需要解析这个JSON字符串
-        std::cout << "LLMClient: 提取到content长度：" << content.length() << std::endl;
-        
-        // 简单的JSON解析辅助函数
-        auto extractJsonString = [](const std::string& json, const std::string& key) -> std::string {
-            size_t keyPos = json.find("\"" + key + "\"");
-            if (keyPos == std::string::npos) return "";
-            
-            size_t colonPos = json.find(':', keyPos);
-            if (colonPos == std::string::npos) return "";
-            
-            size_t quoteStart = json.find('"', colonPos);
-            if (quoteStart == std::string::npos) return "";
-            
-            size_t quoteEnd = json.find('"', quoteStart + 1);
-            if (quoteEnd == std::string::npos) return "";
-            
-            return json.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-        };
-        
-        auto extractJsonArray = [](const std::string& json, const std::string& key) -> std::string {
-            size_t keyPos = json.find("\"" + key + "\"");
-            if (keyPos == std::string::npos) return "";
-            
-            size_t colonPos = json.find(':', keyPos);
-            if (colonPos == std::string::npos) return "";
-            
-            // 找到数组的开始括号 '['
-            size_t bracketStart = json.find('[', colonPos);
-            if (bracketStart == std::string::npos) return "";
-            
-            // 找到匹配的结束括号 ']'
-            int bracketCount = 1;
-            size_t pos = bracketStart + 1;
-            for (; pos < json.length(); ++pos) {
-                if (json[pos] == '[') bracketCount++;
-                else if (json[pos] == ']') {
-                    bracketCount--;
-                    if (bracketCount == 0) break;
-                }
+            return parser.feed(delta.asString()) != StreamingEventParser::Status::Invalid;
+        });
+    };
+    
+    HttpResponse httpResponse = postWithRetry("v1/chat/completions", requestBody, onData, RetryPolicy::RequestKind::Event, stop);
+    if (stop && stop->stopRequested()) {
+        // 停止时丢弃未完成的输出
+        return events;
+    }
+    // 输出没有 </think> 时，试探性解析的结果在这里成为最终结果
+    parser.finish();
+    if (httpResponse.aborted) {
+        LOG_WARN("LLMClient: 流式输出结构无效，已中止请求: " << parser.error());
+    } else if (httpResponse.statusCode == 0) {
+        LOG_WARN("LLMClient: " << httpResponse.error);
+        return events;
+    } else if (!httpResponse.ok()) {
+        LOG_WARN("LLMClient: 服务器返回HTTP状态码 " << httpResponse.statusCode);
+        return events;
+    } else if (sse.getPayloadCount() == 0) {
+        LOG_DEBUG("LLMClient: 服务器未使用流式响应，按普通响应解析");
+        return parseEventBatchResponse(plainBody);
+    } else if (parser.status() != StreamingEventParser::Status::Complete) {
+        LOG_WARN("LLMClient: 流式输出在事件结束前中断");
+    }
+    
+    if (parser.rejectedEventCount() > 0) {
+        LOG_WARN("LLMClient: 流式输出中有 " << parser.rejectedEventCount() << " 个事件结构无效，已丢弃（" << parser.error() << "）");
+        metrics.countOutcome(LLMMetrics::Outcome::EventInvalid, parser.rejectedEventCount());
+    } else if (httpResponse.aborted) {
+        // 整体结构无效而中止（没有单独丢弃的事件）：计为一个无效事件
+        metrics.countOutcome(LLMMetrics::Outcome::EventInvalid);
+    }
+    
+    // 中止或中断之前已完整接收的事件仍可使用
+    for (const auto& text : parser.takeCompletedEvents()) {
+        try {
+            RandomEvent event = parseEventFromJsonContent(text);
+            if (validateEvent(event)) {
+                events.push_back(std::move(event));
+            } else {
+                metrics.countOutcome(LLMMetrics::Outcome::EventInvalid);
             }
-            
-            if (bracketCount != 0) return "";
-            
-            return json.substr(bracketStart, pos - bracketStart + 1);
-        };
-        
-        // 从content中提取事件名称和描述
-        event.name = extractJsonString(content, "name");
-        event.description = extractJsonString(content, "description");
-        
-        if (event.name.empty() || event.description.empty()) {
-            std::cerr << "LLMClient: 无法解析事件名称或描述" << std::endl;
-            return generateSimulatedEvent();
-        }
-        
-        std::cout << "LLMClient: 解析到事件：" << event.name << std::endl;
-        
-        // 提取options数组
-        std::string optionsArray = extractJsonArray(content, "options");
-        if (optionsArray.empty()) {
-            std::cerr << "LLMClient: 无法解析options数组" << std::endl;
-            return generateSimulatedEvent();
+        } catch (const std::exception&) {
+            metrics.countOutcome(LLMMetrics::Outcome::EventInvalid);
         }
-        
-        // 解析每个选项
-        size_t optionStart = 0;
-        while (true) {
-            // 查找选项对象的开始 '{'
-            optionStart = optionsArray.find('{', optionStart);
-            if (optionStart == std::string::npos) break;
-            
-            // 查找选项对象的结束 '}'
-            int braceCount = 1;
-            size_t optionEnd = optionStart + 1;
-            for (; optionEnd < optionsArray.length(); ++optionEnd) {
-                if (optionsArray[optionEnd] == '{') braceCount++;
-                else if (optionsArray[optionEnd] == '}') {
-                    braceCount--;
-                    if (braceCount == 0) break;
-                }
-            }
-            
-            if (braceCount != 0) break;
-            
-            std::string optionJson = optionsArray.substr(optionStart, optionEnd - optionStart + 1);
-            
-            // 提取选项字段
-            EventOption option;
-            option.text = extractJsonString(optionJson, "text");
-            option.outcomeText = extractJsonString(optionJson, "outcomeText");
-            
-            // 提取decisionRequirement数组
-            std::string reqArray = extractJsonArray(optionJson, "decisionRequirement");
-            if (!reqArray.empty() && reqArray.length() > 2) {
-                // 解析数组 [0.1, 0.2, ...]
-                std::vector<double> requirements;
-                size_t start = reqArray.find('[') + 1;
-                size_t end = reqArray.find(']');
-                if (end != std::string::npos && end > start) {
-                    std::string values = reqArray.substr(start, end - start);
-                    size_t pos = 0;
-                    while (pos < values.length()) {
-                        // 跳过空格
-                        while (pos < values.length() && (values[pos] == ' ' || values[pos] == ',' || values[pos] == '\n' || values[pos] == '\t')) pos++;
-                        if (pos >= values.length()) break;
-                        
-                        size_t valueEnd = values.find_first_of(", ]", pos);
-                        if (valueEnd == std::string::npos) break;
-                        
-                        std::string valueStr = values.substr(pos, valueEnd - pos);
-                        try {
-                            requirements.push_back(std::stod(valueStr));
-                        } catch (...) {
-                            requirements.push_back(0.0);
-                        }
-                        
-                        pos = valueEnd;
-                    }
-                }
-                option.decisionRequirement = requirements;
-            }
-            
-            // 提取decisionFeedback数组
-            std::string feedbackArray = extractJsonArray(optionJson, "decisionFeedback");
-            if (!feedbackArray.empty() && feedbackArray.length() > 2) {
-                // 解析数组 [0.1, -0.1, ...]
-                std::vector<double> feedbacks;
-                size_t start = feedbackArray.find('[') + 1;
-                size_t end = feedbackArray.find(']');
-                if (end != std::string::npos && end > start) {
-                    std::string values = feedbackArray.substr(start, end - start);
-                    size_t pos = 0;
-                    while (pos < values.length()) {
-                        // 跳过空格
-                        while (pos < values.length() && (values[pos] == ' ' || values[pos] == ',' || values[pos] == '\n' || values[pos] == '\t')) pos++;
-                        if (pos >= values.length()) break;
-                        
-                        size_t valueEnd = values.find_first_of(", ]", pos);
-                        if (valueEnd == std::string::npos) break;
-                        
-                        std::string valueStr = values.substr(pos, valueEnd - pos);
-                        try {
-                            feedbacks.push_back(std::stod(valueStr));
-                        } catch (...) {
-                            feedbacks.push_back(0.0);
-                        }
-                        
-                        pos = valueEnd;
-                    }
-                }
-                option.decisionFeedback = feedbacks;
-            }
-            
-            // 如果向量长度不正确，使用默认值
-            if (option.decisionRequirement.size() != 12) {
-                option.decisionRequirement = std::vector<double>(12, 0.5);
-            }
-            if (option.decisionFeedback.size() != 12) {
-                option.decisionFeedback = std::vector<double>(12, 0.1);
-            }
-            
-            event.options.push_back(option);
-            optionStart = optionEnd + 1;
+    }
+    return events;
+}
+
+std::string LLMClient::extractResponseContent(const std::string& response, RetryPolicy::RequestKind kind) {
+    JsonDocument document;
+    if (!document.parse(response)) {
+        LOG_WARN("LLMClient: 响应不是有效的JSON: " << document.error());
+        return "";
+    }
+    recordUsage(metrics, kind, document.root());
+    return choiceContent(document.root(), "message").asString();
+}
+
+std::vector<LLMClient::RandomEvent> LLMClient::parseEventBatchResponse(const std::string& response) {
+    std::vector<RandomEvent> events;
+    
+    std::string content = extractResponseContent(response, RetryPolicy::RequestKind::Event);
+    size_t jsonStart = findJsonStart(content);
+    if (jsonStart == std::string::npos) {
+        LOG_WARN("LLMClient: 响应中未找到事件JSON");
+        metrics.countOutcome(LLMMetrics::Outcome::EventInvalid);
+        return events;
+    }
+    
+    JsonDocument document;
+    if (!document.parse(std::string_view(content).substr(jsonStart), true)) {
+        LOG_WARN("LLMClient: content不是有效的JSON " << document.error());
+        metrics.countOutcome(LLMMetrics::Outcome::EventInvalid);
+        return events;
+    }
+    
+    // content 为事件数组，也接受单个事件对象；逐个解析和验证，无效的事件单独丢弃
+    JsonValue root = document.root();
+    size_t invalidCount = 0;
+    auto accept = [&](const JsonValue& object) {
+        RandomEvent event;
+        if (readEvent(object, event) && validateEvent(event)) {
+            events.push_back(std::move(event));
+        } else {
+            ++invalidCount;
         }
-        
-        std::cout << "LLMClient: 解析完成，找到 " << event.options.size() << " 个选项" << std::endl;
-        
-        if (event.options.empty()) {
-            std::cerr << "LLMClient: 未解析到任何选项" << std::endl;
-            return generateSimulatedEvent();
+    };
+    if (root.isArray()) {
+        for (JsonValue item = root.first(); item; item = item.next()) {
+            accept(item);
         }
-        
-        return event;
-        
-    } catch (const std::exception& e) {
-        std::cerr << "LLMClient: 解析LLM响应时异常: " << e.what() << std::endl;
-        return generateSimulatedEvent();
+    } else {
+        accept(root);
     }
+    
+    if (invalidCount > 0) {
+        LOG_WARN("LLMClient: 批量响应中有 " << invalidCount << " 个事件无效，已丢弃");
+        metrics.countOutcome(LLMMetrics::Outcome::EventInvalid, invalidCount);
+    }
+    return events;
 }
 
 // 解析选择响应（占位符）
@@ -931,7 +1284,7 @@ bool LLMClient::validateEvent(const RandomEvent& event) {
     
     // 检查选项数量 - 用户要求10个选项
     if (event.options.size() != 10) {
-        std::cerr << "LLMClient: 事件选项数量不正确，期望10个，实际" << event.options.size() << "个" << std::endl;
+        LOG_WARN("LLMClient: 事件选项数量不正确，期望10个，实际" << event.options.size() << "个");
         return false;
     }
     
@@ -939,29 +1292,19 @@ bool LLMClient::validateEvent(const RandomEvent& event) {
     for (size_t i = 0; i < event.options.size(); ++i) {
         const auto& option = event.options[i];
         if (option.text.empty() || option.outcomeText.empty()) {
-            std::cerr << "LLMClient: 选项" << i << "文本为空" << std::endl;
+            LOG_WARN("LLMClient: 选项" << i << "文本为空");
             return false;
         }
         
-        if (option.decisionRequirement.size() != 12) {
-            std::cerr << "LLMClient: 选项" << i << "决策要求向量维度不正确，期望12，实际" << option.decisionRequirement.size() << std::endl;
-            return false;
-        }
-        
-        if (option.decisionFeedback.size() != 12) {
-            std::cerr << "LLMClient: 选项" << i << "决策反馈向量维度不正确，期望12，实际" << option.decisionFeedback.size() << std::endl;
-            return false;
-        }
-        
-        // 检查值范围
-        for (size_t j = 0; j < 12; ++j) {
+        // 检查值范围（长度不为12或含非数值的向量在 readEvent 中已被拒绝）
+        for (size_t j = 0; j < DecisionVector::DIMENSIONS; ++j) {
             if (option.decisionRequirement[j] < 0.0 || option.decisionRequirement[j] > 1.0) {
-                std::cerr << "LLMClient: 选项" << i << "决策要求向量值超出范围[0.0, 1.0]: " << option.decisionRequirement[j] << std::endl;
+                LOG_WARN("LLMClient: 选项" << i << "决策要求向量值超出范围[0.0, 1.0]: " << option.decisionRequirement[j]);
                 return false;
             }
             
             if (option.decisionFeedback[j] < -0.2 || option.decisionFeedback[j] > 0.2) {
-                std::cerr << "LLMClient: 选项" << i << "决策反馈向量值超出范围[-0.2, 0.2]: " << option.decisionFeedback[j] << std::endl;
+                LOG_WARN("LLMClient: 选项" << i << "决策反馈向量值超出范围[-0.2, 0.2]: " << option.decisionFeedback[j]);
                 return false;
             }
         }
@@ -970,340 +1313,277 @@ bool LLMClient::validateEvent(const RandomEvent& event) {
     return true;
 }
 
-// 保存事件到文件
-void LLMClient::saveEventToFile(const RandomEvent& event) {
+// 保存事件到事件库
+void LLMClient::saveEvent(const RandomEvent& event) {
     // 首先验证事件
     if (!validateEvent(event)) {
-        std::cerr << "LLMClient: 事件验证失败，不保存" << std::endl;
+        LOG_WARN("LLMClient: 事件验证失败，不保存");
         return;
     }
     
-    // 创建保存目录（如果不存在）
-    #ifdef _WIN32
-    CreateDirectoryA("llm_events", NULL);
-    #endif
-    
-    // 生成文件名（使用时间戳和事件名称）
-    auto now = std::chrono::system_clock::now();
-    auto now_time = std::chrono::system_clock::to_time_t(now);
-    std::tm tm;
-    localtime_s(&tm, &now_time);
-    char filename[256];
-    strftime(filename, sizeof(filename), "llm_events/event_%Y%m%d_%H%M%S.json", &tm);
-    
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "LLMClient: 无法打开文件保存事件: " << filename << std::endl;
+    if (!eventStore || !eventStore->isOpen()) {
+        LOG_WARN("LLMClient: 事件库未打开，事件未保存");
         return;
     }
     
-    // 保存为JSON格式
-    file << "{\n";
-    file << "  \"name\": \"" << escapeJsonString(event.name) << "\",\n";
-    file << "  \"description\": \"" << escapeJsonString(event.description) << "\",\n";
-    file << "  \"options\": [\n";
+    switch (eventStore->append(event)) {
+        case EventStore::AppendResult::Added:
+            LOG_DEBUG("LLMClient: 事件已保存到事件库（共 " << eventStore->size() << " 个）");
+            break;
+        case EventStore::AppendResult::Duplicate:
+            LOG_DEBUG("LLMClient: 事件库中已有相同的事件，不重复保存: " << event.name);
+            break;
+        case EventStore::AppendResult::Failed:
+            break;
+    }
+}
+
+// 以JSON格式写出事件
+void LLMClient::writeEventJson(std::ostream& out, const RandomEvent& event) {
+    out << "{\n";
+    out << "  \"name\": \"" << escapeJsonString(event.name) << "\",\n";
+    out << "  \"description\": \"" << escapeJsonString(event.description) << "\",\n";
+    out << "  \"options\": [\n";
     
     for (size_t i = 0; i < event.options.size(); ++i) {
         const auto& option = event.options[i];
-        file << "    {\n";
-        file << "      \"text\": \"" << escapeJsonString(option.text) << "\",\n";
-        file << "      \"outcomeText\": \"" << escapeJsonString(option.outcomeText) << "\",\n";
+        out << "    {\n";
+        out << "      \"text\": \"" << escapeJsonString(option.text) << "\",\n";
+        out << "      \"outcomeText\": \"" << escapeJsonString(option.outcomeText) << "\",\n";
         
-        file << "      \"decisionRequirement\": [";
+        out << "      \"decisionRequirement\": [";
         for (size_t j = 0; j < option.decisionRequirement.size(); ++j) {
-            file << option.decisionRequirement[j];
+            out << option.decisionRequirement[j];
             if (j < option.decisionRequirement.size() - 1) {
-                file << ", ";
+                out << ", ";
             }
         }
-        file << "],\n";
+        out << "],\n";
         
-        file << "      \"decisionFeedback\": [";
+        out << "      \"decisionFeedback\": [";
         for (size_t j = 0; j < option.decisionFeedback.size(); ++j) {
-            file << option.decisionFeedback[j];
+            out << option.decisionFeedback[j];
             if (j < option.decisionFeedback.size() - 1) {
-                file << ", ";
+                out << ", ";
             }
         }
-        file << "]\n";
+        out << "]\n";
         
-        file << "    }";
+        out << "    }";
         if (i < event.options.size() - 1) {
-            file << ",";
+            out << ",";
         }
-        file << "\n";
+        out << "\n";
     }
     
-    file << "  ]\n";
-    file << "}\n";
-    
-    file.close();
-    std::cout << "LLMClient: 事件已保存到 " << filename << std::endl;
+    out << "  ]\n";
+    out << "}\n";
 }
 
-// 辅助函数：从JSON内容解析事件（用于加载保存的文件）
+// 辅助函数：从JSON内容解析事件（用于加载保存的文件和流式接收的事件）
 LLMClient::RandomEvent LLMClient::parseEventFromJsonContent(const std::string& jsonContent) {
-    RandomEvent event;
+    JsonDocument document;
+    if (!document.parse(jsonContent)) {
+        throw std::runtime_error(document.error());
+    }
     
-    try {
-        // 重用parseEventResponse中的提取函数
-        auto extractJsonString = [](const std::string& json, const std::string& key) -> std::string {
-            size_t keyPos = json.find("\"" + key + "\"");
-            if (keyPos == std::string::npos) return "";
-            
-            size_t colonPos = json.find(':', keyPos);
-            if (colonPos == std::string::npos) return "";
-            
-            size_t quoteStart = json.find('"', colonPos);
-            if (quoteStart == std::string::npos) return "";
-            
-            size_t quoteEnd = json.find('"', quoteStart + 1);
-            if (quoteEnd == std::string::npos) return "";
-            
-            return json.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-        };
-        
-        auto extractJsonArray = [](const std::string& json, const std::string& key) -> std::string {
-            size_t keyPos = json.find("\"" + key + "\"");
-            if (keyPos == std::string::npos) return "";
-            
-            size_t colonPos = json.find(':', keyPos);
-            if (colonPos == std::string::npos) return "";
-            
-            // 找到数组的开始括号 '['
-            size_t bracketStart = json.find('[', colonPos);
-            if (bracketStart == std::string::npos) return "";
-            
-            // 找到匹配的结束括号 ']'
-            int bracketCount = 1;
-            size_t pos = bracketStart + 1;
-            for (; pos < json.length(); ++pos) {
-                if (json[pos] == '[') bracketCount++;
-                else if (json[pos] == ']') {
-                    bracketCount--;
-                    if (bracketCount == 0) break;
-                }
-            }
-            
-            if (bracketCount != 0) return "";
-            
-            return json.substr(bracketStart, pos - bracketStart + 1);
-        };
-        
-        // 提取事件名称和描述
-        event.name = extractJsonString(jsonContent, "name");
-        event.description = extractJsonString(jsonContent, "description");
-        
-        if (event.name.empty() || event.description.empty()) {
-            throw std::runtime_error("无法解析事件名称或描述");
-        }
-        
-        // 提取options数组
-        std::string optionsArray = extractJsonArray(jsonContent, "options");
-        if (optionsArray.empty()) {
-            throw std::runtime_error("无法解析options数组");
-        }
-        
-        // 解析每个选项
-        size_t optionStart = 0;
-        while (true) {
-            // 查找选项对象的开始 '{'
-            optionStart = optionsArray.find('{', optionStart);
-            if (optionStart == std::string::npos) break;
-            
-            // 查找选项对象的结束 '}'
-            int braceCount = 1;
-            size_t optionEnd = optionStart + 1;
-            for (; optionEnd < optionsArray.length(); ++optionEnd) {
-                if (optionsArray[optionEnd] == '{') braceCount++;
-                else if (optionsArray[optionEnd] == '}') {
-                    braceCount--;
-                    if (braceCount == 0) break;
-                }
-            }
-            
-            if (braceCount != 0) break;
-            
-            std::string optionJson = optionsArray.substr(optionStart, optionEnd - optionStart + 1);
-            
-            // 提取选项字段
-            EventOption option;
-            option.text = extractJsonString(optionJson, "text");
-            option.outcomeText = extractJsonString(optionJson, "outcomeText");
-            
-            // 提取decisionRequirement数组
-            std::string reqArray = extractJsonArray(optionJson, "decisionRequirement");
-            if (!reqArray.empty() && reqArray.length() > 2) {
-                std::vector<double> requirements;
-                size_t start = reqArray.find('[') + 1;
-                size_t end = reqArray.find(']');
-                if (end != std::string::npos && end > start) {
-                    std::string values = reqArray.substr(start, end - start);
-                    size_t pos = 0;
-                    while (pos < values.length()) {
-                        while (pos < values.length() && (values[pos] == ' ' || values[pos] == ',' || values[pos] == '\n' || values[pos] == '\t')) pos++;
-                        if (pos >= values.length()) break;
-                        
-                        size_t valueEnd = values.find_first_of(", ]", pos);
-                        if (valueEnd == std::string::npos) break;
-                        
-                        std::string valueStr = values.substr(pos, valueEnd - pos);
-                        try {
-                            requirements.push_back(std::stod(valueStr));
-                        } catch (...) {
-                            requirements.push_back(0.0);
-                        }
-                        
-                        pos = valueEnd;
-                    }
-                }
-                option.decisionRequirement = requirements;
-            }
-            
-            // 提取decisionFeedback数组
-            std::string feedbackArray = extractJsonArray(optionJson, "decisionFeedback");
-            if (!feedbackArray.empty() && feedbackArray.length() > 2) {
-                std::vector<double> feedbacks;
-                size_t start = feedbackArray.find('[') + 1;
-                size_t end = feedbackArray.find(']');
-                if (end != std::string::npos && end > start) {
-                    std::string values = feedbackArray.substr(start, end - start);
-                    size_t pos = 0;
-                    while (pos < values.length()) {
-                        while (pos < values.length() && (values[pos] == ' ' || values[pos] == ',' || values[pos] == '\n' || values[pos] == '\t')) pos++;
-                        if (pos >= values.length()) break;
-                        
-                        size_t valueEnd = values.find_first_of(", ]", pos);
-                        if (valueEnd == std::string::npos) break;
-                        
-                        std::string valueStr = values.substr(pos, valueEnd - pos);
-                        try {
-                            feedbacks.push_back(std::stod(valueStr));
-                        } catch (...) {
-                            feedbacks.push_back(0.0);
-                        }
-                        
-                        pos = valueEnd;
-                    }
-                }
-                option.decisionFeedback = feedbacks;
-            }
-            
-            // 如果向量长度不正确，使用默认值
-            if (option.decisionRequirement.size() != 12) {
-                option.decisionRequirement = std::vector<double>(12, 0.5);
-            }
-            if (option.decisionFeedback.size() != 12) {
-                option.decisionFeedback = std::vector<double>(12, 0.1);
-            }
-            
-            event.options.push_back(option);
-            optionStart = optionEnd + 1;
-        }
-        
-        if (event.options.empty()) {
-            throw std::runtime_error("未解析到任何选项");
-        }
-        
-        return event;
-        
-    } catch (const std::exception& e) {
-        std::cerr << "LLMClient: 解析JSON内容时异常: " << e.what() << std::endl;
-        throw; // 重新抛出异常
+    RandomEvent event;
+    if (!readEvent(document.root(), event)) {
+        throw std::runtime_error("无法解析事件名称、描述、选项或决策向量");
     }
+    return event;
 }
 
-// 从文件加载保存的事件
+// 打开事件库（只读取索引，事件在使用时才解码）
 void LLMClient::loadSavedEvents() {
-    savedEvents.clear();
+    auto start = std::chrono::steady_clock::now();
     
-    std::cout << "LLMClient: 开始加载保存的事件..." << std::endl;
-    
-    // 检查目录是否存在
-    #ifdef _WIN32
-    DWORD dirAttr = GetFileAttributesA("llm_events");
-    if (dirAttr == INVALID_FILE_ATTRIBUTES || !(dirAttr & FILE_ATTRIBUTE_DIRECTORY)) {
-        std::cout << "LLMClient: llm_events目录不存在，无保存事件" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(savedEventCacheMutex);
+        savedEventCache.assign(SAVED_EVENT_CACHE_SIZE, {0, nullptr});
+    }
+    eventStore = std::make_unique<EventStore>();
+    if (!eventStore->open(SAVED_EVENTS_DIRECTORY)) {
+        LOG_ERROR("LLMClient: 无法打开事件库 " << SAVED_EVENTS_DIRECTORY << "，LLM生成的事件将不会保存");
         return;
     }
     
-    // 使用Windows API遍历目录
-    WIN32_FIND_DATAA findData;
-    HANDLE hFind = FindFirstFileA("llm_events\\*.json", &findData);
+    // 旧版本每个事件保存为一个JSON文件，事件库为空时导入一次
+    if (eventStore->size() == 0) {
+        size_t imported = importEventsFromJson(SAVED_EVENTS_DIRECTORY);
+        if (imported > 0) {
+            LOG_INFO("LLMClient: 已从旧版本的JSON事件文件导入 " << imported << " 个事件");
+        }
+    }
     
-    if (hFind == INVALID_HANDLE_VALUE) {
-        std::cout << "LLMClient: 未找到.json事件文件" << std::endl;
-        return;
+    if (eventStore->getDuplicateCount() > 0) {
+        LOG_INFO("LLMClient: 事件库中有 " << eventStore->getDuplicateCount() << " 条重复记录，已跳过");
     }
     
-    int loadedCount = 0;
-    int errorCount = 0;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("LLMClient: 事件库 " << eventStore->getDataPath() << " 共 " << eventStore->size() << " 个事件（"
+             << eventStore->getDataSize() / 1024 << " KB），加载用时 " << elapsed.count() / 1000.0 << " ms");
+}
+
+size_t LLMClient::getSavedEventCount() const {
+    return eventStore ? eventStore->size() : 0;
+}
+
+// 把 directory 下的 *.json 事件文件导入事件库
+size_t LLMClient::importEventsFromJson(const std::string& directory) {
+    if (!eventStore || !eventStore->isOpen()) {
+        LOG_ERROR("LLMClient: 事件库未打开，无法导入");
+        return 0;
+    }
     
-    do {
-        // 跳过目录
-        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-            continue;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory, ec)) {
+        LOG_ERROR("LLMClient: 目录不存在: " << directory);
+        return 0;
+    }
+    
+    // 按文件名排序，导入顺序与保存顺序一致
+    std::vector<std::filesystem::path> files;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().extension() == ".json") {
+            files.push_back(it->path());
         }
-        
-        std::string filename = "llm_events\\" + std::string(findData.cFileName);
-        std::cout << "LLMClient: 加载事件文件: " << filename << std::endl;
-        
+    }
+    if (files.empty()) {
+        return 0;
+    }
+    std::sort(files.begin(), files.end());
+    
+    // 读取、解析和验证在多个线程中进行，每个文件的结果放在自己的位置上；写入事件库按文件顺序进行
+    std::vector<RandomEvent> events(files.size());
+    std::vector<char> valid(files.size(), 0);
+    std::atomic<size_t> errorCount{0};
+    parallelFor(files.size(), eventLoadThreads, [&](size_t i) {
+        const auto& path = files[i];
         try {
-            // 读取文件内容
-            std::ifstream file(filename);
+            std::ifstream file(path, std::ios::binary);
             if (!file.is_open()) {
-                std::cerr << "LLMClient: 无法打开文件: " << filename << std::endl;
+                LOG_ERROR("LLMClient: 无法打开文件: " << path.string());
                 errorCount++;
-                continue;
+                return;
+            }
+            std::string content;
+            std::error_code sizeError;
+            uintmax_t size = std::filesystem::file_size(path, sizeError);
+            if (!sizeError) {
+                content.resize(static_cast<size_t>(size));
+                file.read(&content[0], static_cast<std::streamsize>(content.size()));
+                content.resize(static_cast<size_t>(file.gcount()));
             }
             
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string fileContent = buffer.str();
-            file.close();
-            
-            // 解析事件
-            RandomEvent event = parseEventFromJsonContent(fileContent);
-            
-            // 验证事件
-            if (validateEvent(event)) {
-                savedEvents.push_back(event);
-                loadedCount++;
-                std::cout << "LLMClient: 成功加载事件: " << event.name << std::endl;
+            events[i] = parseEventFromJsonContent(content);
+            if (validateEvent(events[i])) {
+                valid[i] = 1;
             } else {
-                std::cerr << "LLMClient: 事件验证失败: " << filename << std::endl;
+                LOG_WARN("LLMClient: 事件验证失败: " << path.string());
                 errorCount++;
             }
-            
         } catch (const std::exception& e) {
-            std::cerr << "LLMClient: 加载文件时异常 " << filename << ": " << e.what() << std::endl;
+            LOG_ERROR("LLMClient: 加载文件时异常 " << path.string() << ": " << e.what());
             errorCount++;
         }
-        
-    } while (FindNextFileA(hFind, &findData) != 0);
+    });
     
-    FindClose(hFind);
+    size_t importedCount = 0;
+    size_t duplicateCount = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (!valid[i]) {
+            continue;
+        }
+        switch (eventStore->append(events[i])) {
+            case EventStore::AppendResult::Added:
+                importedCount++;
+                break;
+            case EventStore::AppendResult::Duplicate:
+                duplicateCount++;
+                break;
+            case EventStore::AppendResult::Failed:
+                errorCount++;
+                break;
+        }
+        // 导入后的事件不再需要，及时释放
+        events[i] = RandomEvent();
+    }
+    
+    LOG_INFO("LLMClient: 从 " << directory << " 导入 " << importedCount << " 个事件，"
+             << duplicateCount << " 个重复，" << errorCount << " 个错误");
+    return importedCount;
+}
+
+// 把事件库中的所有事件导出为 JSON 文件
+size_t LLMClient::exportEventsToJson(const std::string& directory) {
+    if (!eventStore || !eventStore->isOpen()) {
+        LOG_ERROR("LLMClient: 事件库未打开，无法导出");
+        return 0;
+    }
     
-    std::cout << "LLMClient: 事件加载完成，成功加载 " << loadedCount << " 个事件，" 
-              << errorCount << " 个错误，总共 " << savedEvents.size() << " 个保存事件" << std::endl;
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
     
-#else
-    std::cout << "LLMClient: 文件遍历需要Windows平台" << std::endl;
-#endif
+    size_t exportedCount = 0;
+    size_t total = eventStore->size();
+    RandomEvent event;
+    for (size_t i = 0; i < total; ++i) {
+        if (!eventStore->read(i, event)) {
+            continue;
+        }
+        char filename[32];
+        snprintf(filename, sizeof(filename), "event_%06zu.json", i);
+        std::filesystem::path path = std::filesystem::path(directory) / filename;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("LLMClient: 无法打开文件保存事件: " << path.string());
+            continue;
+        }
+        writeEventJson(file, event);
+        if (file) {
+            exportedCount++;
+        }
+    }
+    
+    LOG_INFO("LLMClient: 已导出 " << exportedCount << "/" << total << " 个事件到 " << directory);
+    return exportedCount;
 }
 
 // 获取保存的LLM生成事件（用于模拟模式下的备用事件）
-LLMClient::RandomEvent LLMClient::getSavedRandomEvent() {
-    if (savedEvents.empty()) {
-        // 如果没有保存的事件，返回模拟事件
-        std::cout << "LLMClient: 无保存事件，返回模拟事件" << std::endl;
-        return generateSimulatedEvent();
+LLMClient::EventHandle LLMClient::getSavedRandomEvent() {
+    size_t count = getSavedEventCount();
+    if (count > 0) {
+        CounterRng rng(CounterRng::deriveStream(CounterRng::STREAM_LLM_SAVED, randomTick++));
+        std::uniform_int_distribution<size_t> dist(0, count - 1);
+        size_t index = dist(rng);
+        
+        // 解码过的事件直接共享；未命中时在锁外解码，再放入缓存
+        EventHandle event;
+        {
+            std::lock_guard<std::mutex> lock(savedEventCacheMutex);
+            const auto& cached = savedEventCache[index % SAVED_EVENT_CACHE_SIZE];
+            if (cached.second && cached.first == index) {
+                event = cached.second;
+            }
+        }
+        if (!event) {
+            auto decoded = std::make_shared<RandomEvent>();
+            if (eventStore->read(index, *decoded)) {
+                event = std::move(decoded);
+                std::lock_guard<std::mutex> lock(savedEventCacheMutex);
+                savedEventCache[index % SAVED_EVENT_CACHE_SIZE] = {index, event};
+            }
+        }
+        if (event) {
+            metrics.countOutcome(LLMMetrics::Outcome::EventFallbackSaved);
+            LOG_DEBUG("LLMClient: 使用保存的事件 #" << index << ": " << event->name);
+            return event;
+        }
     }
     
-    static std::mt19937 rng(std::random_device{}());
-    std::uniform_int_distribution<int> dist(0, savedEvents.size() - 1);
-    int index = dist(rng);
-    
-    std::cout << "LLMClient: 使用保存的事件 #" << index << ": " << savedEvents[index].name << std::endl;
-    return savedEvents[index];
+    // 如果没有保存的事件，返回模拟事件
+    metrics.countOutcome(LLMMetrics::Outcome::EventFallbackSimulated);
+    LOG_DEBUG("LLMClient: 无保存事件，返回模拟事件");
+    return std::make_shared<const RandomEvent>(generateSimulatedEvent());
 }
@@ -1,25 +1,57 @@
 #pragma once
 
+#include "ChoiceCache.h"
+#include "DecisionVector.h"
+#include "HttpTransport.h"
+#include "LLMHealthMonitor.h"
+#include "LLMMetrics.h"
+#include "RetryPolicy.h"
+#include "Json.h"
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
+#include <cstdint>
+#include <iosfwd>
 
 // LLM客户端，用于与OpenAI API交互
+// initialize() 之后的所有公开方法都可以在多个线程中同时调用
+class EventStore;
+
 class LLMClient {
 public:
+    // 默认同时进行的API请求上限
+    static constexpr size_t DEFAULT_MAX_IN_FLIGHT = 4;
+    
+    // 默认每次API请求生成的事件数量（1 表示不批量）
+    static constexpr size_t DEFAULT_EVENT_BATCH_SIZE = 1;
+    
+    // 单次请求允许的最大事件数量
+    static constexpr size_t MAX_EVENT_BATCH_SIZE = 16;
+    
+    // 默认每个事件的 max_tokens 预算，以及批量请求 max_tokens 总量的上限
+    static constexpr size_t DEFAULT_EVENT_MAX_TOKENS = 1500;
+    static constexpr size_t DEFAULT_BATCH_MAX_TOKENS = 8192;
+    
     // 单例模式获取实例
     static LLMClient& getInstance();
     
-    // 初始化LLM客户端，从配置文件加载设置
+    // 初始化LLM客户端，从配置文件加载设置（应在其他线程使用客户端之前调用）
     bool initialize(const std::string& configPath = "config.json");
     
     // 获取随机事件描述和选项
     // 返回: 事件描述和选项列表，每个选项包括文本和决策要求向量
     struct EventOption {
         std::string text;
-        std::vector<double> decisionRequirement; // 12维决策要求
-        std::vector<double> decisionFeedback;    // 12维决策反馈
+        DecisionVector decisionRequirement; // 12维决策要求
+        DecisionVector decisionFeedback;    // 12维决策反馈
         std::string outcomeText;
     };
     
@@ -29,24 +61,100 @@ public:
         std::vector<EventOption> options;
     };
     
-    // 生成随机事件
-    RandomEvent generateRandomEvent();
+    // 共享的不可变事件：生成后不再修改，在预取队列、模拟环境和选择请求之间只传递引用计数，不复制内容
+    // SimulationEnvironment 的事件和选项也使用这两个类型
+    using EventHandle = std::shared_ptr<const RandomEvent>;
+    
+    // 生成随机事件（API失败或模拟模式时返回保存的事件或模拟事件）
+    EventHandle generateRandomEvent();
+    
+    // 仅通过API生成随机事件，不回退：成功且事件有效时写入 event 并返回 true
+    // 批量大小大于1时一次请求多个事件，多余的有效事件留待后续调用直接返回
+    // 可在多个线程中同时调用（用于后台预取）；stop 触发时正在进行的请求立即中止，不再重试
+    bool tryGenerateRandomEvent(EventHandle& event, const std::shared_ptr<HttpStopSignal>& stop = nullptr);
+    
+    // 仅通过API在一次请求中生成 count 个事件，逐个验证，有效的追加到 events
+    // 返回有效事件的数量（部分事件无效时仍保留其余有效事件）
+    size_t tryGenerateRandomEvents(size_t count, std::vector<RandomEvent>& events,
+                                   const std::shared_ptr<HttpStopSignal>& stop = nullptr);
+    
+    // 是否以流式（SSE）请求生成事件：边接收边检查结构，结构无效时立即中止请求
+    void setStreamingEnabled(bool enabled) { streamEvents = enabled; }
+    bool isStreamingEnabled() const { return streamEvents; }
+    
+    // 设置每次API请求生成的事件数量（1 到 MAX_EVENT_BATCH_SIZE）
+    void setEventBatchSize(size_t size);
+    size_t getEventBatchSize() const { return eventBatchSize; }
+    
+    // 是否处于模拟模式（不访问API）
+    bool isSimulationMode() const { return simulationMode; }
     
     // 当没有符合的选项时，提交决策向量给LLM，获取选择
     // 参数: agentId, 决策向量(12维), 事件描述, 选项列表
     // 返回: 选择的选项索引，或-1表示无法选择
-    int getLLMChoice(int agentId, const std::vector<double>& decisionVector,
+    // 相同事件、决策向量落在同一量化网格内的选择直接从缓存返回，不再请求API
+    int getLLMChoice(int agentId, const DecisionVector& decisionVector,
                      const std::string& eventDescription,
                      const std::vector<EventOption>& options);
     
-    // 检查API连接
+    // getLLMChoice 是否可以直接从缓存返回（不计入缓存统计）
+    bool hasCachedChoice(const DecisionVector& decisionVector, const std::string& eventDescription,
+                         const std::vector<EventOption>& options) const;
+    
+    // LLM选择缓存（统计信息）
+    const ChoiceCache& getChoiceCache() const { return choiceCache; }
+    
+    // 把选择缓存保存到配置的文件（未配置 llm_choice_cache_file 时不保存）
+    void saveChoiceCache();
+    
+    // 异步生成随机事件：在后台线程池中执行 generateRandomEvent，立即返回
+    std::future<EventHandle> generateRandomEventAsync();
+    
+    // 异步获取LLM选择：在后台线程池中执行 getLLMChoice（持有事件的引用，不复制描述和选项）
+    std::future<int> getLLMChoiceAsync(int agentId, const DecisionVector& decisionVector, EventHandle event);
+    
+    // 设置同时进行的API请求上限（同步和异步调用共享这一上限，也是后台线程池的大小）
+    void setMaxInFlight(size_t limit);
+    size_t getMaxInFlight() const;
+    
+    // 当前正在进行的API请求数
+    size_t getInFlightCount() const;
+    
+    // 检查API连接（发送测试请求并打印诊断信息，结果计入健康状态）
     bool testConnection();
     
-    // 获取保存的LLM生成事件（用于模拟模式下的备用事件）
-    RandomEvent getSavedRandomEvent();
+    // LLM服务是否可用：模拟模式，或API未熔断（使用缓存的健康状态，不发送请求）
+    bool isAvailable() const;
+    
+    // 健康监测与熔断器（状态和统计信息）
+    const LLMHealthMonitor& getHealthMonitor() const { return healthMonitor; }
+    
+    // 重试策略（统计信息）
+    const RetryPolicy& getRetryPolicy() const { return retryPolicy; }
+    
+    // 请求遥测：延迟分布、token用量、结果和在途请求数（线程安全，调用方也可以记录结果）
+    const LLMMetrics& getMetrics() const { return metrics; }
+    LLMMetrics& getMetrics() { return metrics; }
+    
+    // 把遥测数据以JSON格式保存到配置的文件（未配置 llm_metrics_file 时不保存）
+    void saveMetrics();
+    
+    // 获取保存的LLM生成事件（用于模拟模式下的备用事件），事件库为空时返回模拟事件
+    // 解码过的事件按索引缓存，再次选中时直接共享
+    EventHandle getSavedRandomEvent();
+    
+    // 事件库中保存的事件数
+    size_t getSavedEventCount() const;
+    
+    // 把 directory 下的 *.json 事件文件导入事件库（多线程解析，内容相同的事件只导入一次），返回导入的事件数
+    size_t importEventsFromJson(const std::string& directory);
+    
+    // 把事件库中的所有事件导出为 directory 下的 JSON 文件（每个事件一个文件），返回导出的事件数
+    size_t exportEventsToJson(const std::string& directory);
     
 private:
     LLMClient() = default;
+    ~LLMClient();
     LLMClient(const LLMClient&) = delete;
     LLMClient& operator=(const LLMClient&) = delete;
     
@@ -61,29 +169,151 @@ private:
     // 模拟模式（当没有API密钥时）
     bool simulationMode;
     
-    // 保存的LLM生成事件（作为备用事件）
-    std::vector<RandomEvent> savedEvents;
+    // 保存的LLM生成事件（作为备用事件）：llm_events/ 下的事件库，后台预取线程也会追加
+    std::unique_ptr<EventStore> eventStore;
+    
+    // 从事件库解码过的事件（按索引直接映射，槽位冲突时替换），事件库只追加，索引不会失效
+    static constexpr size_t SAVED_EVENT_CACHE_SIZE = 4096;
+    std::vector<std::pair<size_t, EventHandle>> savedEventCache;
+    std::mutex savedEventCacheMutex;
+    
+    // 导入JSON事件文件时的解析线程数（0 表示使用全部硬件线程）
+    unsigned eventLoadThreads = 0;
     
-    // 发送HTTP请求到OpenAI API
-    std::string sendRequest(const std::string& endpoint, const std::string& body);
+    // 事件生成请求的 max_tokens：每个事件的预算，批量请求的总量不超过 batchMaxTokens（initialize() 时读取）
+    size_t eventMaxTokens = DEFAULT_EVENT_MAX_TOKENS;
+    size_t batchMaxTokens = DEFAULT_BATCH_MAX_TOKENS;
+    
+    // 生成 count 个事件的请求使用的 max_tokens（至少为一个事件的预算）
+    size_t eventRequestMaxTokens(size_t count) const;
+    
+    // 随机数调用计数：每次需要随机数的调用取一个新的tick，派生独立的 CounterRng 流
+    std::atomic<uint64_t> randomTick{0};
+    
+    // HTTP传输层（持久 keep-alive 连接，多线程共享）
+    HttpTransport transport;
+    
+    // 重试策略：退避、截止时间和对冲请求
+    RetryPolicy retryPolicy;
+    
+    // 请求遥测及其JSON文件（空表示不保存）
+    LLMMetrics metrics;
+    std::string metricsFile;
+    
+    // 对冲请求在后台线程中发送，落后的请求结束前析构函数需要等待
+    size_t backgroundRequests = 0;
+    std::mutex backgroundMutex;
+    std::condition_variable backgroundDone;
+    
+    // 健康监测与熔断器：连续失败后请求立即失败，后台探测恢复（探测线程使用 transport，须在其后声明）
+    LLMHealthMonitor healthMonitor;
+    
+    // 每次API请求生成的事件数量
+    std::atomic<size_t> eventBatchSize{DEFAULT_EVENT_BATCH_SIZE};
+    
+    // 是否以流式请求生成事件
+    std::atomic<bool> streamEvents{false};
+    
+    // LLM选择缓存及其持久化文件（空表示不保存）
+    ChoiceCache choiceCache;
+    std::string choiceCacheFile;
+    
+    // 批量请求中尚未返回给调用方的有效事件
+    std::deque<EventHandle> pendingEvents;
+    std::mutex pendingEventsMutex;
+    
+    // API请求并发上限：sendRequest 在请求数达到上限时等待
+    size_t maxInFlight = DEFAULT_MAX_IN_FLIGHT;
+    size_t inFlight = 0;
+    mutable std::mutex inFlightMutex;
+    std::condition_variable inFlightReleased;
+    
+    // 异步调用的后台线程池（按需创建，最多 maxInFlight 个线程）
+    std::deque<std::function<void()>> asyncTasks;
+    std::vector<std::thread> asyncWorkers;
+    std::mutex asyncMutex;
+    std::condition_variable asyncTaskReady;
+    bool asyncStopping = false;
+    
+    // 提交一个后台任务
+    void submitAsync(std::function<void()> task);
+    
+    // 后台线程主循环
+    void asyncWorkerLoop();
+    
+    // 在并发上限内发送请求（onData 非空时流式接收 2xx 响应体）
+    // 熔断期间不发送，立即返回 statusCode 为0的响应；请求结果计入健康状态和遥测
+    // stop 触发时不再等待请求名额，正在进行的请求立即中止
+    HttpResponse postWithLimit(const std::string& endpoint, const std::string& body,
+                               const HttpTransport::BodyCallback& onData, RetryPolicy::RequestKind kind,
+                               const std::shared_ptr<HttpStopSignal>& stop);
+    
+    // 发送一个最小的请求检查服务是否可用（不经过熔断器和并发上限）
+    bool probeConnection();
+    
+    // 按重试策略发送请求：可重试的失败在退避后重试，直到成功、重试用尽、超过截止时间或熔断
+    // 延迟样本足够时非流式请求超过延迟分位数后发送一个对冲请求，先返回的结果胜出
+    // 流式请求在已经收到数据后不再重试；stop 触发时中止请求并跳过剩余的退避和重试
+    HttpResponse postWithRetry(const std::string& endpoint, const std::string& body,
+                               const HttpTransport::BodyCallback& onData, RetryPolicy::RequestKind kind,
+                               const std::shared_ptr<HttpStopSignal>& stop = nullptr);
+    
+    // 先发送一个请求，hedgeAfter 之后仍未返回时再发送一个相同的请求，返回先得到的不需重试的结果
+    HttpResponse postHedged(const std::string& endpoint, const std::string& body,
+                            std::chrono::milliseconds hedgeAfter, RetryPolicy::RequestKind kind,
+                            bool hasDeadline, std::chrono::steady_clock::time_point deadline,
+                            const std::shared_ptr<HttpStopSignal>& stop);
+    
+    // 发送HTTP请求到OpenAI API（按重试策略），传输失败时返回空字符串
+    std::string sendRequest(const std::string& endpoint, const std::string& body,
+                            RetryPolicy::RequestKind kind = RetryPolicy::RequestKind::Other,
+                            const std::shared_ptr<HttpStopSignal>& stop = nullptr);
+    
+    // 预编译的请求模板：模型名、系统提示等固定部分在 initialize() 时转义一次，每次请求只写入可变部分
+    struct RequestTemplate {
+        std::string prefix;          // 固定部分的JSON文本
+        JsonWriter::State state;     // 前缀末尾的写入器状态
+    };
+    RequestTemplate eventRequestTemplate;    // 事件生成请求，前缀结束于 user 消息中的系统提示之后
+    RequestTemplate choiceRequestTemplate;   // 选项选择请求，前缀结束于 user 消息内容的开头
+    
+    // 根据当前配置重建请求模板
+    void buildRequestTemplates();
+    
+    // 构建事件生成请求体（count 大于1时要求返回事件数组），写入当前线程复用的缓冲区
+    const std::string& buildEventRequest(size_t count, size_t maxTokens, bool stream);
+    
+    // 以流式请求生成 count 个事件（count 为1时要求单个事件对象），返回通过验证的事件
+    std::vector<RandomEvent> generateEventsStreaming(size_t count, size_t maxTokens,
+                                                     const std::shared_ptr<HttpStopSignal>& stop);
     
     // 解析LLM响应
     RandomEvent parseEventResponse(const std::string& response);
+    
+    // 从OpenAI兼容响应中提取第一个choice的message.content（处理转义字符），失败返回空字符串
+    // 响应中的 usage 计入 kind 类请求的 token 用量
+    std::string extractResponseContent(const std::string& response, RetryPolicy::RequestKind kind);
+    
+    // 解析批量事件响应：content 为事件对象的JSON数组（也接受单个事件对象），只返回通过验证的事件
+    std::vector<RandomEvent> parseEventBatchResponse(const std::string& response);
     int parseChoiceResponse(const std::string& response);
     
     // 生成模拟事件（当simulationMode为true时）
     RandomEvent generateSimulatedEvent();
     
     // 生成模拟选择
-    int generateSimulatedChoice(int agentId, const std::vector<double>& decisionVector,
+    int generateSimulatedChoice(int agentId, const DecisionVector& decisionVector,
                                 const std::vector<EventOption>& options);
     
-    // 保存事件到文件
-    void saveEventToFile(const RandomEvent& event);
+    // 保存事件到事件库
+    void saveEvent(const RandomEvent& event);
     
-    // 从文件加载保存的事件
+    // 打开事件库；事件库为空时导入旧版本保存的 llm_events/*.json
     void loadSavedEvents();
     
+    // 以JSON格式写出事件（导出和旧版本的保存格式相同）
+    static void writeEventJson(std::ostream& out, const RandomEvent& event);
+    
     // 检查事件是否符合要求（10个选项，每个选项有12维向量）
     bool validateEvent(const RandomEvent& event);
     
@@ -0,0 +1,242 @@
+// LLMClient 并发测试：对本地 mock_llm_server 同时发起大量异步和同步的选择、事件请求，
+// 检查同时进行的请求数从不超过 maxInFlight（并且确实达到上限），所有调用都得到有效结果
+// 用法: llm_client_concurrency_test <mock_llm_server 路径> [端口]
+// 在当前目录写入 config.json 和 llm_events/；失败时输出原因并返回非零
+#include "LLMClient.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <csignal>
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+namespace {
+    using Kind = RetryPolicy::RequestKind;
+
+    constexpr size_t MAX_IN_FLIGHT = 4;
+    constexpr int SYNC_THREADS = 8;
+    constexpr int SYNC_CHOICES_PER_THREAD = 4;
+    constexpr int ASYNC_CHOICES = 48;
+    constexpr int ASYNC_EVENTS = 12;
+
+    int failures = 0;
+
+    void expect(bool condition, const std::string& message) {
+        if (!condition) {
+            ++failures;
+            std::cout << "失败: " << message << std::endl;
+        }
+    }
+
+    // 在后台运行 mock_llm_server，析构时停止
+    class ServerProcess {
+    public:
+        ServerProcess(const std::string& path, const std::vector<std::string>& args) {
+#ifdef _WIN32
+            std::string commandLine = "\"" + path + "\"";
+            for (const auto& arg : args) {
+                commandLine += " " + arg;
+            }
+            STARTUPINFOA startup{};
+            startup.cb = sizeof(startup);
+            started = CreateProcessA(NULL, &commandLine[0], NULL, NULL, FALSE, 0, NULL, NULL, &startup, &process) != 0;
+#else
+            std::vector<char*> argv;
+            argv.push_back(const_cast<char*>(path.c_str()));
+            for (const auto& arg : args) {
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            }
+            argv.push_back(nullptr);
+            started = posix_spawn(&pid, path.c_str(), nullptr, nullptr, argv.data(), environ) == 0;
+#endif
+        }
+
+        ~ServerProcess() {
+            if (!started) {
+                return;
+            }
+#ifdef _WIN32
+            TerminateProcess(process.hProcess, 0);
+            WaitForSingleObject(process.hProcess, INFINITE);
+            CloseHandle(process.hThread);
+            CloseHandle(process.hProcess);
+#else
+            kill(pid, SIGINT);
+            waitpid(pid, nullptr, 0);
+#endif
+        }
+
+        ServerProcess(const ServerProcess&) = delete;
+        ServerProcess& operator=(const ServerProcess&) = delete;
+
+        bool isStarted() const { return started; }
+
+    private:
+        bool started = false;
+#ifdef _WIN32
+        PROCESS_INFORMATION process{};
+#else
+        pid_t pid = 0;
+#endif
+    };
+
+    // 等待服务器开始接受请求
+    bool waitForServer(const std::string& baseUrl) {
+        HttpTransport transport;
+        transport.setBaseUrl(baseUrl);
+        transport.setTimeoutSeconds(1);
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            if (transport.post("v1/chat/completions", "{}").statusCode != 0) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return false;
+    }
+
+    // 没有代理满足要求的事件（选择请求总是交给LLM）
+    LLMClient::EventHandle buildEvent() {
+        LLMClient::RandomEvent event;
+        event.name = "并发测试";
+        event.description = "测试同时进行的选择请求";
+        for (int i = 0; i < 10; ++i) {
+            LLMClient::EventOption option;
+            option.text = "选项" + std::to_string(i + 1);
+            for (int d = 0; d < DecisionVector::DIMENSIONS; ++d) {
+                option.decisionRequirement[d] = 1.0;
+                option.decisionFeedback[d] = 0.0;
+            }
+            option.outcomeText = "结果";
+            event.options.push_back(std::move(option));
+        }
+        return std::make_shared<const LLMClient::RandomEvent>(std::move(event));
+    }
+
+    // 每个代理的决策向量互不相同
+    DecisionVector agentVector(int agentId) {
+        DecisionVector vector;
+        for (int d = 0; d < DecisionVector::DIMENSIONS; ++d) {
+            vector[d] = static_cast<double>((agentId * 7 + d * 13) % 100) / 100.0;
+        }
+        return vector;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "用法: " << argv[0] << " <mock_llm_server 路径> [端口]" << std::endl;
+        return 2;
+    }
+    std::string port = argc > 2 ? argv[2] : "18473";
+    std::string baseUrl = "http://127.0.0.1:" + port;
+
+    ServerProcess server(argv[1], {"--port", port, "--latency", "fixed:100", "--choice-latency", "fixed:50"});
+    if (!server.isStarted() || !waitForServer(baseUrl)) {
+        std::cout << "失败: 无法启动 " << argv[1] << std::endl;
+        return 1;
+    }
+
+    // 关闭选择缓存（每个请求都发送到服务器）和后台探测
+    {
+        std::ofstream config("config.json");
+        config << "{\"openai_base_url\": \"" << baseUrl << "\", \"llm_max_in_flight\": " << MAX_IN_FLIGHT
+               << ", \"llm_choice_cache_size\": 0, \"llm_health_probe\": false}";
+    }
+    LLMClient& client = LLMClient::getInstance();
+    client.initialize("config.json");
+    expect(!client.isSimulationMode(), "LLMClient 未使用API模式");
+    expect(client.getMaxInFlight() == MAX_IN_FLIGHT, "llm_max_in_flight 未生效");
+
+    // 调用进行期间持续采样请求名额的占用数（所有类型合计）；分别读取各类型的指标计数不是同一时刻的值，
+    // 相加可能超过实际的在途请求数
+    const LLMMetrics& metrics = client.getMetrics();
+    std::atomic<bool> sampling{true};
+    std::atomic<int64_t> sampledPeak{0};
+    std::thread sampler([&]() {
+        while (sampling) {
+            int64_t total = static_cast<int64_t>(client.getInFlightCount());
+            sampledPeak = std::max<int64_t>(sampledPeak, total);
+            std::this_thread::yield();
+        }
+    });
+
+    LLMClient::EventHandle event = buildEvent();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<int>> choices;
+    std::vector<std::future<LLMClient::EventHandle>> events;
+    for (int i = 0; i < ASYNC_CHOICES; ++i) {
+        choices.push_back(client.getLLMChoiceAsync(i, agentVector(i), event));
+        if (i % (ASYNC_CHOICES / ASYNC_EVENTS) == 0) {
+            events.push_back(client.generateRandomEventAsync());
+        }
+    }
+    std::atomic<int> invalidSyncChoices{0};
+    std::vector<std::thread> syncCallers;
+    for (int t = 0; t < SYNC_THREADS; ++t) {
+        syncCallers.emplace_back([&, t]() {
+            for (int i = 0; i < SYNC_CHOICES_PER_THREAD; ++i) {
+                int agentId = ASYNC_CHOICES + t * SYNC_CHOICES_PER_THREAD + i;
+                int choice = client.getLLMChoice(agentId, agentVector(agentId), event->description, event->options);
+                if (choice < 0 || choice >= static_cast<int>(event->options.size())) {
+                    ++invalidSyncChoices;
+                }
+            }
+        });
+    }
+
+    int invalidChoices = 0;
+    for (auto& choice : choices) {
+        int index = choice.get();
+        if (index < 0 || index >= static_cast<int>(event->options.size())) {
+            ++invalidChoices;
+        }
+    }
+    int invalidEvents = 0;
+    for (auto& future : events) {
+        LLMClient::EventHandle generated = future.get();
+        if (!generated || generated->options.size() != 10) {
+            ++invalidEvents;
+        }
+    }
+    for (auto& caller : syncCallers) {
+        caller.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sampling = false;
+    sampler.join();
+
+    const int64_t limit = static_cast<int64_t>(MAX_IN_FLIGHT);
+    int64_t choicePeak = metrics.getPeakInFlight(Kind::Choice);
+    int64_t eventPeak = metrics.getPeakInFlight(Kind::Event);
+    std::cout << "请求 " << ASYNC_CHOICES + SYNC_THREADS * SYNC_CHOICES_PER_THREAD << " 个选择、"
+              << ASYNC_EVENTS << " 个事件，用时 " << seconds << " 秒；最大在途: 选择 " << choicePeak
+              << "，事件 " << eventPeak << "，合计（采样） " << sampledPeak << "，上限 " << limit << std::endl;
+
+    expect(invalidChoices == 0, std::to_string(invalidChoices) + " 个异步选择无效");
+    expect(invalidSyncChoices == 0, std::to_string(invalidSyncChoices) + " 个同步选择无效");
+    expect(invalidEvents == 0, std::to_string(invalidEvents) + " 个异步事件无效");
+    expect(metrics.getOutcomeCount(LLMMetrics::Outcome::EventValid) == ASYNC_EVENTS, "异步事件没有全部由API生成");
+    expect(client.getInFlightCount() == 0, "调用结束后仍有在途请求");
+    expect(choicePeak <= limit && eventPeak <= limit && sampledPeak <= limit, "在途请求数超过上限");
+    expect(choicePeak == limit, "选择请求没有达到并发上限（异步调用没有并行执行）");
+    expect(metrics.getRequestCount(Kind::Choice) >= ASYNC_CHOICES + SYNC_THREADS * SYNC_CHOICES_PER_THREAD,
+           "选择请求没有全部发送到服务器");
+
+    if (failures == 0) {
+        std::cout << "LLMClient 并发: 全部通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
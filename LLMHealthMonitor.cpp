@@ -0,0 +1,153 @@
+#include "LLMHealthMonitor.h"
+#include "Logger.h"
+#include <algorithm>
+
+LLMHealthMonitor::~LLMHealthMonitor() {
+    stopProbing();
+}
+
+void LLMHealthMonitor::configure(int threshold, double openSeconds) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        failureThreshold = std::max(1, threshold);
+        openDuration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(openSeconds > 0.0 ? openSeconds : DEFAULT_OPEN_SECONDS));
+        state = State::Closed;
+        consecutiveFailures = 0;
+    }
+    stateChanged.notify_all();
+}
+
+void LLMHealthMonitor::startProbing(Probe newProbe) {
+    stopProbing();
+    std::lock_guard<std::mutex> lock(mutex);
+    probe = std::move(newProbe);
+    stopping = false;
+    probing = true;
+    prober = std::thread(&LLMHealthMonitor::probeLoop, this);
+}
+
+void LLMHealthMonitor::stopProbing() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!prober.joinable()) {
+            return;
+        }
+        stopping = true;
+    }
+    stateChanged.notify_all();
+    prober.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    probe = Probe();
+    probing = false;
+    // 探测线程可能停在试探中途，交给业务请求继续试探
+    if (state == State::HalfOpen) {
+        state = State::Open;
+    }
+}
+
+bool LLMHealthMonitor::allowRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == State::Closed) {
+        return true;
+    }
+    if (state == State::Open && !probing && openExpiredLocked()) {
+        // 熔断到期：放行这一个请求作为试探
+        state = State::HalfOpen;
+        return true;
+    }
+    ++rejectedCount;
+    return false;
+}
+
+void LLMHealthMonitor::recordSuccess() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != State::Closed) {
+        LOG_INFO("LLMHealthMonitor: LLM服务已恢复，关闭熔断器");
+    }
+    state = State::Closed;
+    consecutiveFailures = 0;
+}
+
+void LLMHealthMonitor::recordFailure() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state == State::HalfOpen) {
+            // 试探失败，重新计时
+            state = State::Open;
+            openedAt = Clock::now();
+            return;
+        }
+        if (state == State::Open || ++consecutiveFailures < failureThreshold) {
+            return;
+        }
+        tripLocked();
+    }
+    stateChanged.notify_all();
+}
+
+void LLMHealthMonitor::tripLocked() {
+    state = State::Open;
+    openedAt = Clock::now();
+    ++tripCount;
+    LOG_WARN("LLMHealthMonitor: 连续 " << consecutiveFailures << " 次请求失败，熔断 "
+             << std::chrono::duration<double>(openDuration).count() << " 秒，期间使用本地回退");
+}
+
+bool LLMHealthMonitor::openExpiredLocked() const {
+    return Clock::now() - openedAt >= openDuration;
+}
+
+bool LLMHealthMonitor::isAvailable() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state == State::Closed || (state == State::Open && !probing && openExpiredLocked());
+}
+
+LLMHealthMonitor::State LLMHealthMonitor::getState() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+const char* LLMHealthMonitor::stateName(State state) {
+    switch (state) {
+        case State::Closed:   return "正常";
+        case State::Open:     return "熔断";
+        case State::HalfOpen: return "试探中";
+    }
+    return "未知";
+}
+
+void LLMHealthMonitor::probeLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (state != State::Open) {
+            // 正常时等待熔断
+            stateChanged.wait(lock);
+            continue;
+        }
+        if (!openExpiredLocked()) {
+            stateChanged.wait_until(lock, openedAt + openDuration);
+            continue;
+        }
+
+        // 熔断到期：发送试探请求（期间业务请求仍立即失败）
+        state = State::HalfOpen;
+        ++probeCount;
+        lock.unlock();
+        bool healthy = probe();
+        lock.lock();
+
+        if (state != State::HalfOpen) {
+            continue;
+        }
+        if (healthy) {
+            state = State::Closed;
+            consecutiveFailures = 0;
+            LOG_INFO("LLMHealthMonitor: 探测成功，LLM服务已恢复");
+        } else {
+            state = State::Open;
+            openedAt = Clock::now();
+        }
+    }
+}
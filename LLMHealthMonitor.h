@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// LLM服务健康监测与熔断器
+// 记录每次请求的结果，连续失败达到阈值后熔断（Open）：之后的请求立即失败，由调用方使用本地回退
+// 熔断持续 openSeconds 后试探一次（HalfOpen）：成功则恢复（Closed），失败则重新熔断
+// 启用后台探测时由后台线程发送试探请求，业务请求在服务恢复之前始终立即失败；否则由到期后的第一个业务请求试探
+// 所有方法都可以在多个线程中同时调用
+class LLMHealthMonitor {
+public:
+    enum class State {
+        Closed,     // 正常，放行所有请求
+        Open,       // 熔断，请求立即失败
+        HalfOpen    // 正在试探，其他请求立即失败
+    };
+
+    // 默认连续失败多少次后熔断
+    static constexpr int DEFAULT_FAILURE_THRESHOLD = 3;
+
+    // 默认熔断持续时间（秒），也是后台探测的间隔
+    static constexpr double DEFAULT_OPEN_SECONDS = 10.0;
+
+    // 探测函数：发送一个试探请求，服务可用时返回 true
+    using Probe = std::function<bool()>;
+
+    LLMHealthMonitor() = default;
+    ~LLMHealthMonitor();
+
+    LLMHealthMonitor(const LLMHealthMonitor&) = delete;
+    LLMHealthMonitor& operator=(const LLMHealthMonitor&) = delete;
+
+    // 设置熔断阈值和熔断持续时间（恢复为 Closed 状态）
+    void configure(int failureThreshold, double openSeconds);
+
+    // 启动后台探测线程（已在运行时先停止）
+    void startProbing(Probe probe);
+
+    // 停止后台探测线程（会等待正在进行的探测结束）
+    void stopProbing();
+
+    // 是否放行一个请求：Closed 时放行；熔断期间返回 false；未启用后台探测时，熔断到期后放行一个试探请求
+    // 放行的请求结束后必须调用 recordSuccess 或 recordFailure
+    bool allowRequest();
+
+    // 记录请求结果
+    void recordSuccess();
+    void recordFailure();
+
+    // 缓存的健康状态（不发送请求）：Closed，或未启用后台探测且熔断已到期
+    bool isAvailable() const;
+
+    State getState() const;
+    static const char* stateName(State state);
+
+    // 统计：熔断次数、因熔断而立即失败的请求数、后台探测次数
+    uint64_t getTripCount() const { return tripCount; }
+    uint64_t getRejectedCount() const { return rejectedCount; }
+    uint64_t getProbeCount() const { return probeCount; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 进入熔断状态（调用时需持有 mutex）
+    void tripLocked();
+
+    // 熔断是否已到期（调用时需持有 mutex）
+    bool openExpiredLocked() const;
+
+    // 后台探测线程主循环
+    void probeLoop();
+
+    mutable std::mutex mutex;
+    std::condition_variable stateChanged;
+    State state = State::Closed;
+    int consecutiveFailures = 0;
+    Clock::time_point openedAt;
+
+    int failureThreshold = DEFAULT_FAILURE_THRESHOLD;
+    Clock::duration openDuration = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(DEFAULT_OPEN_SECONDS));
+
+    Probe probe;
+    std::thread prober;
+    bool probing = false;       // 后台探测线程正在运行
+    bool stopping = false;
+
+    std::atomic<uint64_t> tripCount{0};
+    std::atomic<uint64_t> rejectedCount{0};
+    std::atomic<uint64_t> probeCount{0};
+};
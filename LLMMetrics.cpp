@@ -0,0 +1,202 @@
+#include "LLMMetrics.h"
+#include "FileUtils.h"
+#include "Json.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace {
+    // 原子地取最大值
+    template <typename T>
+    void updateMax(std::atomic<T>& target, T value) {
+        T current = target.load();
+        while (value > current && !target.compare_exchange_weak(current, value)) {
+        }
+    }
+}
+
+const std::array<double, LLMMetrics::Histogram::BUCKET_COUNT - 1>& LLMMetrics::Histogram::bucketBounds() {
+    static const std::array<double, BUCKET_COUNT - 1> bounds = {
+        1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000
+    };
+    return bounds;
+}
+
+void LLMMetrics::Histogram::record(double seconds) {
+    double ms = std::max(0.0, seconds) * 1000.0;
+    const auto& bounds = bucketBounds();
+    size_t bucket = static_cast<size_t>(std::lower_bound(bounds.begin(), bounds.end(), ms) - bounds.begin());
+    buckets[bucket]++;
+    count++;
+    uint64_t micros = static_cast<uint64_t>(ms * 1000.0);
+    sumMicros += micros;
+    updateMax(maxMicros, micros);
+}
+
+double LLMMetrics::Histogram::getMeanSeconds() const {
+    uint64_t n = count;
+    return n == 0 ? 0.0 : getSumSeconds() / static_cast<double>(n);
+}
+
+double LLMMetrics::Histogram::percentile(double p) const {
+    std::array<uint64_t, BUCKET_COUNT> snapshot;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        snapshot[i] = buckets[i];
+        total += snapshot[i];
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    // 第 rank 个样本所在的桶，在桶的上下界之间按位置线性插值（最后一个桶以最大值为上界）
+    double rank = std::clamp(p, 0.0, 1.0) * static_cast<double>(total);
+    const auto& bounds = bucketBounds();
+    double maxMs = getMaxSeconds() * 1000.0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        if (snapshot[i] == 0) {
+            continue;
+        }
+        if (static_cast<double>(seen + snapshot[i]) >= rank) {
+            double lower = i == 0 ? 0.0 : bounds[i - 1];
+            double upper = i < bounds.size() ? std::min(bounds[i], std::max(maxMs, lower)) : std::max(maxMs, lower);
+            double fraction = (rank - static_cast<double>(seen)) / static_cast<double>(snapshot[i]);
+            return (lower + (upper - lower) * fraction) / 1000.0;
+        }
+        seen += snapshot[i];
+    }
+    return maxMs / 1000.0;
+}
+
+void LLMMetrics::Histogram::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("count").integer(static_cast<int64_t>(getCount()));
+    writer.key("mean_ms").number(getMeanSeconds() * 1000.0);
+    writer.key("p50_ms").number(percentile(0.50) * 1000.0);
+    writer.key("p90_ms").number(percentile(0.90) * 1000.0);
+    writer.key("p99_ms").number(percentile(0.99) * 1000.0);
+    writer.key("max_ms").number(getMaxSeconds() * 1000.0);
+
+    // 桶：[上界毫秒, 数量]，最后一个桶的上界为 null
+    writer.key("buckets").beginArray();
+    const auto& bounds = bucketBounds();
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        writer.beginArray();
+        if (i < bounds.size()) {
+            writer.number(bounds[i]);
+        } else {
+            writer.null();
+        }
+        writer.integer(static_cast<int64_t>(getBucketCount(i))).endArray();
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+const char* LLMMetrics::kindName(RequestKind kind) {
+    switch (kind) {
+        case RequestKind::Event:  return "event";
+        case RequestKind::Choice: return "choice";
+        case RequestKind::Other:  return "other";
+    }
+    return "unknown";
+}
+
+const char* LLMMetrics::outcomeName(Outcome outcome) {
+    switch (outcome) {
+        case Outcome::EventValid:             return "event_valid";
+        case Outcome::EventInvalid:           return "event_invalid";
+        case Outcome::EventFallbackSaved:     return "event_fallback_saved";
+        case Outcome::EventFallbackSimulated: return "event_fallback_simulated";
+        case Outcome::ChoiceValid:            return "choice_valid";
+        case Outcome::ChoiceCached:           return "choice_cached";
+        case Outcome::ChoiceInvalid:          return "choice_invalid";
+        case Outcome::ChoiceFallback:         return "choice_fallback";
+        case Outcome::Count:                  break;
+    }
+    return "unknown";
+}
+
+void LLMMetrics::requestStarted(RequestKind kind) {
+    KindStats& s = stats(kind);
+    s.requests++;
+    updateMax(s.peakInFlight, ++s.inFlight);
+}
+
+void LLMMetrics::requestFinished(RequestKind kind, double seconds, const HttpResponse& response) {
+    KindStats& s = stats(kind);
+    s.inFlight--;
+    s.attemptLatency.record(seconds);
+    s.responseBytes += response.body.size();
+
+    if (response.aborted) {
+        s.aborted++;
+    } else if (response.statusCode == 0) {
+        s.transportErrors++;
+    } else if (response.ok()) {
+        s.success++;
+    } else if (response.statusCode == 429) {
+        s.rateLimited++;
+    } else if (response.statusCode >= 500) {
+        s.serverErrors++;
+    } else {
+        s.clientErrors++;
+    }
+}
+
+void LLMMetrics::recordTokens(RequestKind kind, int64_t promptTokens, int64_t completionTokens) {
+    KindStats& s = stats(kind);
+    s.promptTokens += static_cast<uint64_t>(std::max<int64_t>(0, promptTokens));
+    s.completionTokens += static_cast<uint64_t>(std::max<int64_t>(0, completionTokens));
+    s.usageReports++;
+}
+
+uint64_t LLMMetrics::getFailureCount(RequestKind kind) const {
+    const KindStats& s = stats(kind);
+    return s.clientErrors + s.rateLimited + s.serverErrors + s.transportErrors;
+}
+
+std::string LLMMetrics::toJson() const {
+    std::string text;
+    JsonWriter writer(text);
+    writer.beginObject();
+    writer.key("requests").beginObject();
+    for (size_t i = 0; i < KIND_COUNT; ++i) {
+        const KindStats& s = kinds[i];
+        writer.key(kindName(static_cast<RequestKind>(i))).beginObject();
+        writer.key("attempts").integer(static_cast<int64_t>(s.requests.load()));
+        writer.key("success").integer(static_cast<int64_t>(s.success.load()));
+        writer.key("client_errors").integer(static_cast<int64_t>(s.clientErrors.load()));
+        writer.key("rate_limited").integer(static_cast<int64_t>(s.rateLimited.load()));
+        writer.key("server_errors").integer(static_cast<int64_t>(s.serverErrors.load()));
+        writer.key("transport_errors").integer(static_cast<int64_t>(s.transportErrors.load()));
+        writer.key("aborted").integer(static_cast<int64_t>(s.aborted.load()));
+        writer.key("rejected").integer(static_cast<int64_t>(s.rejected.load()));
+        writer.key("response_bytes").integer(static_cast<int64_t>(s.responseBytes.load()));
+        writer.key("prompt_tokens").integer(static_cast<int64_t>(s.promptTokens.load()));
+        writer.key("completion_tokens").integer(static_cast<int64_t>(s.completionTokens.load()));
+        writer.key("usage_reports").integer(static_cast<int64_t>(s.usageReports.load()));
+        writer.key("in_flight").integer(s.inFlight.load());
+        writer.key("peak_in_flight").integer(s.peakInFlight.load());
+        writer.key("attempt_latency");
+        s.attemptLatency.writeJson(writer);
+        writer.key("call_latency");
+        s.callLatency.writeJson(writer);
+        writer.endObject();
+    }
+    writer.endObject();
+
+    writer.key("outcomes").beginObject();
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        writer.key(outcomeName(static_cast<Outcome>(i))).integer(static_cast<int64_t>(outcomes[i].load()));
+    }
+    writer.endObject();
+    writer.endObject();
+    return text;
+}
+
+bool LLMMetrics::saveJson(const std::string& path) const {
+    std::string text = toJson();
+    text.push_back('\n');
+    return writeFileAtomically(path, text);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "HttpTransport.h"
+#include "RetryPolicy.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class JsonWriter;
+
+// LLM请求遥测：按请求类型（事件、选择、其他）统计延迟分布、HTTP结果、token用量和在途请求数，
+// 以及事件/选择的结果（有效、验证失败、使用保存的事件或模拟结果）
+// 只使用原子计数，记录不加锁；可在进程内查询，也可输出为JSON
+class LLMMetrics {
+public:
+    using RequestKind = RetryPolicy::RequestKind;
+
+    // 延迟直方图：固定的对数间隔桶（毫秒），分位数在桶内线性插值
+    class Histogram {
+    public:
+        static constexpr size_t BUCKET_COUNT = 17;
+
+        // 各桶的上界（毫秒），最后一个桶没有上界
+        static const std::array<double, BUCKET_COUNT - 1>& bucketBounds();
+
+        void record(double seconds);
+
+        uint64_t getCount() const { return count; }
+        double getSumSeconds() const { return static_cast<double>(sumMicros) / 1e6; }
+        double getMaxSeconds() const { return static_cast<double>(maxMicros) / 1e6; }
+        double getMeanSeconds() const;
+        uint64_t getBucketCount(size_t bucket) const { return buckets[bucket]; }
+
+        // 估计的分位数（秒），p 在 [0, 1] 内；没有样本时返回0
+        double percentile(double p) const;
+
+        void writeJson(JsonWriter& writer) const;
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sumMicros{0};
+        std::atomic<uint64_t> maxMicros{0};
+    };
+
+    // 事件和选择的结果
+    enum class Outcome {
+        EventValid,                 // API生成并通过验证的事件
+        EventInvalid,               // API返回但无法解析或未通过验证的事件
+        EventFallbackSaved,         // 使用事件库中保存的事件
+        EventFallbackSimulated,     // 使用模拟事件
+        ChoiceValid,                // API返回的有效选择
+        ChoiceCached,               // 选择缓存命中，未发送请求
+        ChoiceInvalid,              // API返回无效的选项编号，使用模拟选择
+        ChoiceFallback,             // 请求失败或服务不可用，使用模拟选择
+        Count
+    };
+
+    static const char* kindName(RequestKind kind);
+    static const char* outcomeName(Outcome outcome);
+
+    // 一次HTTP请求（重试和对冲的每次尝试各算一次）开始和结束
+    void requestStarted(RequestKind kind);
+    void requestFinished(RequestKind kind, double seconds, const HttpResponse& response);
+
+    // 熔断期间被立即拒绝的请求
+    void requestRejected(RequestKind kind) { stats(kind).rejected++; }
+
+    // 一次调用（含重试、退避等待和对冲）的总耗时
+    void recordCall(RequestKind kind, double seconds) { stats(kind).callLatency.record(seconds); }
+
+    // 响应中 usage 字段的 token 用量
+    void recordTokens(RequestKind kind, int64_t promptTokens, int64_t completionTokens);
+
+    void countOutcome(Outcome outcome, uint64_t n = 1) { outcomes[static_cast<size_t>(outcome)] += n; }
+
+    // 查询
+    const Histogram& getAttemptLatency(RequestKind kind) const { return stats(kind).attemptLatency; }
+    const Histogram& getCallLatency(RequestKind kind) const { return stats(kind).callLatency; }
+    uint64_t getRequestCount(RequestKind kind) const { return stats(kind).requests; }
+    uint64_t getSuccessCount(RequestKind kind) const { return stats(kind).success; }
+    uint64_t getFailureCount(RequestKind kind) const;
+    uint64_t getPromptTokens(RequestKind kind) const { return stats(kind).promptTokens; }
+    uint64_t getCompletionTokens(RequestKind kind) const { return stats(kind).completionTokens; }
+    int64_t getInFlight(RequestKind kind) const { return stats(kind).inFlight; }
+    int64_t getPeakInFlight(RequestKind kind) const { return stats(kind).peakInFlight; }
+    uint64_t getOutcomeCount(Outcome outcome) const { return outcomes[static_cast<size_t>(outcome)]; }
+
+    // 输出为JSON（含各类请求的直方图、计数和结果）
+    std::string toJson() const;
+
+    // 写入JSON文件（先写临时文件再替换），失败时返回 false
+    bool saveJson(const std::string& path) const;
+
+private:
+    static constexpr size_t KIND_COUNT = 3;
+
+    struct KindStats {
+        Histogram attemptLatency;
+        Histogram callLatency;
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> success{0};           // 2xx
+        std::atomic<uint64_t> clientErrors{0};      // 4xx（429 除外）
+        std::atomic<uint64_t> rateLimited{0};       // 429
+        std::atomic<uint64_t> serverErrors{0};      // 5xx
+        std::atomic<uint64_t> transportErrors{0};   // 连接失败、超时、响应不完整
+        std::atomic<uint64_t> aborted{0};           // 流式请求被主动中止
+        std::atomic<uint64_t> rejected{0};          // 熔断期间被拒绝（未发送）
+        std::atomic<uint64_t> responseBytes{0};
+        std::atomic<uint64_t> promptTokens{0};
+        std::atomic<uint64_t> completionTokens{0};
+        std::atomic<uint64_t> usageReports{0};      // 带 usage 字段的响应数
+        std::atomic<int64_t> inFlight{0};
+        std::atomic<int64_t> peakInFlight{0};
+    };
+
+    KindStats& stats(RequestKind kind) { return kinds[static_cast<size_t>(kind)]; }
+    const KindStats& stats(RequestKind kind) const { return kinds[static_cast<size_t>(kind)]; }
+
+    std::array<KindStats, KIND_COUNT> kinds;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Outcome::Count)> outcomes{};
+};
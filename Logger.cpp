@@ -0,0 +1,280 @@
+#include "Logger.h"
+#include "Json.h"
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    // 当前时间（毫秒，单调时钟），用于限速窗口
+    int64_t steadyMillis() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 追加到 std::string 的输出缓冲区，clear() 后保留容量
+    class StringStreamBuffer : public std::streambuf {
+    public:
+        std::string data;
+
+    protected:
+        int_type overflow(int_type c) override {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                data.push_back(traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+            data.append(s, static_cast<size_t>(n));
+            return n;
+        }
+    };
+}
+
+struct Logger::Formatter::Buffer {
+    StringStreamBuffer buffer;
+    std::ostream stream{&buffer};
+};
+
+Logger::Formatter::Formatter() : buffer([]() -> Buffer& {
+    thread_local Buffer threadBuffer;
+    return threadBuffer;
+}()) {
+    // 清空内容并恢复默认格式（上一条日志可能设置了 std::fixed、setprecision 等）
+    buffer.buffer.data.clear();
+    buffer.stream.clear();
+    buffer.stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    buffer.stream.precision(6);
+    buffer.stream.fill(' ');
+    buffer.stream.width(0);
+}
+
+std::ostream& Logger::Formatter::stream() {
+    return buffer.stream;
+}
+
+std::string_view Logger::Formatter::view() const {
+    return buffer.buffer.data;
+}
+
+bool Logger::RateLimiter::allow(uint64_t& suppressed) {
+    unsigned limit = Logger::instance().getRateLimit();
+    if (limit == 0) {
+        suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 进入新窗口时由一个线程重置计数（并发时计数可能略有偏差，不影响限速效果）
+    int64_t now = steadyMillis();
+    int64_t start = windowStart.load(std::memory_order_relaxed);
+    if (now - start >= 1000 && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        windowCount.store(0, std::memory_order_relaxed);
+    }
+    if (windowCount.fetch_add(1, std::memory_order_relaxed) < limit) {
+        suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    suppressedCount.fetch_add(1, std::memory_order_relaxed);
+    if (!listed.exchange(true, std::memory_order_relaxed)) {
+        Logger& logger = Logger::instance();
+        RateLimiter* head = logger.limiters.load(std::memory_order_relaxed);
+        do {
+            nextListed = head;
+        } while (!logger.limiters.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+    return false;
+}
+
+Logger& Logger::instance() {
+    // 不析构：其他静态对象（如 LLMClient 单例）析构时仍可能写日志，退出时由 atexit 写完队列
+    static Logger* logger = [] {
+        Logger* created = new Logger();
+        std::atexit([] { Logger::instance().shutdown(); });
+        return created;
+    }();
+    return *logger;
+}
+
+Logger::Logger() : slots(std::make_unique<std::array<Slot, QUEUE_CAPACITY>>()) {
+    for (size_t i = 0; i < QUEUE_CAPACITY; ++i) {
+        (*slots)[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    worker = std::thread(&Logger::run, this);
+}
+
+void Logger::configure(const std::string& configPath) {
+    JsonDocument config;
+    if (!config.load(configPath)) {
+        return;
+    }
+
+    const JsonValue& root = config.root();
+    std::string levelText = root["log_level"].asString();
+    if (!levelText.empty()) {
+        LogLevel level;
+        if (parseLevel(levelText, level)) {
+            setLevel(level);
+        } else {
+            LOG_WARN("未知的日志级别 log_level: " << levelText << "，使用 " << levelName(getLevel()));
+        }
+    }
+    if (root["log_rate_limit"].isNumber()) {
+        setRateLimit(static_cast<unsigned>(root["log_rate_limit"].asUnsigned(DEFAULT_RATE_LIMIT)));
+    }
+}
+
+bool Logger::parseLevel(std::string_view name, LogLevel& level) {
+    std::string lower;
+    for (char c : name) {
+        lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    if (lower == "debug") {
+        level = LogLevel::Debug;
+    } else if (lower == "info") {
+        level = LogLevel::Info;
+    } else if (lower == "warn" || lower == "warning") {
+        level = LogLevel::Warn;
+    } else if (lower == "error") {
+        level = LogLevel::Error;
+    } else if (lower == "off" || lower == "none") {
+        level = LogLevel::Off;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info:  return "info";
+        case LogLevel::Warn:  return "warn";
+        case LogLevel::Error: return "error";
+        case LogLevel::Off:   return "off";
+    }
+    return "unknown";
+}
+
+void Logger::write(LogLevel level, std::string_view message, uint64_t suppressed) {
+    if (stopped.load(std::memory_order_acquire)) {
+        output(level, message, suppressed);
+        return;
+    }
+
+    // 占用一个空槽位；队列已满（槽位仍未被后台线程读走）时丢弃
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &(*slots)[pos & (QUEUE_CAPACITY - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->suppressed = suppressed;
+    slot->text.assign(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    wakeSequence.fetch_add(1, std::memory_order_release);
+    wakeSequence.notify_one();
+}
+
+void Logger::reportSuppressed() {
+    uint64_t total = 0;
+    for (RateLimiter* limiter = limiters.load(std::memory_order_acquire); limiter != nullptr; limiter = limiter->nextListed) {
+        total += limiter->suppressedCount.exchange(0, std::memory_order_relaxed);
+    }
+    if (total > 0) {
+        write(LogLevel::Info, "（限速：省略了 " + std::to_string(total) + " 条日志）");
+    }
+}
+
+void Logger::flush() {
+    if (stopped.load(std::memory_order_acquire) || std::this_thread::get_id() == worker.get_id()) {
+        return;
+    }
+    reportSuppressed();
+    size_t target = enqueuePos.load(std::memory_order_acquire);
+    size_t written = writtenCount.load(std::memory_order_acquire);
+    while (written < target && !stopped.load(std::memory_order_acquire)) {
+        writtenCount.wait(written, std::memory_order_acquire);
+        written = writtenCount.load(std::memory_order_acquire);
+    }
+}
+
+void Logger::shutdown() {
+    if (stopping.load()) {
+        return;
+    }
+    reportSuppressed();
+    if (stopping.exchange(true)) {
+        return;
+    }
+    wakeSequence.fetch_add(1, std::memory_order_release);
+    wakeSequence.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    stopped.store(true, std::memory_order_release);
+    writtenCount.notify_all();
+}
+
+void Logger::output(LogLevel level, std::string_view message, uint64_t suppressed) {
+    std::ostream& stream = level >= LogLevel::Warn ? std::cerr : std::cout;
+    if (suppressed > 0) {
+        stream << "（限速：此处省略了 " << suppressed << " 条日志）\n";
+    }
+    stream.write(message.data(), static_cast<std::streamsize>(message.size()));
+    stream.put('\n');
+}
+
+void Logger::run() {
+    size_t pos = 0;
+    uint64_t reportedDrops = 0;
+    for (;;) {
+        uint32_t wake = wakeSequence.load(std::memory_order_acquire);
+        bool finishing = stopping.load(std::memory_order_acquire);
+
+        // 按入队顺序写出所有已提交的日志；遇到尚未写完内容的槽位时停下，等它提交后再继续
+        size_t start = pos;
+        for (;;) {
+            Slot& slot = (*slots)[pos & (QUEUE_CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            output(slot.level, slot.text, slot.suppressed);
+            slot.sequence.store(pos + QUEUE_CAPACITY, std::memory_order_release);
+            ++pos;
+        }
+
+        uint64_t drops = droppedCount.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            std::cerr << "Logger: 日志队列已满，丢弃了 " << drops - reportedDrops << " 条日志\n";
+            reportedDrops = drops;
+        }
+
+        // 队列写空后才刷新输出流，再通知等待 flush() 的线程
+        if (pos != start) {
+            std::cout.flush();
+            std::cerr.flush();
+            writtenCount.store(pos, std::memory_order_release);
+            writtenCount.notify_all();
+        }
+
+        if (finishing) {
+            return;
+        }
+        wakeSequence.wait(wake, std::memory_order_acquire);
+    }
+}
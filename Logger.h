@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// 日志级别（数值越大越重要）
+enum class LogLevel {
+    Debug = 0,      // 每次请求、每个事件的细节（URL、请求体、响应预览等）
+    Info = 1,       // 正常运行的状态信息
+    Warn = 2,       // 可恢复的问题（重试、回退到保存的事件或模拟结果）
+    Error = 3,      // 失败（无法打开文件、异常）
+    Off = 4
+};
+
+// 编译期最低日志级别：低于该级别的 LOG_* 调用不会生成任何代码（CMake 选项 AMPH0REUS_LOG_LEVEL）
+#ifndef AMPH0REUS_LOG_LEVEL
+#define AMPH0REUS_LOG_LEVEL 0
+#endif
+
+// 异步日志：调用线程只做级别判断、格式化和一次无锁入队，由后台线程写入控制台
+// Debug/Info 写入 std::cout，Warn/Error 写入 std::cerr；队列写空时才刷新输出流
+// 队列已满时丢弃新日志并计数；同一调用点每秒最多输出 rateLimit 条，多出的只计数，在该调用点的下一条日志前报告
+// 进程退出时自动写完队列中的日志；之后的日志直接同步输出
+class Logger {
+public:
+    // 队列槽位数量（2的幂）
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    // 默认每个调用点每秒最多输出的日志条数
+    static constexpr unsigned DEFAULT_RATE_LIMIT = 20;
+
+    static Logger& instance();
+
+    // 从配置文件读取 log_level（debug/info/warn/error/off）和 log_rate_limit（0 表示不限速）
+    void configure(const std::string& configPath);
+
+    void setLevel(LogLevel level) { runtimeLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel getLevel() const { return static_cast<LogLevel>(runtimeLevel.load(std::memory_order_relaxed)); }
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= runtimeLevel.load(std::memory_order_relaxed);
+    }
+
+    void setRateLimit(unsigned perSecond) { rateLimit.store(perSecond, std::memory_order_relaxed); }
+    unsigned getRateLimit() const { return rateLimit.load(std::memory_order_relaxed); }
+
+    // 入队一条日志（不等待输出）；suppressed 为该调用点此前被限速丢弃的条数
+    void write(LogLevel level, std::string_view message, uint64_t suppressed = 0);
+
+    // 等待此前入队的日志全部写出（在直接写控制台的界面输出之前调用，保持先后顺序）
+    // 各调用点尚未报告的限速省略条数在这里汇总输出一行
+    void flush();
+
+    // 写完队列并停止后台线程（进程退出时自动调用）
+    void shutdown();
+
+    // 队列已满而丢弃的日志条数
+    uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+    // 解析级别名称（不区分大小写），无法识别时返回 false
+    static bool parseLevel(std::string_view name, LogLevel& level);
+    static const char* levelName(LogLevel level);
+
+    // 调用点限速：固定一秒的窗口内最多放行 rateLimit 条
+    // 第一次丢弃日志时加入 Logger 的无锁链表，flush() 时汇总还没报告的条数
+    class RateLimiter {
+    public:
+        // 是否输出这一条；放行时 suppressed 为此前被丢弃的条数
+        bool allow(uint64_t& suppressed);
+
+    private:
+        friend class Logger;
+
+        std::atomic<int64_t> windowStart{0};
+        std::atomic<uint32_t> windowCount{0};
+        std::atomic<uint64_t> suppressedCount{0};
+        std::atomic<bool> listed{false};
+        RateLimiter* nextListed = nullptr;
+    };
+
+    // 调用线程复用的格式化缓冲区（避免每条日志构造新的 ostringstream）
+    class Formatter {
+    public:
+        Formatter();
+        std::ostream& stream();
+        std::string_view view() const;
+
+    private:
+        struct Buffer;
+        Buffer& buffer;
+    };
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    Logger();
+
+    // 有界多生产者队列（Vyukov）的槽位：sequence 表示槽位可写（== 位置）或可读（== 位置 + 1）
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        LogLevel level = LogLevel::Info;
+        uint64_t suppressed = 0;
+        std::string text;       // 复用容量，稳定后入队不再分配内存
+    };
+
+    void run();
+    void output(LogLevel level, std::string_view message, uint64_t suppressed);
+    void reportSuppressed();
+
+    std::unique_ptr<std::array<Slot, QUEUE_CAPACITY>> slots;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> writtenCount{0};    // 已写出的条数（后台线程更新，flush 等待它）
+    std::atomic<uint32_t> wakeSequence{0};               // 后台线程等待的唤醒计数
+    std::atomic<uint64_t> droppedCount{0};
+    std::atomic<RateLimiter*> limiters{nullptr};         // 丢弃过日志的调用点
+    std::atomic<int> runtimeLevel{static_cast<int>(LogLevel::Info)};
+    std::atomic<unsigned> rateLimit{DEFAULT_RATE_LIMIT};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> stopped{false};
+    std::thread worker;
+};
+
+// 临时调整运行期日志级别，作用域结束时恢复
+class ScopedLogLevel {
+public:
+    explicit ScopedLogLevel(LogLevel level) : previous(Logger::instance().getLevel()) { Logger::instance().setLevel(level); }
+    ~ScopedLogLevel() { Logger::instance().setLevel(previous); }
+
+    ScopedLogLevel(const ScopedLogLevel&) = delete;
+    ScopedLogLevel& operator=(const ScopedLogLevel&) = delete;
+
+private:
+    LogLevel previous;
+};
+
+// 日志宏：LOG_INFO("已加载 " << count << " 个事件")
+// 级别未开启时不会对参数求值；每个调用点有独立的限速器
+#define AMPH0REUS_LOG(level, message)                                                   \
+    do {                                                                                \
+        if constexpr (static_cast<int>(level) >= AMPH0REUS_LOG_LEVEL) {                 \
+            if (Logger::instance().isEnabled(level)) {                                  \
+                static Logger::RateLimiter amphLogLimiter;                              \
+                uint64_t amphLogSuppressed = 0;                                         \
+                if (amphLogLimiter.allow(amphLogSuppressed)) {                          \
+                    Logger::Formatter amphLogFormatter;                                 \
+                    amphLogFormatter.stream() << message;                               \
+                    Logger::instance().write(level, amphLogFormatter.view(), amphLogSuppressed); \
+                }                                                                       \
+            }                                                                           \
+        }                                                                               \
+    } while (false)
+
+#define LOG_DEBUG(message) AMPH0REUS_LOG(LogLevel::Debug, message)
+#define LOG_INFO(message)  AMPH0REUS_LOG(LogLevel::Info, message)
+#define LOG_WARN(message)  AMPH0REUS_LOG(LogLevel::Warn, message)
+#define LOG_ERROR(message) AMPH0REUS_LOG(LogLevel::Error, message)
@@ -0,0 +1,773 @@
+// 本地模拟 OpenAI 兼容 LLM 服务器：在 /v1/chat/completions 上返回固定或程序生成的有效事件、选项编号
+// 可配置延迟分布、错误率、限流、截断的响应体、结构无效的事件和流式（SSE）输出，
+// 用于在没有 GPU 和网络的情况下对 LLM 请求路径做可重复的吞吐量和尾延迟测试
+// 用法: mock_llm_server [选项]（--help 查看全部选项），然后把 config.json 的 openai_base_url 设为 http://127.0.0.1:端口
+#include "CounterRng.h"
+#include "Json.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    const SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+    void closeSocket(SocketHandle fd) { closesocket(fd); }
+#else
+    using SocketHandle = int;
+    const SocketHandle INVALID_SOCKET_HANDLE = -1;
+    void closeSocket(SocketHandle fd) { close(fd); }
+#endif
+
+    // 延迟分布：fixed:毫秒 | uniform:最小:最大 | exp:均值 | lognormal:中位数:sigma
+    struct LatencyDistribution {
+        enum class Kind { Fixed, Uniform, Exponential, LogNormal };
+        Kind kind = Kind::Fixed;
+        double a = 0.0;
+        double b = 0.0;
+
+        bool parse(const std::string& text) {
+            std::vector<double> values;
+            std::string name = text.substr(0, text.find(':'));
+            size_t pos = text.find(':');
+            while (pos != std::string::npos) {
+                size_t next = text.find(':', pos + 1);
+                try {
+                    values.push_back(std::stod(text.substr(pos + 1, next == std::string::npos ? std::string::npos : next - pos - 1)));
+                } catch (...) {
+                    return false;
+                }
+                pos = next;
+            }
+            if (name == "fixed" && values.size() == 1) {
+                kind = Kind::Fixed;
+            } else if (name == "uniform" && values.size() == 2) {
+                kind = Kind::Uniform;
+            } else if (name == "exp" && values.size() == 1) {
+                kind = Kind::Exponential;
+            } else if (name == "lognormal" && values.size() == 2) {
+                kind = Kind::LogNormal;
+            } else {
+                return false;
+            }
+            a = std::max(0.0, values[0]);
+            b = values.size() > 1 ? std::max(0.0, values[1]) : 0.0;
+            return true;
+        }
+
+        // 按分布取一个延迟（毫秒）
+        double sample(CounterRng& rng) const {
+            switch (kind) {
+                case Kind::Fixed:
+                    return a;
+                case Kind::Uniform:
+                    return a + (std::max(a, b) - a) * CounterRng::toUnitDouble(rng());
+                case Kind::Exponential:
+                    return -a * std::log(1.0 - CounterRng::toUnitDouble(rng()));
+                case Kind::LogNormal: {
+                    // Box-Muller 取标准正态分布
+                    double u1 = 1.0 - CounterRng::toUnitDouble(rng());
+                    double u2 = CounterRng::toUnitDouble(rng());
+                    double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+                    return a * std::exp(b * z);
+                }
+            }
+            return 0.0;
+        }
+    };
+
+    struct ServerOptions {
+        int port = 8080;
+        LatencyDistribution eventLatency;       // 事件生成请求的延迟
+        LatencyDistribution choiceLatency;      // 选项选择请求的延迟
+        bool choiceLatencySet = false;
+        double errorRate = 0.0;                 // 返回 HTTP 500 的概率
+        double rateLimitRate = 0.0;             // 返回 HTTP 429 的概率
+        double truncateRate = 0.0;              // 只发送一半响应体就关闭连接的概率
+        double invalidRate = 0.0;               // 返回结构无效事件（9个选项）的概率
+        size_t streamChunkSize = 16;            // 流式输出每个片段的字节数（按 UTF-8 字符边界切分）
+        double streamDelayMs = 0.0;             // 流式片段之间的间隔
+        std::string eventsDirectory;            // 固定事件的目录（为空时程序生成）
+        uint64_t seed = 1;
+        int reportSeconds = 0;                  // 每隔多少秒输出一次统计，0 表示只在退出时输出
+        bool verbose = false;
+        bool help = false;
+    };
+
+    // 请求类型
+    enum class RequestKind { Event, Choice, Other };
+
+    // 统计
+    struct ServerStats {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> eventRequests{0};
+        std::atomic<uint64_t> choiceRequests{0};
+        std::atomic<uint64_t> streamed{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> rateLimited{0};
+        std::atomic<uint64_t> truncated{0};
+        std::atomic<uint64_t> invalidEvents{0};
+        std::atomic<uint64_t> badRequests{0};
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> activeConnections{0};
+    };
+
+    // 模拟服务器使用的随机数流
+    constexpr uint64_t STREAM_MOCK_SERVER = 0xE0000000000000F0ULL;
+
+    std::atomic<bool> stopRequested{false};
+
+    void onSignal(int) {
+        stopRequested = true;
+    }
+
+    void printUsage(const char* program) {
+        std::cout << "用法: " << program << " [选项]" << std::endl;
+        std::cout << "  --port N               监听端口（默认 8080，只监听 127.0.0.1）" << std::endl;
+        std::cout << "  --latency 分布         事件生成请求的延迟（默认 fixed:0）" << std::endl;
+        std::cout << "                         fixed:毫秒 | uniform:最小:最大 | exp:均值 | lognormal:中位数:sigma" << std::endl;
+        std::cout << "  --choice-latency 分布  选项选择请求的延迟（默认与 --latency 相同）" << std::endl;
+        std::cout << "  --error-rate P         以概率 P 返回 HTTP 500" << std::endl;
+        std::cout << "  --rate-limit-rate P    以概率 P 返回 HTTP 429" << std::endl;
+        std::cout << "  --truncate-rate P      以概率 P 只发送一半响应体后关闭连接" << std::endl;
+        std::cout << "  --invalid-rate P       以概率 P 返回结构无效的事件（9个选项）" << std::endl;
+        std::cout << "  --stream-chunk N       流式输出每个片段的字节数（默认 16）" << std::endl;
+        std::cout << "  --stream-delay-ms MS   流式片段之间的间隔（默认 0）" << std::endl;
+        std::cout << "  --events 目录          使用目录下的 *.json 事件文件作为固定响应（默认程序生成事件）" << std::endl;
+        std::cout << "  --seed N               随机种子（默认 1，相同种子和请求顺序得到相同的响应）" << std::endl;
+        std::cout << "  --report N             每 N 秒输出一次统计（默认只在退出时输出）" << std::endl;
+        std::cout << "  --verbose              输出每个请求" << std::endl;
+        std::cout << "  --help                 显示本帮助" << std::endl;
+    }
+
+    bool parseProbability(const char* text, double& value) {
+        try {
+            value = std::stod(text);
+        } catch (...) {
+            return false;
+        }
+        return value >= 0.0 && value <= 1.0;
+    }
+
+    // 解析命令行参数，参数无效时返回 false
+    bool parseCommandLine(int argc, char* argv[], ServerOptions& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                options.help = true;
+                continue;
+            }
+            if (arg == "--verbose") {
+                options.verbose = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少参数" << std::endl;
+                return false;
+            }
+            const char* value = argv[++i];
+            bool ok = true;
+            try {
+                if (arg == "--port") {
+                    options.port = std::stoi(value);
+                    ok = options.port > 0 && options.port < 65536;
+                } else if (arg == "--latency") {
+                    ok = options.eventLatency.parse(value);
+                } else if (arg == "--choice-latency") {
+                    ok = options.choiceLatency.parse(value);
+                    options.choiceLatencySet = true;
+                } else if (arg == "--error-rate") {
+                    ok = parseProbability(value, options.errorRate);
+                } else if (arg == "--rate-limit-rate") {
+                    ok = parseProbability(value, options.rateLimitRate);
+                } else if (arg == "--truncate-rate") {
+                    ok = parseProbability(value, options.truncateRate);
+                } else if (arg == "--invalid-rate") {
+                    ok = parseProbability(value, options.invalidRate);
+                } else if (arg == "--stream-chunk") {
+                    options.streamChunkSize = static_cast<size_t>(std::max(1, std::stoi(value)));
+                } else if (arg == "--stream-delay-ms") {
+                    options.streamDelayMs = std::max(0.0, std::stod(value));
+                } else if (arg == "--events") {
+                    options.eventsDirectory = value;
+                } else if (arg == "--seed") {
+                    options.seed = std::stoull(value);
+                } else if (arg == "--report") {
+                    options.reportSeconds = std::max(0, std::stoi(value));
+                } else {
+                    std::cerr << "未知选项: " << arg << std::endl;
+                    return false;
+                }
+            } catch (...) {
+                ok = false;
+            }
+            if (!ok) {
+                std::cerr << "选项 " << arg << " 的参数无效: " << value << std::endl;
+                return false;
+            }
+        }
+        if (!options.choiceLatencySet) {
+            options.choiceLatency = options.eventLatency;
+        }
+        return true;
+    }
+
+    // 加载固定事件：每个文件必须是一个JSON对象，保存为紧凑的事件文本
+    std::vector<std::string> loadCannedEvents(const std::string& directory) {
+        std::vector<std::filesystem::path> files;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".json") {
+                files.push_back(it->path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        std::vector<std::string> events;
+        for (const auto& path : files) {
+            std::ifstream file(path, std::ios::binary);
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            std::string text = buffer.str();
+            JsonDocument document;
+            if (!document.parse(text) || !document.root().isObject()) {
+                std::cerr << "跳过无效的事件文件 " << path.string() << ": " << document.error() << std::endl;
+                continue;
+            }
+            events.push_back(std::move(text));
+        }
+        return events;
+    }
+
+    // 保留两位小数
+    double round2(double value) {
+        return std::round(value * 100.0) / 100.0;
+    }
+
+    // 程序生成一个事件（optionCount 为10时是有效事件）
+    void writeGeneratedEvent(JsonWriter& writer, uint64_t id, CounterRng& rng, int optionCount) {
+        writer.beginObject();
+        writer.key("name").beginString().stringPart("模拟事件#").stringPart(static_cast<int64_t>(id)).endString();
+        writer.key("description").beginString().stringPart("由本地模拟服务器生成的第 ").stringPart(static_cast<int64_t>(id))
+              .stringPart(" 个事件，用于测试LLM请求路径。").endString();
+        writer.key("options").beginArray();
+        for (int i = 0; i < optionCount; ++i) {
+            writer.beginObject();
+            writer.key("text").beginString().stringPart("选项").stringPart(static_cast<int64_t>(i + 1)).endString();
+            writer.key("decisionRequirement").beginArray();
+            for (int d = 0; d < 12; ++d) {
+                writer.number(round2(CounterRng::toUnitDouble(rng())));
+            }
+            writer.endArray();
+            writer.key("decisionFeedback").beginArray();
+            for (int d = 0; d < 12; ++d) {
+                writer.number(round2(0.4 * CounterRng::toUnitDouble(rng()) - 0.2));
+            }
+            writer.endArray();
+            writer.key("outcomeText").beginString().stringPart("选择选项").stringPart(static_cast<int64_t>(i + 1))
+                  .stringPart("后的结果").endString();
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+
+    // 从提示中 marker 之后读取一个正整数，找不到时返回 fallback
+    int readNumberAfter(const std::string& text, const char* marker, int fallback) {
+        size_t pos = text.find(marker);
+        if (pos == std::string::npos) {
+            return fallback;
+        }
+        pos += std::char_traits<char>::length(marker);
+        int value = 0;
+        bool found = false;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && value < 100000) {
+            value = value * 10 + (text[pos++] - '0');
+            found = true;
+        }
+        return found && value > 0 ? value : fallback;
+    }
+
+    class MockServer {
+    public:
+        explicit MockServer(const ServerOptions& options) : options(options) {
+            if (!options.eventsDirectory.empty()) {
+                cannedEvents = loadCannedEvents(options.eventsDirectory);
+            }
+        }
+
+        bool run();
+
+    private:
+        struct HttpRequest {
+            std::string method;
+            std::string path;
+            std::string body;
+            bool keepAlive = true;
+        };
+
+        void serveConnection(SocketHandle fd);
+        bool readRequest(SocketHandle fd, std::string& buffer, HttpRequest& request);
+        bool handleRequest(SocketHandle fd, const HttpRequest& request);
+        std::string buildContent(RequestKind kind, int count, int optionCount, CounterRng& rng, bool& invalid);
+        void printStats(const char* label);
+
+        static bool sendAll(SocketHandle fd, const char* data, size_t size);
+        static bool sendAll(SocketHandle fd, const std::string& data) { return sendAll(fd, data.data(), data.size()); }
+        static void sleepMs(double ms) {
+            if (ms > 0.0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(ms * 1000.0)));
+            }
+        }
+
+        ServerOptions options;
+        std::vector<std::string> cannedEvents;
+        std::atomic<uint64_t> requestCounter{0};
+        ServerStats stats;
+        std::mutex logMutex;
+    };
+
+    bool MockServer::sendAll(SocketHandle fd, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < size) {
+            int chunk = static_cast<int>(std::min<size_t>(size - sent, 1 << 20));
+            auto n = send(fd, data + sent, chunk, flags);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool MockServer::readRequest(SocketHandle fd, std::string& buffer, HttpRequest& request) {
+        char chunk[16384];
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (buffer.size() > (1 << 20)) {
+                return false;
+            }
+            auto n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+
+        // 请求行和头部（头部名称不区分大小写）
+        std::istringstream head(buffer.substr(0, headerEnd));
+        std::string line, version;
+        std::getline(head, line);
+        std::istringstream requestLine(line);
+        requestLine >> request.method >> request.path >> version;
+        request.keepAlive = version != "HTTP/1.0";
+        size_t contentLength = 0;
+        while (std::getline(head, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            size_t valueStart = std::min(line.size(), line.find_first_not_of(' ', colon + 1));
+            std::string value = line.substr(valueStart);
+            std::string lowerValue = value;
+            std::transform(lowerValue.begin(), lowerValue.end(), lowerValue.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (name == "content-length") {
+                contentLength = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+            } else if (name == "connection") {
+                if (lowerValue.find("close") != std::string::npos) {
+                    request.keepAlive = false;
+                } else if (lowerValue.find("keep-alive") != std::string::npos) {
+                    request.keepAlive = true;
+                }
+            }
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        while (buffer.size() - bodyStart < contentLength) {
+            auto n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        request.body = buffer.substr(bodyStart, contentLength);
+        buffer.erase(0, bodyStart + contentLength);
+        return true;
+    }
+
+    std::string MockServer::buildContent(RequestKind kind, int count, int optionCount, CounterRng& rng, bool& invalid) {
+        std::string content;
+        if (kind == RequestKind::Choice) {
+            content = std::to_string(1 + static_cast<int>(rng() % static_cast<uint64_t>(optionCount)));
+            return content;
+        }
+        if (kind == RequestKind::Other) {
+            return "OK";
+        }
+
+        // 事件：单个事件为对象，批量为数组；无效事件只有9个选项
+        invalid = options.invalidRate > 0.0 && CounterRng::toUnitDouble(rng()) < options.invalidRate;
+        if (count > 1) {
+            content += '[';
+        }
+        for (int i = 0; i < count; ++i) {
+            if (i > 0) {
+                content += ',';
+            }
+            uint64_t id = rng();
+            if (!cannedEvents.empty() && !(invalid && i == 0)) {
+                content += cannedEvents[id % cannedEvents.size()];
+            } else {
+                JsonWriter eventWriter(content);
+                writeGeneratedEvent(eventWriter, id % 1000000, rng, invalid && i == 0 ? 9 : 10);
+            }
+        }
+        if (count > 1) {
+            content += ']';
+        }
+        return content;
+    }
+
+    bool MockServer::handleRequest(SocketHandle fd, const HttpRequest& request) {
+        auto sendStatus = [&](int status, const char* reason, const std::string& message) {
+            std::string body;
+            JsonWriter writer(body);
+            writer.beginObject().key("error").beginObject().key("message").string(message)
+                  .key("type").string("mock_error").key("code").integer(status).endObject().endObject();
+            std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n"
+                                   "Content-Type: application/json\r\n"
+                                   "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                   "Connection: " + (request.keepAlive ? "keep-alive" : "close") + "\r\n\r\n" + body;
+            return sendAll(fd, response) && request.keepAlive;
+        };
+
+        if (request.method != "POST" || request.path.size() < 17 ||
+            request.path.compare(request.path.size() - 17, 17, "/chat/completions") != 0) {
+            stats.badRequests++;
+            return sendStatus(404, "Not Found", "unknown endpoint " + request.path);
+        }
+
+        JsonDocument document;
+        if (!document.parse(request.body)) {
+            stats.badRequests++;
+            return sendStatus(400, "Bad Request", "invalid JSON: " + document.error());
+        }
+        JsonValue root = document.root();
+        std::string model = root["model"].asString("mock");
+        bool stream = root["stream"].asBool(false);
+        // 与 OpenAI 相同：流式请求带 stream_options.include_usage 时才在最后一个片段中返回 usage
+        bool includeUsage = stream && root["stream_options"]["include_usage"].asBool(false);
+
+        // 按提示区分请求：system 消息为事件生成，"请只返回选择的选项编号" 为选项选择，其他（连接测试、探测）返回 OK
+        JsonValue messages = root["messages"];
+        std::string prompt;
+        bool hasSystem = false;
+        for (JsonValue message = messages.first(); message; message = message.next()) {
+            if (message["role"].asString() == "system") {
+                hasSystem = true;
+            } else if (message["role"].asString() == "user") {
+                prompt = message["content"].asString();
+            }
+        }
+        RequestKind kind = RequestKind::Other;
+        int count = 1;
+        int optionCount = 10;
+        if (prompt.find("请只返回选择的选项编号") != std::string::npos) {
+            kind = RequestKind::Choice;
+            optionCount = readNumberAfter(prompt, "（1-", 10);
+            stats.choiceRequests++;
+        } else if (hasSystem) {
+            kind = RequestKind::Event;
+            count = std::min(readNumberAfter(prompt, "请一次生成", 1), 64);
+            stats.eventRequests++;
+        }
+
+        // 每个请求使用独立的随机数流：相同种子下第 n 个请求的行为相同
+        uint64_t sequence = requestCounter++;
+        CounterRng rng(options.seed, CounterRng::deriveStream(STREAM_MOCK_SERVER, sequence), 0);
+        const LatencyDistribution& latency = kind == RequestKind::Choice ? options.choiceLatency : options.eventLatency;
+        double delayMs = latency.sample(rng);
+        double fault = CounterRng::toUnitDouble(rng());
+        bool truncate = options.truncateRate > 0.0 && CounterRng::toUnitDouble(rng()) < options.truncateRate;
+
+        if (options.verbose) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cout << "#" << sequence << " " << (kind == RequestKind::Event ? "event" : kind == RequestKind::Choice ? "choice" : "other")
+                      << (stream ? " stream" : "") << " count=" << count << " delay=" << delayMs << "ms" << std::endl;
+        }
+
+        sleepMs(delayMs);
+        if (fault < options.errorRate) {
+            stats.errors++;
+            return sendStatus(500, "Internal Server Error", "mock server error");
+        }
+        if (fault < options.errorRate + options.rateLimitRate) {
+            stats.rateLimited++;
+            return sendStatus(429, "Too Many Requests", "mock rate limit");
+        }
+
+        bool invalid = false;
+        std::string content = buildContent(kind, count, optionCount, rng, invalid);
+        if (invalid) {
+            stats.invalidEvents++;
+        }
+        std::string id = "mock-" + std::to_string(sequence);
+        int64_t promptTokens = static_cast<int64_t>(request.body.size() / 4);
+        int64_t completionTokens = static_cast<int64_t>((content.size() + 3) / 4);
+
+        if (!stream) {
+            std::string body;
+            JsonWriter writer(body);
+            writer.beginObject().key("id").string(id).key("object").string("chat.completion")
+                  .key("created").integer(0).key("model").string(model);
+            writer.key("choices").beginArray().beginObject().key("index").integer(0);
+            writer.key("message").beginObject().key("role").string("assistant").key("content").string(content).endObject();
+            writer.key("finish_reason").string("stop").endObject().endArray();
+            writer.key("usage").beginObject().key("prompt_tokens").integer(promptTokens)
+                  .key("completion_tokens").integer(completionTokens)
+                  .key("total_tokens").integer(promptTokens + completionTokens).endObject();
+            writer.endObject();
+
+            std::string head = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: " + (request.keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+            if (truncate) {
+                stats.truncated++;
+                sendAll(fd, head);
+                sendAll(fd, body.data(), body.size() / 2);
+                return false;
+            }
+            return sendAll(fd, head + body) && request.keepAlive;
+        }
+
+        // 流式响应：chunked 编码的 SSE，每个片段为 {"choices":[{"delta":{"content":"..."}}]}
+        stats.streamed++;
+        std::string head = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                           "Transfer-Encoding: chunked\r\n"
+                           "Connection: " + std::string(request.keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+        if (!sendAll(fd, head)) {
+            return false;
+        }
+        auto sendEvent = [&](const std::string& payload) {
+            std::string data = "data: " + payload + "\n\n";
+            char size[32];
+            std::snprintf(size, sizeof(size), "%zx\r\n", data.size());
+            return sendAll(fd, std::string(size) + data + "\r\n");
+        };
+        auto chunkPayload = [&](const std::string* delta, bool first) {
+            std::string payload;
+            JsonWriter writer(payload);
+            writer.beginObject().key("id").string(id).key("object").string("chat.completion.chunk")
+                  .key("created").integer(0).key("model").string(model);
+            writer.key("choices").beginArray().beginObject().key("index").integer(0).key("delta").beginObject();
+            if (first) {
+                writer.key("role").string("assistant");
+            }
+            if (delta) {
+                writer.key("content").string(*delta);
+            }
+            writer.endObject().key("finish_reason");
+            if (!delta && !first) {
+                writer.string("stop");
+            } else {
+                writer.null();
+            }
+            writer.endObject().endArray().endObject();
+            return payload;
+        };
+
+        if (!sendEvent(chunkPayload(nullptr, true))) {
+            return false;
+        }
+        size_t truncateAt = truncate ? content.size() / 2 : content.size();
+        size_t pos = 0;
+        while (pos < truncateAt) {
+            // 按 UTF-8 字符边界切分
+            size_t end = std::min(content.size(), pos + options.streamChunkSize);
+            while (end < content.size() && (static_cast<unsigned char>(content[end]) & 0xC0) == 0x80) {
+                ++end;
+            }
+            std::string delta = content.substr(pos, end - pos);
+            if (!sendEvent(chunkPayload(&delta, false))) {
+                return false;
+            }
+            pos = end;
+            sleepMs(options.streamDelayMs);
+        }
+        if (truncate) {
+            stats.truncated++;
+            return false;
+        }
+        if (!sendEvent(chunkPayload(nullptr, false))) {
+            return false;
+        }
+        if (includeUsage) {
+            // usage 片段的 choices 为空数组
+            std::string payload;
+            JsonWriter writer(payload);
+            writer.beginObject().key("id").string(id).key("object").string("chat.completion.chunk")
+                  .key("created").integer(0).key("model").string(model);
+            writer.key("choices").beginArray().endArray();
+            writer.key("usage").beginObject().key("prompt_tokens").integer(promptTokens)
+                  .key("completion_tokens").integer(completionTokens)
+                  .key("total_tokens").integer(promptTokens + completionTokens).endObject();
+            writer.endObject();
+            if (!sendEvent(payload)) {
+                return false;
+            }
+        }
+        return sendEvent("[DONE]") && sendAll(fd, "0\r\n\r\n") && request.keepAlive;
+    }
+
+    void MockServer::serveConnection(SocketHandle fd) {
+        stats.connections++;
+        stats.activeConnections++;
+#ifdef TCP_NODELAY
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+#endif
+        std::string buffer;
+        HttpRequest request;
+        while (!stopRequested && readRequest(fd, buffer, request)) {
+            stats.requests++;
+            if (!handleRequest(fd, request)) {
+                break;
+            }
+            request = HttpRequest();
+        }
+        closeSocket(fd);
+        stats.activeConnections--;
+    }
+
+    void MockServer::printStats(const char* label) {
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cout << label << " 请求 " << stats.requests << "（事件 " << stats.eventRequests << "，选择 " << stats.choiceRequests
+                  << "，流式 " << stats.streamed << "），500 " << stats.errors << "，429 " << stats.rateLimited
+                  << "，截断 " << stats.truncated << "，无效事件 " << stats.invalidEvents << "，错误请求 " << stats.badRequests
+                  << "，连接 " << stats.connections << "（活动 " << stats.activeConnections << "）" << std::endl;
+    }
+
+    bool MockServer::run() {
+        SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener == INVALID_SOCKET_HANDLE) {
+            std::cerr << "无法创建套接字" << std::endl;
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 128) != 0) {
+            std::cerr << "无法监听端口 " << options.port << std::endl;
+            closeSocket(listener);
+            return false;
+        }
+
+        std::cout << "模拟LLM服务器已启动: http://127.0.0.1:" << options.port << "/v1/chat/completions" << std::endl;
+        std::cout << "事件来源: " << (cannedEvents.empty() ? std::string("程序生成")
+                                      : std::to_string(cannedEvents.size()) + " 个固定事件（" + options.eventsDirectory + "）")
+                  << "，错误率 " << options.errorRate << "，限流率 " << options.rateLimitRate
+                  << "，截断率 " << options.truncateRate << "，无效事件率 " << options.invalidRate
+                  << "，种子 " << options.seed << std::endl;
+        std::cout << "按 Ctrl+C 停止" << std::endl;
+
+        auto lastReport = std::chrono::steady_clock::now();
+        while (!stopRequested) {
+            // 带超时等待新连接，以便及时响应停止信号和输出统计
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listener, &readable);
+            timeval timeout{0, 200000};
+            int ready = select(static_cast<int>(listener) + 1, &readable, nullptr, nullptr, &timeout);
+            if (ready > 0) {
+                SocketHandle client = accept(listener, nullptr, nullptr);
+                if (client != INVALID_SOCKET_HANDLE) {
+                    std::thread(&MockServer::serveConnection, this, client).detach();
+                }
+            }
+
+            if (options.reportSeconds > 0 &&
+                std::chrono::steady_clock::now() - lastReport >= std::chrono::seconds(options.reportSeconds)) {
+                lastReport = std::chrono::steady_clock::now();
+                printStats("[统计]");
+            }
+        }
+
+        closeSocket(listener);
+        printStats("模拟LLM服务器已停止。");
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    SetConsoleOutputCP(65001);
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cerr << "无法初始化 Winsock" << std::endl;
+        return 1;
+    }
+#else
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    ServerOptions options;
+    if (!parseCommandLine(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (options.help) {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    MockServer server(options);
+    bool ok = server.run();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 在最多 threadCount 个线程中对 [0, count) 的每个下标执行 func（动态领取，负载均衡）
+// threadCount 为0时使用全部硬件线程；调用线程也参与执行，只有一个任务或一个线程时直接在调用线程中执行
+template <typename Func>
+void parallelFor(size_t count, unsigned threadCount, Func func) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            func(i);
+        }
+    };
+
+    size_t workers = std::min<size_t>(threadCount, count);
+    if (workers <= 1) {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t t = 0; t + 1 < workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
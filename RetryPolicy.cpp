@@ -0,0 +1,76 @@
+#include "RetryPolicy.h"
+#include "CounterRng.h"
+#include <algorithm>
+#include <cmath>
+
+void RetryPolicy::configure(const Settings& newSettings) {
+    std::lock_guard<std::mutex> lock(mutex);
+    settings = newSettings;
+    settings.maxRetries = std::max(0, settings.maxRetries);
+    settings.baseDelaySeconds = std::max(0.0, settings.baseDelaySeconds);
+    settings.maxDelaySeconds = std::max(settings.baseDelaySeconds, settings.maxDelaySeconds);
+    settings.deadlineSeconds = std::max(0.0, settings.deadlineSeconds);
+    settings.hedgePercentile = std::clamp(settings.hedgePercentile, 0.0, 0.999);
+}
+
+RetryPolicy::Settings RetryPolicy::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+bool RetryPolicy::isRetryable(const HttpResponse& response) {
+    if (response.aborted) {
+        return false;
+    }
+    return response.statusCode == 0 || response.statusCode == 429 || response.statusCode >= 500;
+}
+
+std::chrono::milliseconds RetryPolicy::backoffDelay(int retry) {
+    double base, cap;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        base = settings.baseDelaySeconds;
+        cap = settings.maxDelaySeconds;
+    }
+    double limit = std::min(cap, base * std::ldexp(1.0, std::min(retry, 30)));
+
+    // 抖动使用独立的随机数流，不影响模拟本身的随机序列
+    uint64_t bits = CounterRng::generate(CounterRng::getGlobalSeed(), CounterRng::STREAM_LLM_RETRY, jitterCounter++);
+    double seconds = limit * CounterRng::toUnitDouble(bits);
+    return std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000.0));
+}
+
+void RetryPolicy::recordLatency(RequestKind kind, double seconds) {
+    if (kind == RequestKind::Other) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    LatencyWindow& window = latencies[static_cast<size_t>(kind)];
+    window.samples[window.next] = seconds;
+    window.next = (window.next + 1) % LATENCY_WINDOW;
+    window.count = std::min(window.count + 1, LATENCY_WINDOW);
+}
+
+bool RetryPolicy::hedgeDelay(RequestKind kind, std::chrono::milliseconds& delay) const {
+    if (kind == RequestKind::Other) {
+        return false;
+    }
+    std::array<double, LATENCY_WINDOW> sorted;
+    size_t count;
+    double percentile;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const LatencyWindow& window = latencies[static_cast<size_t>(kind)];
+        percentile = settings.hedgePercentile;
+        count = window.count;
+        if (percentile <= 0.0 || count < MIN_HEDGE_SAMPLES) {
+            return false;
+        }
+        std::copy(window.samples.begin(), window.samples.begin() + count, sorted.begin());
+    }
+
+    size_t rank = std::min(count - 1, static_cast<size_t>(percentile * static_cast<double>(count)));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count);
+    delay = std::chrono::milliseconds(static_cast<int64_t>(std::ceil(sorted[rank] * 1000.0)));
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "HttpTransport.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// LLM请求重试策略：重试次数、每个请求的截止时间、指数退避加随机抖动、按延迟分位数发送对冲请求
+// 只保存参数、延迟统计和计数，请求的发送由 LLMClient 完成；所有方法都可以在多个线程中同时调用
+class RetryPolicy {
+public:
+    // 请求类型：不同类型的响应时间差别很大，分别统计延迟
+    enum class RequestKind {
+        Event,      // 事件生成（数百到数千个 token）
+        Choice,     // 选项选择（只返回一个数字）
+        Other       // 连接测试等，不对冲
+    };
+
+    struct Settings {
+        int maxRetries = 3;                 // 首次请求失败后最多重试的次数
+        double baseDelaySeconds = 0.25;     // 第一次重试前的最长等待
+        double maxDelaySeconds = 8.0;       // 退避等待的上限
+        double deadlineSeconds = 0.0;       // 每个请求（含重试）的截止时间，0 表示不限
+        double hedgePercentile = 0.0;       // 请求耗时超过该分位数时发送对冲请求（如 0.95），0 表示不对冲
+    };
+
+    // 每种请求保留的最近延迟样本数
+    static constexpr size_t LATENCY_WINDOW = 256;
+
+    // 延迟样本少于该数量时不对冲
+    static constexpr size_t MIN_HEDGE_SAMPLES = 16;
+
+    void configure(const Settings& settings);
+    Settings getSettings() const;
+
+    // 响应是否值得重试：传输失败（非主动中止）、限流（429）和服务器错误（5xx）
+    static bool isRetryable(const HttpResponse& response);
+
+    // 第 retry 次重试（从0开始）前的等待时间：在 [0, min(上限, 基础等待 * 2^retry)] 内均匀随机（full jitter）
+    std::chrono::milliseconds backoffDelay(int retry);
+
+    // 记录一次成功请求的耗时
+    void recordLatency(RequestKind kind, double seconds);
+
+    // 对冲等待时间：启用对冲且样本足够时返回 true，delay 为该类请求耗时的 hedgePercentile 分位数
+    bool hedgeDelay(RequestKind kind, std::chrono::milliseconds& delay) const;
+
+    // 计数
+    void countRetry() { ++retryCount; }
+    void countHedge() { ++hedgeCount; }
+    void countHedgeWin() { ++hedgeWinCount; }
+    void countDeadlineExceeded() { ++deadlineExceededCount; }
+    void countExhausted() { ++exhaustedCount; }
+
+    // 统计：重试次数、对冲请求数、对冲请求先返回的次数、因截止时间放弃的请求数、重试用尽仍失败的请求数
+    uint64_t getRetryCount() const { return retryCount; }
+    uint64_t getHedgeCount() const { return hedgeCount; }
+    uint64_t getHedgeWinCount() const { return hedgeWinCount; }
+    uint64_t getDeadlineExceededCount() const { return deadlineExceededCount; }
+    uint64_t getExhaustedCount() const { return exhaustedCount; }
+
+private:
+    // 最近的延迟样本（环形缓冲区）
+    struct LatencyWindow {
+        std::array<double, LATENCY_WINDOW> samples{};
+        size_t count = 0;
+        size_t next = 0;
+    };
+
+    mutable std::mutex mutex;
+    Settings settings;
+    std::array<LatencyWindow, 2> latencies;   // Event、Choice
+
+    std::atomic<uint64_t> jitterCounter{0};
+
+    std::atomic<uint64_t> retryCount{0};
+    std::atomic<uint64_t> hedgeCount{0};
+    std::atomic<uint64_t> hedgeWinCount{0};
+    std::atomic<uint64_t> deadlineExceededCount{0};
+    std::atomic<uint64_t> exhaustedCount{0};
+};
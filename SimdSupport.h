@@ -0,0 +1,11 @@
+#pragma once
+
+// SIMD 指令集检测：按编译选项选择 AVX2 / SSE2 实现，都不可用时各模块使用标量实现
+// AVX2 需要编译选项开启（见 CMakeLists.txt 中的 AMPH0REUS_ENABLE_AVX2），x64 默认至少有 SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AMPH_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AMPH_SIMD_SSE2 1
+#endif
@@ -1,53 +1,141 @@
 #include "SimulationEnvironment.h"
+#include "AgentSimilarity.h"
+#include "DecisionKernels.h"
+#include "Logger.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <filesystem>
-#include <windows.h>
 #include <chrono>
 #include <ctime>
 #include <cmath>
-#include <conio.h>  // 用于_kbhit和_getch
 #include <cstdlib>  // 用于system()
 #include <thread>   // 用于this_thread::sleep_for
 #include <iomanip>
 
+#ifdef _WIN32
+#include <conio.h>  // 用于_kbhit和_getch
+#endif
+
+namespace {
+    // 清屏（交互模式）
+    void clearScreen() {
+#ifdef _WIN32
+        system("cls");
+#else
+        system("clear");
+#endif
+    }
+    
+    // 检查用户是否按下了退出键（非阻塞，仅Windows控制台支持）
+    bool quitKeyPressed() {
+#ifdef _WIN32
+        if (_kbhit()) {
+            char ch = _getch();
+            return ch == 'q' || ch == 'Q';
+        }
+#endif
+        return false;
+    }
+    
+    // 读取非负整数配置项，未配置、格式错误或为负数时返回0
+    unsigned long long readUnsignedFromConfig(const JsonDocument& config, std::string_view key) {
+        return config.root()[key].asUnsigned(0);
+    }
+    
+    // 读取布尔配置项，未配置时返回 defaultValue
+    bool readBoolFromConfig(const JsonDocument& config, std::string_view key, bool defaultValue) {
+        return config.root()[key].asBool(defaultValue);
+    }
+}
+
 // 构造函数
-SimulationEnvironment::SimulationEnvironment() 
-    : running(false), eventCount(0), randomEventProb(0.3) {
-    rng.seed(std::random_device{}());
-    probDist = std::uniform_real_distribution<double>(0.0, 1.0);
+SimulationEnvironment::SimulationEnvironment(size_t numAgents, uint64_t seed) 
+    : agentIndex(agents), running(false), eventCount(0), randomEventProb(0.3),
+      broadcastMode(false), broadcastCohortSize(0), broadcastTick(0) {
+    // 读取一次配置文件，之后的配置项都从解析结果中读取
+    config.load("config.json");
+    
+    // 确定随机种子：构造参数 > 配置文件中的 random_seed > 随机种子
+    if (seed == 0) {
+        seed = readUnsignedFromConfig(config, "random_seed");
+    }
+    if (seed != 0) {
+        CounterRng::setGlobalSeed(seed);
+    }
+    rng = CounterRng(CounterRng::getGlobalSeed(), CounterRng::STREAM_ENVIRONMENT, 0);
+    agents.setSeed(CounterRng::getGlobalSeed());
+    LOG_INFO("随机种子: " << CounterRng::getGlobalSeed() << "（使用 --seed 或在 config.json 中设置 random_seed 可重放本次运行）");
     
-    // 初始化代理
-    agents.resize(NUM_AGENTS);
-    for (int i = 0; i < NUM_AGENTS; ++i) {
-        agents[i] = BioAgent(i);
+    // 确定代理数量：构造参数 > 配置文件 > 默认值
+    if (numAgents == 0) {
+        numAgents = static_cast<size_t>(readUnsignedFromConfig(config, "num_agents"));
+    }
+    if (numAgents == 0) {
+        numAgents = DEFAULT_NUM_AGENTS;
     }
     
+    // 初始化代理（resize 会随机初始化新增代理的决策向量）
+    agents.resize(numAgents);
+    agentIndex.rebuild();
+    
+    // 广播模式配置
+    broadcastMode = readBoolFromConfig(config, "broadcast_events", false);
+    broadcastCohortSize = static_cast<size_t>(readUnsignedFromConfig(config, "broadcast_cohort_size"));
+    
     // 初始化事件系统
     initializeEvents();
     
     // 初始化LLM客户端（可选）
     LLMClient::getInstance().initialize("config.json");
+    
+    // API模式下启动后台事件预取，模拟循环不再等待LLM往返
+    if (!LLMClient::getInstance().isSimulationMode() && readBoolFromConfig(config, "prefetch_enabled", true)) {
+        size_t depth = static_cast<size_t>(readUnsignedFromConfig(config, "prefetch_depth"));
+        unsigned concurrency = static_cast<unsigned>(readUnsignedFromConfig(config, "prefetch_concurrency"));
+        eventPrefetcher.start(depth == 0 ? EventPrefetcher::DEFAULT_DEPTH : depth,
+                              concurrency == 0 ? EventPrefetcher::DEFAULT_CONCURRENCY : concurrency);
+        LOG_INFO("LLM事件预取已启动（队列深度 " << (depth == 0 ? EventPrefetcher::DEFAULT_DEPTH : depth)
+                 << "，并发 " << (concurrency == 0 ? EventPrefetcher::DEFAULT_CONCURRENCY : concurrency) << "）");
+    }
 }
 
 // 析构函数
 SimulationEnvironment::~SimulationEnvironment() {
     stopSimulation();
+    LLMClient::getInstance().saveChoiceCache();
+    LLMClient::getInstance().saveMetrics();
 }
 
 // 初始化模拟环境
 void SimulationEnvironment::initialize() {
     // 创建必要的目录（如果不存在）
-    CreateDirectoryA("exp", NULL);
-    CreateDirectoryA("ws", NULL);
+    std::error_code ec;
+    std::filesystem::create_directories("exp", ec);
+    std::filesystem::create_directories("ws", ec);
     
     // 重置事件计数
     eventCount = 0;
     eventHistory.clear();
     
-    std::cout << "模拟环境初始化完成，共有 " << NUM_AGENTS << " 个代理。" << std::endl;
+    LOG_INFO("模拟环境初始化完成，共有 " << agents.size() << " 个代理。");
+}
+
+// 设置代理数量
+void SimulationEnvironment::setNumAgents(size_t numAgents) {
+    if (running) {
+        std::cout << "模拟运行中，无法调整代理数量。" << std::endl;
+        return;
+    }
+    if (numAgents == 0) {
+        std::cout << "代理数量必须大于0。" << std::endl;
+        return;
+    }
+    
+    agents.resize(numAgents);
+    agentIndex.rebuild();
+    std::cout << "代理数量已设置为 " << agents.size() << "。" << std::endl;
 }
 
 // 运行事件模拟
@@ -61,31 +149,43 @@ void SimulationEnvironment::runEventSimulation(int numEvents) {
     eventCount = 0;
     eventHistory.clear();
     
+    Logger::instance().flush();
     std::cout << "开始事件模拟，计划执行 " << numEvents << " 个事件。" << std::endl;
     std::cout << "随机事件概率: " << randomEventProb << std::endl;
+    if (broadcastMode) {
+        std::cout << "广播模式: 每个事件作用于 "
+                  << (broadcastCohortSize == 0 ? agents.size() : std::min(broadcastCohortSize, agents.size()))
+                  << " 个代理" << std::endl;
+    }
     std::cout << "==========================================" << std::endl;
     
     for (int i = 0; i < numEvents && running; ++i) {
-        std::cout << "\n事件 #" << (i + 1) << ":" << std::endl;
-        
         // 生成随机事件
-        ChoiceEvent event = generateRandomEvent();
+        EventHandle eventHandle = generateRandomEvent();
+        const ChoiceEvent& event = *eventHandle;
         
         // 处理事件
-        processEvent(event);
+        if (broadcastMode) {
+            processBroadcastEvent(event);
+        } else {
+            processEvent(event);
+        }
         
         eventCount++;
         
         // 显示当前代理状态
         if ((i + 1) % 5 == 0) {
-            std::cout << "\n--- 第 " << (i + 1) << " 个事件后的代理状态 ---" << std::endl;
-            for (int j = 0; j < std::min(3, NUM_AGENTS); ++j) {
-                std::cout << "代理 " << j << ": " << getAgentDecisionVectorString(j) << std::endl;
+            std::ostringstream status;
+            status << "\n--- 第 " << (i + 1) << " 个事件后的代理状态 ---";
+            for (size_t j = 0; j < std::min<size_t>(3, agents.size()); ++j) {
+                status << "\n代理 " << j << ": " << getAgentDecisionVectorString(j);
             }
+            LOG_INFO(status.str());
         }
     }
     
     running = false;
+    Logger::instance().flush();
     std::cout << "\n==========================================" << std::endl;
     std::cout << "事件模拟完成，共处理 " << eventCount << " 个事件。" << std::endl;
     
@@ -93,6 +193,125 @@ void SimulationEnvironment::runEventSimulation(int numEvents) {
     saveEventHistory();
 }
 
+// 运行批量模拟（无界面）
+void SimulationEnvironment::runBatchSimulation(int numEvents, int sampleInterval) {
+    if (running) {
+        std::cout << "模拟已经在运行中。" << std::endl;
+        return;
+    }
+    
+    // 未指定的参数从配置文件读取
+    if (numEvents <= 0) {
+        numEvents = static_cast<int>(readUnsignedFromConfig(config, "batch_events"));
+    }
+    if (numEvents <= 0) {
+        numEvents = DEFAULT_BATCH_EVENTS;
+    }
+    if (sampleInterval < 0) {
+        sampleInterval = static_cast<int>(readUnsignedFromConfig(config, "batch_sample_interval"));
+    }
+    
+    running = true;
+    eventCount = 0;
+    eventHistory.clear();
+    
+    Logger::instance().flush();
+    std::cout << "开始批量模拟: " << numEvents << " 个事件, " << agents.size() << " 个代理, "
+              << (broadcastMode ? "广播模式" : "单代理模式") << ", 采样间隔 "
+              << (sampleInterval > 0 ? std::to_string(sampleInterval) : std::string("关闭")) << std::endl;
+    
+    size_t agentUpdates = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    {
+        // 逐事件的 Debug/Info 日志在调用点直接跳过（不格式化、不入队），警告和错误仍然限速输出
+        ScopedLogLevel quiet(std::max(Logger::instance().getLevel(), LogLevel::Warn));
+        
+        for (int i = 0; i < numEvents && running; ++i) {
+            EventHandle eventHandle = generateRandomEvent();
+            const ChoiceEvent& event = *eventHandle;
+            
+            if (broadcastMode) {
+                agentUpdates += applyBroadcastEvent(event).count;
+            } else {
+                size_t agentId = getRandomAgentIndex();
+                int optionIndex = selectOptionForAgent(agents[agentId], event);
+                if (optionIndex >= 0 && static_cast<size_t>(optionIndex) < event.options.size()) {
+                    applyEventOutcome(agentId, event.options[optionIndex]);
+                    ++agentUpdates;
+                }
+            }
+            
+            eventCount++;
+            
+            if (sampleInterval > 0 && eventCount % sampleInterval == 0) {
+                // 整行一次写出，不会和后台线程写出的警告交错
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                std::ostringstream sample;
+                sample << "[" << eventCount << "/" << numEvents << "] " << std::fixed << std::setprecision(1)
+                       << (elapsed > 0.0 ? eventCount / elapsed : 0.0) << " 事件/秒, "
+                       << getPopulationSummary() << "\n";
+                std::cout << sample.str() << std::flush;
+            }
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    
+    running = false;
+    Logger::instance().flush();
+    
+    std::stringstream report;
+    report << std::fixed << std::setprecision(3);
+    report << "批量模拟完成，共处理 " << eventCount << " 个事件，用时 " << elapsed << " 秒" << std::endl;
+    report << std::setprecision(1);
+    report << "吞吐量: " << (elapsed > 0.0 ? eventCount / elapsed : 0.0) << " 事件/秒, "
+           << (elapsed > 0.0 ? agentUpdates / elapsed : 0.0) << " 次代理更新/秒";
+    if (eventPrefetcher.isRunning()) {
+        report << std::endl << "LLM事件预取: 命中 " << eventPrefetcher.getHitCount()
+               << "，未命中 " << eventPrefetcher.getMissCount()
+               << "，请求失败 " << eventPrefetcher.getFailureCount();
+    }
+    const LLMHealthMonitor& healthMonitor = LLMClient::getInstance().getHealthMonitor();
+    if (healthMonitor.getTripCount() > 0) {
+        report << std::endl << "LLM熔断: " << healthMonitor.getTripCount() << " 次，立即失败的请求 "
+               << healthMonitor.getRejectedCount() << "，当前状态 "
+               << LLMHealthMonitor::stateName(healthMonitor.getState());
+    }
+    const RetryPolicy& retryPolicy = LLMClient::getInstance().getRetryPolicy();
+    if (retryPolicy.getRetryCount() + retryPolicy.getHedgeCount() > 0) {
+        report << std::endl << "LLM重试: " << retryPolicy.getRetryCount() << " 次，重试后仍失败 "
+               << retryPolicy.getExhaustedCount() << "，超过截止时间 " << retryPolicy.getDeadlineExceededCount()
+               << "，对冲请求 " << retryPolicy.getHedgeCount() << "（先返回 " << retryPolicy.getHedgeWinCount() << "）";
+    }
+    const ChoiceCache& choiceCache = LLMClient::getInstance().getChoiceCache();
+    if (choiceCache.getHitCount() + choiceCache.getMissCount() > 0) {
+        report << std::endl << "LLM选择缓存: 命中 " << choiceCache.getHitCount()
+               << "，未命中 " << choiceCache.getMissCount()
+               << "，条目 " << choiceCache.size() << "/" << choiceCache.getCapacity();
+    }
+    const LLMMetrics& metrics = LLMClient::getInstance().getMetrics();
+    for (auto kind : {LLMMetrics::RequestKind::Event, LLMMetrics::RequestKind::Choice}) {
+        const LLMMetrics::Histogram& latency = metrics.getCallLatency(kind);
+        if (latency.getCount() == 0) {
+            continue;
+        }
+        report << std::endl << "LLM" << (kind == LLMMetrics::RequestKind::Event ? "事件" : "选择") << "请求: "
+               << latency.getCount() << " 次，成功 " << metrics.getSuccessCount(kind) << "/" << metrics.getRequestCount(kind)
+               << " 次尝试，延迟 p50 " << latency.percentile(0.50) * 1000.0 << "ms p99 " << latency.percentile(0.99) * 1000.0
+               << "ms 最大 " << latency.getMaxSeconds() * 1000.0 << "ms，token 输入 " << metrics.getPromptTokens(kind)
+               << " 输出 " << metrics.getCompletionTokens(kind) << "，最大在途 " << metrics.getPeakInFlight(kind);
+    }
+    uint64_t eventFallbacks = metrics.getOutcomeCount(LLMMetrics::Outcome::EventFallbackSaved) +
+                              metrics.getOutcomeCount(LLMMetrics::Outcome::EventFallbackSimulated);
+    if (metrics.getCallLatency(LLMMetrics::RequestKind::Event).getCount() + eventFallbacks > 0) {
+        report << std::endl << "LLM事件结果: 有效 " << metrics.getOutcomeCount(LLMMetrics::Outcome::EventValid)
+               << "，无效 " << metrics.getOutcomeCount(LLMMetrics::Outcome::EventInvalid)
+               << "，使用保存的事件 " << metrics.getOutcomeCount(LLMMetrics::Outcome::EventFallbackSaved)
+               << "，使用模拟事件 " << metrics.getOutcomeCount(LLMMetrics::Outcome::EventFallbackSimulated);
+    }
+    report << std::endl << getPopulationSummary();
+    std::cout << report.str() << std::endl;
+}
+
 // 运行交互式模拟（实时显示代理状态）
 void SimulationEnvironment::runInteractiveSimulation(int numEvents) {
     if (running) {
@@ -104,77 +323,90 @@ void SimulationEnvironment::runInteractiveSimulation(int numEvents) {
     eventCount = 0;
     eventHistory.clear();
     
+    Logger::instance().flush();
     std::cout << "开始交互式模拟，计划执行 " << numEvents << " 个事件。" << std::endl;
     std::cout << "随机事件概率: " << randomEventProb << std::endl;
     std::cout << "按任意键开始，模拟过程中按 'q' 键退出..." << std::endl;
     std::cin.get();
     
     // 清屏并显示初始状态
-    system("cls");
+    clearScreen();
     
     for (int i = 0; i < numEvents && running; ++i) {
         // 生成并处理事件，但不显示事件详情
-        ChoiceEvent event = generateRandomEvent();
+        EventHandle eventHandle = generateRandomEvent();
+        const ChoiceEvent& event = *eventHandle;
         
-        // 随机选择一个代理参与事件
-        int agentId = getRandomInt(0, NUM_AGENTS - 1);
-        
-        // 代理选择选项
-        int optionIndex = selectOptionForAgent(agents[agentId], event);
-        
-        if (optionIndex >= 0 && optionIndex < event.options.size()) {
-            // 应用事件结果
-            applyEventOutcome(agentId, event.options[optionIndex]);
+        std::stringstream participants;
+        if (broadcastMode) {
+            // 广播模式：群组中的所有代理同时参与
+            BroadcastResult result = applyBroadcastEvent(event);
+            recordBroadcastEvent(event, result);
+            participants << result.count << " 个代理（#" << result.first << " 起）";
+        } else {
+            // 随机选择一个代理参与事件
+            size_t agentId = getRandomAgentIndex();
+            participants << agentId;
+            
+            // 代理选择选项
+            int optionIndex = selectOptionForAgent(agents[agentId], event);
             
-            // 记录事件（但不显示）
-            std::stringstream record;
-            record << "事件#" << eventCount + 1 << ": " << event.name 
-                   << " | 代理#" << agentId << " 选择了: " << event.options[optionIndex].text;
-            recordEvent(record.str());
+            if (optionIndex >= 0 && static_cast<size_t>(optionIndex) < event.options.size()) {
+                // 应用事件结果
+                applyEventOutcome(agentId, event.options[optionIndex]);
+                
+                // 记录事件（但不显示）
+                std::stringstream record;
+                record << "事件#" << eventCount + 1 << ": " << event.name 
+                       << " | 代理#" << agentId << " 选择了: " << event.options[optionIndex].text;
+                recordEvent(record.str());
+            }
         }
         
         eventCount++;
         
-        // 更新显示
+        // 更新显示（先写完生成事件时的日志）
+        Logger::instance().flush();
         std::cout << "==========================================" << std::endl;
         std::cout << "     决策向量与随机事件模拟系统 (交互模式)     " << std::endl;
         std::cout << "==========================================" << std::endl;
         std::cout << "事件进度: " << (i + 1) << " / " << numEvents << std::endl;
         std::cout << "当前事件: " << event.name << std::endl;
-        std::cout << "参与代理: " << agentId << std::endl;
+        std::cout << "参与代理: " << participants.str() << std::endl;
         std::cout << "------------------------------------------" << std::endl;
         std::cout << "所有代理的当前状态:" << std::endl;
         std::cout << "------------------------------------------" << std::endl;
         
-        // 显示所有代理的详细状态
+        // 显示代理的详细状态（代理过多时只列出前一部分并给出汇总）
         auto statusList = getAllAgentsDetailedStatus();
         for (const auto& status : statusList) {
             std::cout << status << std::endl;
         }
+        if (agents.size() > statusList.size()) {
+            std::cout << "... 共 " << agents.size() << " 个代理，" << getPopulationSummary() << std::endl;
+        }
         
         std::cout << "------------------------------------------" << std::endl;
         std::cout << "按 'q' 键退出模拟，或等待下一个事件..." << std::endl;
         
         // 检查用户输入（非阻塞）
-        if (_kbhit()) {
-            char ch = _getch();
-            if (ch == 'q' || ch == 'Q') {
-                std::cout << "\n用户请求退出模拟。" << std::endl;
-                break;
-            }
+        if (quitKeyPressed()) {
+            std::cout << "\n用户请求退出模拟。" << std::endl;
+            break;
         }
         
         // 短暂暂停以便观察
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
         
         // 清屏为下一次更新做准备
-        system("cls");
+        clearScreen();
     }
     
     running = false;
     
     // 最终状态显示
-    system("cls");
+    Logger::instance().flush();
+    clearScreen();
     std::cout << "==========================================" << std::endl;
     std::cout << "     交互式模拟完成     " << std::endl;
     std::cout << "==========================================" << std::endl;
@@ -186,6 +418,9 @@ void SimulationEnvironment::runInteractiveSimulation(int numEvents) {
     for (const auto& status : finalStatus) {
         std::cout << status << std::endl;
     }
+    if (agents.size() > finalStatus.size()) {
+        std::cout << "... 共 " << agents.size() << " 个代理，" << getPopulationSummary() << std::endl;
+    }
     
     // 保存事件历史
     saveEventHistory();
@@ -196,7 +431,7 @@ void SimulationEnvironment::runInteractiveSimulation(int numEvents) {
 
 // 添加用户自定义事件
 void SimulationEnvironment::addUserEvent(const std::string& name, const std::string& description,
-                                        const std::vector<std::tuple<std::string, std::vector<double>, std::string>>& options) {
+                                        const std::vector<std::tuple<std::string, DecisionVector, std::string>>& options) {
     ChoiceEvent newEvent;
     newEvent.name = name;
     newEvent.description = description;
@@ -225,24 +460,20 @@ std::string SimulationEnvironment::getAgentDecisionVectorString(int agentId) con
     return agents[agentId].getDecisionVectorString();
 }
 
-// 获取所有代理的详细状态
-std::vector<std::string> SimulationEnvironment::getAllAgentsDetailedStatus() const {
+// 获取代理的详细状态
+std::vector<std::string> SimulationEnvironment::getAllAgentsDetailedStatus(size_t maxAgents) const {
     std::vector<std::string> statusList;
+    size_t displayCount = std::min(maxAgents, agents.size());
+    statusList.reserve(displayCount);
     
-    for (const auto& agent : agents) {
+    for (size_t agentId = 0; agentId < displayCount; ++agentId) {
         std::stringstream ss;
-        ss << "代理 " << agent.getId() << ": ";
-        
-        const std::vector<double>& decisionVec = agent.getDecisionVector();
-        const char* dimensionNames[BioAgent::DECISION_VECTOR_DIMENSIONS] = {
-            "快乐", "悲伤", "愤怒", "恐惧", "厌恶", "惊讶",
-            "信任", "期待", "宁静", "效价", "唤醒度", "优势度"
-        };
+        ss << "代理 " << agentId << ": ";
         
         ss << "[";
         for (int i = 0; i < BioAgent::DECISION_VECTOR_DIMENSIONS; ++i) {
             ss << std::fixed << std::setprecision(2);
-            ss << dimensionNames[i] << ":" << decisionVec[i];
+            ss << BioAgent::getDimensionName(i) << ":" << agents.getValue(agentId, i);
             if (i < BioAgent::DECISION_VECTOR_DIMENSIONS - 1) {
                 ss << ", ";
             }
@@ -255,6 +486,66 @@ std::vector<std::string> SimulationEnvironment::getAllAgentsDetailedStatus() con
     return statusList;
 }
 
+// 列出的代理与整个种群的相似度：只计算这些代理所在的行，代价与种群大小成线性关系
+std::vector<std::string> SimulationEnvironment::getSimilarAgentsStatus(size_t maxAgents, size_t k) const {
+    std::vector<std::string> statusList;
+    size_t displayCount = std::min(maxAgents, agents.size());
+    if (displayCount == 0 || k == 0) {
+        return statusList;
+    }
+    
+    AgentSimilarity similarity(agents);
+    std::vector<AgentSimilarity::Neighbor> neighbors = similarity.topK(k, 0, displayCount);
+    statusList.reserve(displayCount);
+    for (size_t agentId = 0; agentId < displayCount; ++agentId) {
+        std::stringstream ss;
+        ss << "代理 " << agentId << ":";
+        ss << std::fixed << std::setprecision(3);
+        for (size_t n = 0; n < k; ++n) {
+            const AgentSimilarity::Neighbor& neighbor = neighbors[agentId * k + n];
+            if (neighbor.agentId < 0) {
+                break;
+            }
+            ss << (n == 0 ? " " : ", ") << "代理 " << neighbor.agentId << " (" << neighbor.similarity << ")";
+        }
+        statusList.push_back(ss.str());
+    }
+    return statusList;
+}
+
+// 获取整个种群的汇总状态（逐维度顺序扫描连续数组）
+std::string SimulationEnvironment::getPopulationSummary() const {
+    std::stringstream ss;
+    ss << "种群平均值: [";
+    
+    ss << std::fixed << std::setprecision(2);
+    for (int d = 0; d < BioAgent::DECISION_VECTOR_DIMENSIONS; ++d) {
+        const double* values = agents.dimensionData(d);
+        double sum = 0.0;
+        for (size_t i = 0; i < agents.size(); ++i) {
+            sum += values[i];
+        }
+        double mean = agents.empty() ? 0.0 : sum / agents.size();
+        ss << BioAgent::getDimensionName(d) << ":" << mean;
+        if (d < BioAgent::DECISION_VECTOR_DIMENSIONS - 1) {
+            ss << ", ";
+        }
+    }
+    ss << "]";
+    
+    return ss.str();
+}
+
+// 查找最接近的代理
+std::vector<DecisionIndex::Match> SimulationEnvironment::findNearestAgents(const DecisionVector& target, size_t k) const {
+    return agentIndex.nearest(target, k);
+}
+
+// 查找指定半径内的代理
+std::vector<DecisionIndex::Match> SimulationEnvironment::findAgentsWithinRadius(const DecisionVector& target, double radius) const {
+    return agentIndex.withinRadius(target, radius);
+}
+
 // 初始化事件系统
 void SimulationEnvironment::initializeEvents() {
     events.clear();
@@ -280,44 +571,35 @@ void SimulationEnvironment::initializeEvents() {
     event1.options = {option1a, option1b};
     events.push_back(event1);
     
-    std::cout << "事件系统初始化完成，已加载 " << events.size() << " 个默认事件。" << std::endl;
+    LOG_INFO("事件系统初始化完成，已加载 " << events.size() << " 个默认事件。");
 }
 
 // 生成随机事件
-SimulationEnvironment::ChoiceEvent SimulationEnvironment::generateRandomEvent() {
+SimulationEnvironment::EventHandle SimulationEnvironment::generateRandomEvent() {
     // 优先尝试使用LLM生成事件
     try {
-        std::cout << "正在尝试从LLM获取随机事件..." << std::endl;
-        ChoiceEvent llmEvent = generateLLMEvent();
-        std::cout << "成功从LLM获取事件: " << llmEvent.name << std::endl;
+        LOG_DEBUG("正在尝试从LLM获取随机事件...");
+        EventHandle llmEvent = generateLLMEvent();
+        LOG_DEBUG("成功从LLM获取事件: " << llmEvent->name);
         return llmEvent;
     } catch (const std::exception& e) {
-        std::cerr << "LLM事件生成失败: " << e.what() << std::endl;
-        std::cout << "回退到简单事件生成..." << std::endl;
+        LOG_WARN("LLM事件生成失败: " << e.what());
+        LOG_DEBUG("回退到简单事件生成...");
         return generateSimpleEvent();
     }
 }
 
-// 处理事件
+// 处理事件（事件详情作为一条日志输出，限速时整条省略）
 void SimulationEnvironment::processEvent(const ChoiceEvent& event) {
-    std::cout << "\n事件: " << event.name << std::endl;
-    std::cout << "描述: " << event.description << std::endl;
-    std::cout << "选项:" << std::endl;
-    
-    for (size_t i = 0; i < event.options.size(); ++i) {
-        std::cout << "  " << (i + 1) << ". " << event.options[i].text << std::endl;
-    }
-    
     // 随机选择一个代理参与事件
-    int agentId = getRandomInt(0, NUM_AGENTS - 1);
-    std::cout << "代理 " << agentId << " 参与此事件。" << std::endl;
+    size_t agentId = getRandomAgentIndex();
     
     // 代理选择选项
     int optionIndex = selectOptionForAgent(agents[agentId], event);
     
     if (optionIndex >= 0 && optionIndex < event.options.size()) {
-        std::cout << "代理选择了选项: " << event.options[optionIndex].text << std::endl;
-        std::cout << "结果: " << event.options[optionIndex].outcomeText << std::endl;
+        LOG_INFO(describeEvent(event) << "\n代理 " << agentId << " 参与此事件。\n代理选择了选项: "
+                 << event.options[optionIndex].text << "\n结果: " << event.options[optionIndex].outcomeText);
         
         // 应用事件结果
         applyEventOutcome(agentId, event.options[optionIndex]);
@@ -329,70 +611,173 @@ void SimulationEnvironment::processEvent(const ChoiceEvent& event) {
                << " | 结果: " << event.options[optionIndex].outcomeText;
         recordEvent(record.str());
     } else {
-        std::cout << "代理无法做出选择。" << std::endl;
+        LOG_INFO(describeEvent(event) << "\n代理 " << agentId << " 参与此事件。\n代理无法做出选择。");
     }
 }
 
-// 为代理选择选项
-int SimulationEnvironment::selectOptionForAgent(const BioAgent& agent, const ChoiceEvent& event) {
-    // 首先检查是否有满足决策要求的选项
-    std::vector<int> validOptions;
+// 处理广播事件
+void SimulationEnvironment::processBroadcastEvent(const ChoiceEvent& event) {
+    BroadcastResult result = applyBroadcastEvent(event);
+    LOG_INFO(describeEvent(event, &result.chosenCounts) << "\n代理 " << result.first << " - " << (result.first + result.count - 1)
+             << "（共 " << result.count << " 个）参与此事件。");
+    if (result.fallbackCount > 0) {
+        LOG_INFO("其中 " << result.fallbackCount << " 个代理不满足任何选项的要求，已随机选择。");
+    }
+    
+    recordBroadcastEvent(event, result);
+}
+
+// 事件详情
+std::string SimulationEnvironment::describeEvent(const ChoiceEvent& event, const std::vector<size_t>* chosenCounts) const {
+    std::ostringstream out;
+    out << "\n事件 #" << eventCount + 1 << ":\n事件: " << event.name << "\n描述: " << event.description << "\n选项:";
     for (size_t i = 0; i < event.options.size(); ++i) {
-        if (agent.checkDecisionRequirement(event.options[i].decisionRequirement)) {
-            validOptions.push_back(i);
+        out << "\n  " << (i + 1) << ". " << event.options[i].text;
+        if (chosenCounts != nullptr && i < chosenCounts->size()) {
+            out << " —— " << (*chosenCounts)[i] << " 个代理选择";
         }
     }
+    return out.str();
+}
+
+// 对群组批量应用广播事件
+SimulationEnvironment::BroadcastResult SimulationEnvironment::applyBroadcastEvent(const ChoiceEvent& event) {
+    BroadcastResult result;
+    result.chosenCounts.assign(event.options.size(), 0);
+    if (event.options.empty() || agents.empty()) {
+        return result;
+    }
     
-    if (!validOptions.empty()) {
-        // 随机选择一个有效选项
-        return validOptions[getRandomInt(0, validOptions.size() - 1)];
+    // 确定群组：整个种群，或随机位置的一段连续代理
+    result.count = broadcastCohortSize == 0 ? agents.size() : std::min(broadcastCohortSize, agents.size());
+    if (result.count < agents.size()) {
+        std::uniform_int_distribution<size_t> dist(0, agents.size() - result.count);
+        result.first = dist(rng);
+    }
+    // 每个选项的决策要求对整个群组检查一次（掩码只覆盖群组，第 i 位对应代理 first + i）
+    std::vector<AgentMask> validMasks(event.options.size());
+    for (size_t o = 0; o < event.options.size(); ++o) {
+        DecisionKernels::checkRequirement(agents, result.first, result.count,
+                                          event.options[o].decisionRequirement, validMasks[o]);
     }
     
-    // 如果没有满足要求的选项，使用LLM帮助选择
-    if (LLMClient::getInstance().testConnection()) {
-        std::vector<double> decisionVec = agent.getDecisionVector();
-        std::vector<LLMClient::EventOption> llmOptions;
+    // 每个代理在满足要求的选项中随机选择一个（与 selectOptionForAgent 一致）
+    // 都不满足时在所有选项中随机选择：广播模式下不为单个代理请求LLM
+    // 随机数按 (本次广播事件, 代理ID) 取，结果与处理顺序无关
+    std::vector<AgentMask> buckets(event.options.size(), DecisionKernels::createMask(result.count));
+    uint64_t seed = CounterRng::getGlobalSeed();
+    uint64_t stream = CounterRng::deriveStream(CounterRng::STREAM_BROADCAST, broadcastTick++);
+    for (size_t offset = 0; offset < result.count; ++offset) {
+        size_t word = offset / 64;
+        uint64_t bit = 1ULL << (offset % 64);
+        
+        size_t validCount = 0;
+        for (const auto& mask : validMasks) {
+            if (mask[word] & bit) {
+                ++validCount;
+            }
+        }
         
-        for (const auto& option : event.options) {
-            LLMClient::EventOption llmOption;
-            llmOption.text = option.text;
-            llmOption.decisionRequirement = option.decisionRequirement;
-            llmOption.decisionFeedback = option.decisionFeedback;
-            llmOption.outcomeText = option.outcomeText;
-            llmOptions.push_back(llmOption);
+        uint64_t random = CounterRng::generate(seed, stream, result.first + offset);
+        size_t chosen = 0;
+        if (validCount == 0) {
+            chosen = static_cast<size_t>(random % event.options.size());
+            ++result.fallbackCount;
+        } else {
+            size_t pick = static_cast<size_t>(random % validCount);
+            while (!(validMasks[chosen][word] & bit) || pick-- != 0) {
+                ++chosen;
+            }
         }
         
-        return LLMClient::getInstance().getLLMChoice(
-            agent.getId(), decisionVec, event.description, llmOptions);
+        buckets[chosen][word] |= bit;
+        ++result.chosenCounts[chosen];
+    }
+    
+    // 按选项分组批量应用反馈；最近邻索引只在已经建树时记录移动的代理
+    for (size_t o = 0; o < event.options.size(); ++o) {
+        if (result.chosenCounts[o] == 0) {
+            continue;
+        }
+        DecisionKernels::applyFeedbackMasked(agents, result.first, buckets[o], event.options[o].decisionFeedback);
+        if (agentIndex.isBuilt()) {
+            agentIndex.updateMasked(result.first, buckets[o]);
+        }
+    }
+    
+    return result;
+}
+
+// 记录广播事件（每个事件一条汇总记录）
+void SimulationEnvironment::recordBroadcastEvent(const ChoiceEvent& event, const BroadcastResult& result) {
+    std::stringstream record;
+    record << "事件#" << eventCount + 1 << ": " << event.name
+           << " | 广播至 " << result.count << " 个代理";
+    for (size_t i = 0; i < event.options.size(); ++i) {
+        record << " | " << event.options[i].text << ": " << result.chosenCounts[i];
+    }
+    if (result.fallbackCount > 0) {
+        record << " | 随机选择: " << result.fallbackCount;
+    }
+    recordEvent(record.str());
+}
+
+// 为代理选择选项
+int SimulationEnvironment::selectOptionForAgent(const BioAgent& agent, const ChoiceEvent& event) {
+    // 首先统计满足决策要求的选项数量（不分配内存，每个事件每个代理都会调用）
+    int validCount = 0;
+    for (const auto& option : event.options) {
+        if (agent.checkDecisionRequirement(option.decisionRequirement)) {
+            ++validCount;
+        }
+    }
+    
+    if (validCount > 0) {
+        // 随机选择一个有效选项：再扫描一遍，取第 pick 个满足要求的选项
+        int pick = getRandomInt(0, validCount - 1);
+        for (size_t i = 0; i < event.options.size(); ++i) {
+            if (agent.checkDecisionRequirement(event.options[i].decisionRequirement) && pick-- == 0) {
+                return static_cast<int>(i);
+            }
+        }
+    }
+    
+    // 如果没有满足要求的选项，使用LLM帮助选择（事件选项与LLMClient同类型，直接传引用）
+    LLMClient& llmClient = LLMClient::getInstance();
+    DecisionVector decisionVec = agent.getDecisionVector();
+    
+    // 缓存中已有选择，或服务未熔断时请求LLM（熔断期间直接使用本地回退，不等待网络）
+    if (llmClient.hasCachedChoice(decisionVec, event.description, event.options) || llmClient.isAvailable()) {
+        return llmClient.getLLMChoice(agent.getId(), decisionVec, event.description, event.options);
     }
     
     // 如果LLM也不可用，随机选择
+    llmClient.getMetrics().countOutcome(LLMMetrics::Outcome::ChoiceFallback);
     return getRandomInt(0, event.options.size() - 1);
 }
 
 // 应用事件结果
-void SimulationEnvironment::applyEventOutcome(int agentId, const EventOption& option) {
-    if (agentId < 0 || agentId >= agents.size()) {
+void SimulationEnvironment::applyEventOutcome(size_t agentId, const EventOption& option) {
+    if (agentId >= agents.size()) {
         return;
     }
     
     agents[agentId].updateDecisionVector(option.decisionFeedback);
+    agentIndex.update(agentId);
     
     // 显示决策向量变化
-    std::cout << "代理 " << agentId << " 的决策向量已更新。" << std::endl;
+    LOG_DEBUG("代理 " << agentId << " 的决策向量已更新。");
 }
 
 // 生成简单事件
-SimulationEnvironment::ChoiceEvent SimulationEnvironment::generateSimpleEvent() {
-    ChoiceEvent event;
-    
-    // 事件主题列表
-    std::vector<std::string> eventThemes = {
+SimulationEnvironment::EventHandle SimulationEnvironment::generateSimpleEvent() {
+    // 事件主题、描述、选项文本和结果文本（静态表，每次生成事件不再重建）
+    static const std::vector<std::string> eventThemes = {
         "情感挑战", "道德困境", "社交互动", "自我反思", 
         "环境适应", "压力应对", "目标设定", "风险决策"
     };
     
-    std::vector<std::string> eventDescriptions = {
+    static const std::vector<std::string> eventDescriptions = {
         "面对复杂的情感状况，需要做出选择",
         "遇到道德困境，需要在不同价值观之间权衡",
         "在社交场合中需要做出适当的反应",
@@ -403,64 +788,58 @@ SimulationEnvironment::ChoiceEvent SimulationEnvironment::generateSimpleEvent()
         "面临风险，需要在安全与机会之间选择"
     };
     
+    static const std::vector<std::string> optionTexts = {
+        "注重情感表达", "保持理性思考", "寻求平衡", "冒险尝试",
+        "谨慎行事", "依赖直觉", "参考他人意见", "坚持原则"
+    };
+    
+    static const std::vector<std::string> outcomes = {
+        "这个选择带来了新的视角",
+        "选择的结果符合预期",
+        "这个决定引发了进一步的思考",
+        "选择导致了有趣的发展",
+        "决定带来了情感上的满足",
+        "这个选择促进了个人成长"
+    };
+    
+    auto event = std::make_shared<ChoiceEvent>();
     int themeIndex = getRandomInt(0, eventThemes.size() - 1);
-    event.name = eventThemes[themeIndex];
-    event.description = eventDescriptions[themeIndex];
+    event->name = eventThemes[themeIndex];
+    event->description = eventDescriptions[themeIndex];
     
     // 生成2-3个选项
     int numOptions = getRandomInt(2, 3);
+    event->options.reserve(numOptions);
     for (int i = 0; i < numOptions; ++i) {
-        EventOption option;
-        
-        std::vector<std::string> optionTexts = {
-            "注重情感表达", "保持理性思考", "寻求平衡", "冒险尝试",
-            "谨慎行事", "依赖直觉", "参考他人意见", "坚持原则"
-        };
-        
-        std::vector<std::string> outcomes = {
-            "这个选择带来了新的视角",
-            "选择的结果符合预期",
-            "这个决定引发了进一步的思考",
-            "选择导致了有趣的发展",
-            "决定带来了情感上的满足",
-            "这个选择促进了个人成长"
-        };
-        
+        EventOption& option = event->options.emplace_back();
         option.text = optionTexts[getRandomInt(0, optionTexts.size() - 1)];
         option.decisionRequirement = generateRandomDecisionVector();
         option.decisionFeedback = generateRandomFeedbackVector();
         option.outcomeText = outcomes[getRandomInt(0, outcomes.size() - 1)];
-        
-        event.options.push_back(option);
     }
     
     return event;
 }
 
 // 使用LLM生成事件
-SimulationEnvironment::ChoiceEvent SimulationEnvironment::generateLLMEvent() {
-    // 尝试从LLM获取事件
-    LLMClient::RandomEvent llmEvent = LLMClient::getInstance().generateRandomEvent();
+SimulationEnvironment::EventHandle SimulationEnvironment::generateLLMEvent() {
+    EventHandle llmEvent;
+    if (eventPrefetcher.isRunning()) {
+        // 只取预取好的事件；队列为空时使用保存的事件或模拟事件，不等待LLM
+        if (!eventPrefetcher.tryPop(llmEvent)) {
+            llmEvent = LLMClient::getInstance().getSavedRandomEvent();
+        }
+    } else {
+        // 未启用预取时同步请求LLM
+        llmEvent = LLMClient::getInstance().generateRandomEvent();
+    }
     
     // 检查事件是否有效
-    if (llmEvent.name.empty() || llmEvent.options.empty()) {
+    if (!llmEvent || llmEvent->name.empty() || llmEvent->options.empty()) {
         throw std::runtime_error("LLM返回的事件无效");
     }
     
-    ChoiceEvent event;
-    event.name = llmEvent.name;
-    event.description = llmEvent.description;
-    
-    for (const auto& llmOption : llmEvent.options) {
-        EventOption option;
-        option.text = llmOption.text;
-        option.decisionRequirement = llmOption.decisionRequirement;
-        option.decisionFeedback = llmOption.decisionFeedback;
-        option.outcomeText = llmOption.outcomeText;
-        event.options.push_back(option);
-    }
-    
-    return event;
+    return llmEvent;
 }
 
 // 随机数生成辅助方法
@@ -474,9 +853,14 @@ int SimulationEnvironment::getRandomInt(int min, int max) {
     return dist(rng);
 }
 
+size_t SimulationEnvironment::getRandomAgentIndex() {
+    std::uniform_int_distribution<size_t> dist(0, agents.size() - 1);
+    return dist(rng);
+}
+
 // 生成随机决策向量
-std::vector<double> SimulationEnvironment::generateRandomDecisionVector() {
-    std::vector<double> vector(BioAgent::DECISION_VECTOR_DIMENSIONS);
+DecisionVector SimulationEnvironment::generateRandomDecisionVector() {
+    DecisionVector vector;
     for (int i = 0; i < BioAgent::DECISION_VECTOR_DIMENSIONS; ++i) {
         vector[i] = getRandomDouble(0.0, 0.8); // 要求值通常较低
     }
@@ -484,8 +868,8 @@ std::vector<double> SimulationEnvironment::generateRandomDecisionVector() {
 }
 
 // 生成随机反馈向量
-std::vector<double> SimulationEnvironment::generateRandomFeedbackVector() {
-    std::vector<double> vector(BioAgent::DECISION_VECTOR_DIMENSIONS);
+DecisionVector SimulationEnvironment::generateRandomFeedbackVector() {
+    DecisionVector vector;
     for (int i = 0; i < BioAgent::DECISION_VECTOR_DIMENSIONS; ++i) {
         // 反馈值在-0.2到0.2之间
         vector[i] = getRandomDouble(-0.2, 0.2);
@@ -517,6 +901,6 @@ void SimulationEnvironment::saveEventHistory() {
         }
         
         file.close();
-        std::cout << "事件历史已保存到 ws/event_history.txt" << std::endl;
+        LOG_INFO("事件历史已保存到 ws/event_history.txt");
     }
 }
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "BioAgent.h"
+#include "AgentPopulation.h"
+#include "DecisionIndex.h"
 #include "LLMClient.h"
+#include "EventPrefetcher.h"
+#include "CounterRng.h"
+#include "Json.h"
 #include <string>
 #include <vector>
 #include <random>
@@ -13,11 +18,19 @@
 
 class SimulationEnvironment {
 public:
-    // 常量：代理数量
-    static constexpr int NUM_AGENTS = 12;
+    // 常量：默认代理数量（构造参数和配置文件都未指定时使用）
+    static constexpr size_t DEFAULT_NUM_AGENTS = 12;
+    
+    // 常量：状态显示时最多逐个列出的代理数量，其余只做汇总统计
+    static constexpr size_t MAX_DISPLAYED_AGENTS = 20;
+    
+    // 常量：批量模拟默认事件数量（参数和配置文件都未指定时使用）
+    static constexpr int DEFAULT_BATCH_EVENTS = 1000;
     
     // 构造函数
-    SimulationEnvironment();
+    // numAgents 为 0 时从 config.json 的 "num_agents" 读取，未配置则使用 DEFAULT_NUM_AGENTS
+    // seed 为 0 时使用 config.json 中的 "random_seed"（非0），被设为全局随机种子，用于重放整次运行
+    explicit SimulationEnvironment(size_t numAgents = 0, uint64_t seed = 0);
     ~SimulationEnvironment();
     
     // 初始化模拟环境
@@ -29,6 +42,11 @@ public:
     // 运行交互式模拟（实时显示代理状态）
     void runInteractiveSimulation(int numEvents = 10);
     
+    // 运行批量模拟：无清屏、无暂停、不记录事件历史，尽可能快地处理事件，结束时报告吞吐量
+    // numEvents <= 0 时使用 config.json 的 "batch_events"（默认 DEFAULT_BATCH_EVENTS）
+    // sampleInterval > 0 时每隔该数量的事件输出一行进度，0 表示关闭，< 0 时使用 "batch_sample_interval"
+    void runBatchSimulation(int numEvents = 0, int sampleInterval = -1);
+    
     // 停止模拟
     void stopSimulation() { running = false; }
     
@@ -38,40 +56,71 @@ public:
     // 设置随机事件概率
     void setRandomEventProbability(double prob) { randomEventProb = prob; }
     
+    // 广播模式：每个事件作用于整个种群（或一个代理群组），而不是单个随机代理
+    void setBroadcastMode(bool enabled) { broadcastMode = enabled; }
+    bool isBroadcastMode() const { return broadcastMode; }
+    
+    // 广播群组大小：0 表示整个种群，否则每个事件随机选取一段连续的 cohortSize 个代理
+    void setBroadcastCohortSize(size_t cohortSize) { broadcastCohortSize = cohortSize; }
+    size_t getBroadcastCohortSize() const { return broadcastCohortSize; }
+    
     // 添加用户自定义事件
     void addUserEvent(const std::string& name, const std::string& description,
-                     const std::vector<std::tuple<std::string, std::vector<double>, std::string>>& options);
+                     const std::vector<std::tuple<std::string, DecisionVector, std::string>>& options);
     
     // 获取事件历史
     const std::vector<std::string>& getEventHistory() const { return eventHistory; }
     
-    // 获取代理列表
-    const std::vector<BioAgent>& getAgents() const { return agents; }
+    // 获取代理种群
+    const AgentPopulation& getAgents() const { return agents; }
+    
+    // 获取代理数量
+    size_t getNumAgents() const { return agents.size(); }
+    
+    // 设置代理数量（新增代理随机初始化，模拟运行中不可调整）
+    void setNumAgents(size_t numAgents);
     
     // 获取指定代理的决策向量字符串
     std::string getAgentDecisionVectorString(int agentId) const;
     
-    // 获取所有代理的详细状态（用于交互式显示）
-    std::vector<std::string> getAllAgentsDetailedStatus() const;
+    // 获取代理的详细状态（用于交互式显示），最多列出 maxAgents 个代理
+    std::vector<std::string> getAllAgentsDetailedStatus(size_t maxAgents = MAX_DISPLAYED_AGENTS) const;
+    
+    // 获取整个种群的汇总状态（各维度平均值）
+    std::string getPopulationSummary() const;
+    
+    // 前 maxAgents 个代理各自在整个种群中最相似的 k 个代理（余弦相似度，用于详细状态显示）
+    std::vector<std::string> getSimilarAgentsStatus(size_t maxAgents = MAX_DISPLAYED_AGENTS, size_t k = 3) const;
+    
+    // 查找决策向量最接近 target 的 k 个代理（按距离升序）
+    std::vector<DecisionIndex::Match> findNearestAgents(const DecisionVector& target, size_t k) const;
+    
+    // 查找决策向量与 target 距离不超过 radius 的所有代理（按距离升序）
+    std::vector<DecisionIndex::Match> findAgentsWithinRadius(const DecisionVector& target, double radius) const;
 
 private:
-    // 简化的事件选项定义
-    struct EventOption {
-        std::string text;                      // 选项文本
-        std::vector<double> decisionRequirement; // 12维决策要求向量
-        std::vector<double> decisionFeedback;    // 12维决策反馈向量
-        std::string outcomeText;               // 结果描述文本
+    // 事件和选项与 LLMClient 共用同一表示：生成的事件以共享的不可变句柄传递，
+    // 选择、处理事件和请求LLM选择时都不复制事件内容
+    using EventOption = LLMClient::EventOption;
+    using ChoiceEvent = LLMClient::RandomEvent;
+    using EventHandle = LLMClient::EventHandle;
+    
+    // 广播事件的处理结果
+    struct BroadcastResult {
+        size_t first = 0;                      // 群组第一个代理ID
+        size_t count = 0;                      // 群组代理数量
+        std::vector<size_t> chosenCounts;      // 每个选项被选择的代理数量
+        size_t fallbackCount = 0;              // 没有满足要求的选项、随机选择的代理数量
     };
     
-    // 简化的事件定义
-    struct ChoiceEvent {
-        std::string name;                      // 事件名称
-        std::string description;               // 事件描述
-        std::vector<EventOption> options;      // 可用选项（2-4个）
-    };
+    // 构造时读取一次的 config.json（文件不存在或格式错误时所有配置项取默认值）
+    JsonDocument config;
+    
+    // 生物代理种群（按维度连续存储）
+    AgentPopulation agents;
     
-    // 生物代理集合
-    std::vector<BioAgent> agents;
+    // 代理决策向量的最近邻索引（必须声明在 agents 之后），随 applyEventOutcome 增量更新
+    DecisionIndex agentIndex;
     
     // 模拟状态
     std::atomic<bool> running;
@@ -79,8 +128,15 @@ private:
     
     // 随机事件参数
     double randomEventProb;
-    mutable std::mt19937 rng;
-    std::uniform_real_distribution<double> probDist;
+    CounterRng rng;  // 环境自身的随机数流（由全局种子决定，可重放）
+    
+    // 广播模式参数
+    bool broadcastMode;
+    size_t broadcastCohortSize;
+    uint64_t broadcastTick;  // 已处理的广播事件数，用于派生每个广播事件的随机数流
+    
+    // LLM事件预取（API模式下启用），模拟循环只从队列取事件，不等待LLM
+    EventPrefetcher eventPrefetcher;
     
     // 事件系统
     std::vector<ChoiceEvent> events;
@@ -89,22 +145,31 @@ private:
     
     // 内部方法
     void initializeEvents();
-    ChoiceEvent generateRandomEvent();
+    EventHandle generateRandomEvent();
     void processEvent(const ChoiceEvent& event);
     int selectOptionForAgent(const BioAgent& agent, const ChoiceEvent& event);
-    void applyEventOutcome(int agentId, const EventOption& option);
+    void applyEventOutcome(size_t agentId, const EventOption& option);
+    
+    // 事件详情（序号、名称、描述和选项列表，chosenCounts 不为空时附上每个选项被选择的代理数量），用于日志输出
+    std::string describeEvent(const ChoiceEvent& event, const std::vector<size_t>* chosenCounts = nullptr) const;
+    
+    // 广播事件：批量检查决策要求，按选择的选项把代理分组，再按组批量应用反馈
+    void processBroadcastEvent(const ChoiceEvent& event);
+    BroadcastResult applyBroadcastEvent(const ChoiceEvent& event);
+    void recordBroadcastEvent(const ChoiceEvent& event, const BroadcastResult& result);
     
     // 简化的事件生成方法
-    ChoiceEvent generateSimpleEvent();
-    ChoiceEvent generateLLMEvent(); // 使用LLM生成事件
+    EventHandle generateSimpleEvent();
+    EventHandle generateLLMEvent(); // 使用LLM生成事件（启用预取时只从预取队列取），事件无效时抛出异常
     
     // 随机数生成辅助方法
     double getRandomDouble(double min, double max);
     int getRandomInt(int min, int max);
+    size_t getRandomAgentIndex();
     
     // 决策向量辅助方法
-    std::vector<double> generateRandomDecisionVector();
-    std::vector<double> generateRandomFeedbackVector();
+    DecisionVector generateRandomDecisionVector();
+    DecisionVector generateRandomFeedbackVector();
     
     // 事件历史记录
     void recordEvent(const std::string& eventRecord);
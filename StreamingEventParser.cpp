@@ -0,0 +1,325 @@
+#include "StreamingEventParser.h"
+#include "DecisionVector.h"
+#include <charconv>
+
+namespace {
+    // 决策向量数组及其取值范围
+    bool vectorRange(const std::string& key, double& minValue, double& maxValue) {
+        if (key == "decisionRequirement") {
+            minValue = 0.0;
+            maxValue = 1.0;
+            return true;
+        }
+        if (key == "decisionFeedback") {
+            minValue = -0.2;
+            maxValue = 0.2;
+            return true;
+        }
+        return false;
+    }
+
+    bool endsWith(const std::string& text, const char* suffix) {
+        std::string_view view(text);
+        std::string_view tail(suffix);
+        return view.size() >= tail.size() && view.substr(view.size() - tail.size()) == tail;
+    }
+
+    // 顶层开始之前只有空白和代码块标记（如 ```json）：输出直接以事件开头，不会是推理内容
+    bool onlyCodeFence(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) {
+            return true;
+        }
+        if (text.compare(begin, 3, "```") != 0) {
+            return false;
+        }
+        for (size_t i = begin + 3; i < text.size(); ++i) {
+            char c = text[i];
+            bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            if (!letter && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 判断是否只有代码块标记时保留的开头文字长度
+    constexpr size_t PREAMBLE_TEXT_LIMIT = 32;
+}
+
+StreamingEventParser::Status StreamingEventParser::feed(std::string_view text) {
+    for (char c : text) {
+        if (currentStatus != Status::Incomplete) {
+            break;
+        }
+        consume(c);
+        if (provisional && currentStatus != Status::Incomplete) {
+            // 试探性解析的结果先保留，之后的输入只用于查找 </think>
+            heldStatus = currentStatus;
+            currentStatus = Status::Incomplete;
+        }
+    }
+    return currentStatus;
+}
+
+StreamingEventParser::Status StreamingEventParser::finish() {
+    if (provisional) {
+        provisional = false;
+        if (heldStatus != Status::Incomplete) {
+            currentStatus = heldStatus;
+        }
+    }
+    return currentStatus;
+}
+
+std::vector<std::string> StreamingEventParser::takeCompletedEvents() {
+    std::vector<std::string> events;
+    if (provisional) {
+        return events;
+    }
+    events.swap(completedEvents);
+    return events;
+}
+
+void StreamingEventParser::consume(char c) {
+    if (!started) {
+        consumePreamble(c);
+        return;
+    }
+    if (provisional && trackThinkingTags(c)) {
+        restartAfterThinking();
+        return;
+    }
+    if (heldStatus != Status::Incomplete) {
+        return;
+    }
+    if (insideEvent()) {
+        eventText += c;
+    }
+
+    if (inString) {
+        if (escaped) {
+            escaped = false;
+        } else if (c == '\\') {
+            escaped = true;
+            return;
+        } else if (c == '"') {
+            inString = false;
+            if (stringIsKey) {
+                lastKey = stringValue;
+                expectingKey = false;
+            } else {
+                valueFinished();
+            }
+            return;
+        }
+        if (stringIsKey) {
+            stringValue += c;
+        }
+        return;
+    }
+
+    switch (c) {
+        case '"': {
+            finishToken();
+            stringIsKey = expectingKey && !stack.empty() && stack.back().type == '{';
+            stringValue.clear();
+            inString = true;
+            double minValue, maxValue;
+            if (!stringIsKey && stack.back().type == '[' && vectorRange(stack.back().key, minValue, maxValue)) {
+                rejectEvent(stack.back().key + " 中出现非数值");
+            }
+            return;
+        }
+        case '{':
+        case '[':
+            finishToken();
+            openContainer(c);
+            return;
+        case '}':
+        case ']':
+            finishToken();
+            closeContainer(c);
+            return;
+        case ',':
+            finishToken();
+            expectingKey = stack.back().type == '{';
+            return;
+        case ':':
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+            finishToken();
+            return;
+        default:
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E') {
+                token += c;
+                return;
+            }
+            fail(std::string("意外的字符 '") + c + "'");
+            return;
+    }
+}
+
+void StreamingEventParser::consumePreamble(char c) {
+    if (trackThinkingTags(c)) {
+        inThinking = false;
+        thinkingClosed = true;
+        preambleText.clear();
+        return;
+    }
+    if (inThinking) {
+        return;
+    }
+    if (c != '{' && c != '[') {
+        if (preambleText.size() <= PREAMBLE_TEXT_LIMIT) {
+            preambleText += c;
+        }
+        return;
+    }
+
+    started = true;
+    provisional = !thinkingClosed && !onlyCodeFence(preambleText);
+    eventDepth = c == '[' ? 1 : 0;
+    openContainer(c);
+}
+
+bool StreamingEventParser::trackThinkingTags(char c) {
+    // 只保留最近8个字符，足以识别 <think> 和 </think>
+    preambleTail += c;
+    if (preambleTail.size() > 8) {
+        preambleTail.erase(0, preambleTail.size() - 8);
+    }
+    if (endsWith(preambleTail, "<think>")) {
+        inThinking = true;
+    }
+    return endsWith(preambleTail, "</think>");
+}
+
+void StreamingEventParser::restartAfterThinking() {
+    *this = StreamingEventParser();
+    thinkingClosed = true;
+}
+
+void StreamingEventParser::finishToken() {
+    if (token.empty()) {
+        return;
+    }
+    std::string text;
+    text.swap(token);
+
+    double minValue = 0.0, maxValue = 0.0;
+    bool inVector = stack.back().type == '[' && vectorRange(stack.back().key, minValue, maxValue);
+
+    if (text == "true" || text == "false" || text == "null") {
+        if (inVector) {
+            rejectEvent(stack.back().key + " 中出现非数值: " + text);
+        }
+        valueFinished();
+        return;
+    }
+
+    double value = 0.0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size()) {
+        fail("无法识别的值: " + text);
+        return;
+    }
+    if (inVector && (value < minValue || value > maxValue)) {
+        rejectEvent(stack.back().key + " 取值超出范围: " + text);
+    }
+    valueFinished();
+}
+
+void StreamingEventParser::valueFinished() {
+    if (stack.empty() || stack.back().type != '[') {
+        return;
+    }
+    Frame& top = stack.back();
+    ++top.count;
+
+    double minValue, maxValue;
+    if (top.count > DecisionVector::DIMENSIONS && vectorRange(top.key, minValue, maxValue)) {
+        rejectEvent(top.key + " 长度超过" + std::to_string(DecisionVector::DIMENSIONS));
+    }
+}
+
+void StreamingEventParser::openContainer(char type) {
+    if (!stack.empty() && stack.back().type == '[') {
+        const Frame& parent = stack.back();
+        double minValue, maxValue;
+        if (vectorRange(parent.key, minValue, maxValue)) {
+            rejectEvent(parent.key + " 中出现非数值");
+        } else if (parent.key == "options" && parent.count >= OPTION_COUNT) {
+            rejectEvent("选项数量超过" + std::to_string(OPTION_COUNT) + "个");
+        }
+    }
+
+    std::string key = !stack.empty() && stack.back().type == '{' ? lastKey : std::string();
+    stack.push_back(Frame{type, std::move(key), 0});
+    expectingKey = type == '{';
+
+    if (type == '{' && stack.size() == eventDepth + 1) {
+        // 新事件开始
+        eventText = "{";
+        eventRejected = false;
+    }
+}
+
+void StreamingEventParser::closeContainer(char type) {
+    char expected = type == '}' ? '{' : '[';
+    if (stack.empty() || stack.back().type != expected) {
+        fail("括号不匹配");
+        return;
+    }
+
+    // 数组结束时检查长度（此时仍在事件内部）
+    const Frame& top = stack.back();
+    double minValue, maxValue;
+    if (top.type == '[' && vectorRange(top.key, minValue, maxValue) && top.count != DecisionVector::DIMENSIONS) {
+        rejectEvent(top.key + " 长度为" + std::to_string(top.count) + "，应为" +
+                    std::to_string(DecisionVector::DIMENSIONS));
+    } else if (top.type == '[' && top.key == "options" && top.count != OPTION_COUNT) {
+        rejectEvent("选项数量为" + std::to_string(top.count) + "，应为" + std::to_string(OPTION_COUNT));
+    }
+    if (currentStatus == Status::Invalid) {
+        return;
+    }
+
+    Frame frame = std::move(stack.back());
+    stack.pop_back();
+
+    if (frame.type == '{' && stack.size() == eventDepth) {
+        // 事件结束
+        if (eventRejected) {
+            ++rejectedEvents;
+        } else {
+            completedEvents.push_back(std::move(eventText));
+        }
+        eventText.clear();
+    }
+
+    if (stack.empty()) {
+        currentStatus = Status::Complete;
+        return;
+    }
+    expectingKey = false;
+    valueFinished();
+}
+
+void StreamingEventParser::rejectEvent(const std::string& reason) {
+    if (eventDepth == 0 || !insideEvent()) {
+        fail(reason);
+        return;
+    }
+    if (!eventRejected) {
+        eventRejected = true;
+        lastError = reason;
+    }
+}
+
+void StreamingEventParser::fail(const std::string& reason) {
+    currentStatus = Status::Invalid;
+    lastError = reason;
+}
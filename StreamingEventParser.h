@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 流式事件解析器：逐段输入LLM输出的事件JSON文本，边接收边检查结构
+// 输出可以是单个事件对象，也可以是事件对象数组（批量生成）；对象之前的说明文字、代码块标记和 <think> 段会被跳过
+// 推理模型可能只输出结尾的 </think>（推理内容没有开头标签）：与非流式解析一样，</think> 之前的内容都不是事件。
+// 输出不是直接以对象/数组（或代码块标记）开头时，在遇到 </think> 之前的解析只是试探性的：
+// 结果（完成或无效）暂不报告，遇到 </think> 时丢弃并从它之后重新解析，输出结束时由 finish() 确定
+// 检查内容：括号/字符串配对、options 数量、decisionRequirement/decisionFeedback 的长度和取值范围
+// 单个事件出现问题时整个输出无效（调用方应立即中止请求）；数组中某个事件出现问题时只丢弃该事件
+// 只做结构检查，完整接收的事件文本仍需由调用方解析和验证
+class StreamingEventParser {
+public:
+    enum class Status {
+        Incomplete,   // 还需要更多输入
+        Complete,     // 顶层对象/数组已结束
+        Invalid       // 结构无效，应中止请求
+    };
+
+    // 每个事件的选项数量
+    static constexpr size_t OPTION_COUNT = 10;
+
+    // 输入一段文本，返回当前状态（Complete/Invalid 之后的输入会被忽略）
+    Status feed(std::string_view text);
+
+    // 输出结束时调用：试探性解析的结果成为最终结果，返回最终状态
+    Status finish();
+
+    Status status() const { return currentStatus; }
+
+    // 结构无效（或最近一个事件被丢弃）的原因
+    const std::string& error() const { return lastError; }
+
+    // 取出已完整接收且通过结构检查的事件JSON文本（试探性解析的事件在 finish() 之前不会取出）
+    std::vector<std::string> takeCompletedEvents();
+
+    // 因结构问题被丢弃的事件数量
+    size_t rejectedEventCount() const { return rejectedEvents; }
+
+private:
+    // 正在解析的对象或数组
+    struct Frame {
+        char type;           // '{' 或 '['
+        std::string key;     // 该容器在父对象中对应的键（父容器是数组时为空）
+        size_t count = 0;    // 数组元素数量
+    };
+
+    Status currentStatus = Status::Incomplete;
+    std::string lastError;
+
+    std::vector<Frame> stack;
+    bool started = false;            // 是否已遇到顶层的 '{' 或 '['
+    bool inThinking = false;         // 顶层开始之前位于 <think> 段中
+    bool thinkingClosed = false;     // 已遇到 </think>，之后的输出不再是推理内容
+    bool provisional = false;        // 当前解析是试探性的（之前的文字可能是没有开头标签的推理内容）
+    Status heldStatus = Status::Incomplete;  // 试探性解析已得到、尚未报告的结果
+    std::string preambleTail;        // 最近的几个字符（识别 <think> 标签）
+    std::string preambleText;        // 顶层开始之前的文字（只保留开头部分，判断是否只有代码块标记）
+
+    bool inString = false;
+    bool escaped = false;
+    bool expectingKey = false;       // 当前对象中下一个字符串是键
+    bool stringIsKey = false;        // 当前字符串是键
+    std::string stringValue;         // 当前字符串（只保存键）
+    std::string lastKey;             // 当前对象中最近的键
+    std::string token;               // 当前数字或字面量
+
+    size_t eventDepth = 0;           // 事件对象所在的栈深度（单个事件为0，事件数组为1）
+    std::string eventText;           // 当前事件的文本
+    bool eventRejected = false;      // 当前事件已被判定为无效
+    std::vector<std::string> completedEvents;
+    size_t rejectedEvents = 0;
+
+    // 处理一个字符
+    void consume(char c);
+
+    // 顶层开始之前的字符：跳过说明文字和 <think> 段
+    void consumePreamble(char c);
+
+    // 记录最近的字符，返回是否刚好遇到 </think>（遇到 <think> 时设置 inThinking）
+    bool trackThinkingTags(char c);
+
+    // 试探性解析遇到 </think>：丢弃已解析的内容，从 </think> 之后重新开始
+    void restartAfterThinking();
+
+    // 结束当前数字或字面量
+    void finishToken();
+
+    // 一个值（字符串、数字、字面量或容器）结束，更新所在数组的计数
+    void valueFinished();
+
+    void openContainer(char type);
+    void closeContainer(char type);
+
+    // 当前是否位于某个事件对象内部
+    bool insideEvent() const { return stack.size() > eventDepth; }
+
+    // 事件内容不符合要求：单个事件时整个输出无效，事件数组时丢弃当前事件
+    void rejectEvent(const std::string& reason);
+
+    // 语法错误：整个输出无效
+    void fail(const std::string& reason);
+};
@@ -0,0 +1,118 @@
+// 流式事件解析器测试：推理内容（有或没有 <think> 开头标签）、代码块标记、单个事件和事件数组
+// 每个用例分别整段输入和逐字符输入；失败时输出用例名称并返回非零
+#include "StreamingEventParser.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+    using Status = StreamingEventParser::Status;
+
+    int failures = 0;
+
+    // 一个结构有效的事件；badRequirement 为 true 时第一个选项的 decisionRequirement 超出范围
+    std::string buildEvent(int id, bool badRequirement = false) {
+        std::ostringstream out;
+        out << "{\"name\": \"事件" << id << "\", \"description\": \"描述\", \"options\": [";
+        for (int i = 0; i < 10; ++i) {
+            out << (i ? ", " : "") << "{\"text\": \"选项" << i << "\", \"decisionRequirement\": [";
+            for (int d = 0; d < 12; ++d) {
+                out << (d ? ", " : "") << (badRequirement && i == 0 && d == 0 ? "1.5" : "0.1");
+            }
+            out << "], \"decisionFeedback\": [";
+            for (int d = 0; d < 12; ++d) {
+                out << (d ? ", " : "") << "-0.05";
+            }
+            out << "], \"outcomeText\": \"结果\"}";
+        }
+        out << "]}";
+        return out.str();
+    }
+
+    struct Result {
+        Status fed;           // 输入结束时（finish 之前）的状态
+        Status finished;      // finish() 之后的状态
+        size_t events;
+        size_t rejected;
+    };
+
+    Result parse(const std::string& text, bool byCharacter) {
+        StreamingEventParser parser;
+        Result result;
+        if (byCharacter) {
+            for (char c : text) {
+                parser.feed(std::string_view(&c, 1));
+            }
+        } else {
+            parser.feed(text);
+        }
+        result.fed = parser.status();
+        result.finished = parser.finish();
+        result.events = parser.takeCompletedEvents().size();
+        result.rejected = parser.rejectedEventCount();
+        return result;
+    }
+
+    const char* statusName(Status status) {
+        switch (status) {
+            case Status::Incomplete: return "Incomplete";
+            case Status::Complete:   return "Complete";
+            case Status::Invalid:    return "Invalid";
+        }
+        return "?";
+    }
+
+    // fed 为输入结束时应报告的状态（Incomplete 表示结果要等 finish() 确定）
+    void expect(const char* name, const std::string& text, Status fed, Status finished, size_t events, size_t rejected) {
+        for (bool byCharacter : {false, true}) {
+            Result result = parse(text, byCharacter);
+            if (result.fed != fed || result.finished != finished || result.events != events || result.rejected != rejected) {
+                ++failures;
+                std::cout << "失败: " << name << (byCharacter ? "（逐字符）" : "（整段）")
+                          << " 状态 " << statusName(result.fed) << "/" << statusName(result.finished)
+                          << "，事件 " << result.events << "，丢弃 " << result.rejected
+                          << "；应为 " << statusName(fed) << "/" << statusName(finished)
+                          << "，事件 " << events << "，丢弃 " << rejected << std::endl;
+            }
+        }
+    }
+}
+
+int main() {
+    const std::string event = buildEvent(1);
+    const std::string badEvent = buildEvent(2, true);
+    const std::string batch = "[" + event + ", " + badEvent + ", " + buildEvent(3) + "]";
+
+    // 没有开头标签的推理内容中出现数组和对象，不能被当作事件解析
+    const std::string reasoning = "Okay, the vectors look like [0.1, 0.2, and so on].\n"
+                                  "Maybe something like {\"name\": \"x\"} would work.\n</think>\n";
+
+    expect("直接输出事件", event, Status::Complete, Status::Complete, 1, 0);
+    expect("代码块中的事件", "```json\n" + event + "\n```", Status::Complete, Status::Complete, 1, 0);
+    expect("直接输出的无效事件立即报告", badEvent + "\n剩余输出", Status::Invalid, Status::Invalid, 0, 0);
+    expect("代码块中的无效事件立即报告", "```json\n" + badEvent, Status::Invalid, Status::Invalid, 0, 0);
+    expect("输出在事件结束前中断", event.substr(0, event.size() / 2), Status::Incomplete, Status::Incomplete, 0, 0);
+
+    expect("<think> 段之后的事件", "<think>先想想 [1, 2, x] {</think>\n" + event, Status::Complete, Status::Complete, 1, 0);
+    expect("只有 </think> 的推理内容之后的事件", reasoning + event, Status::Complete, Status::Complete, 1, 0);
+    expect("只有 </think> 的推理内容之后的无效事件", reasoning + badEvent, Status::Invalid, Status::Invalid, 0, 0);
+    expect("推理内容未结束", "Let me think about [0.1, 0.2, and so on]", Status::Incomplete, Status::Invalid, 0, 0);
+
+    // 没有 </think> 的说明文字之后的事件：结果在 finish() 时确定
+    expect("说明文字之后的事件", "Here is the event:\n" + event, Status::Incomplete, Status::Complete, 1, 0);
+    expect("说明文字之后的无效事件", "Here is the event:\n" + badEvent, Status::Incomplete, Status::Invalid, 0, 0);
+
+    // 事件数组：无效的事件只丢弃它本身
+    expect("事件数组", batch, Status::Complete, Status::Complete, 2, 1);
+    expect("代码块中的事件数组", "```json\n" + batch + "\n```", Status::Complete, Status::Complete, 2, 1);
+    expect("推理内容之后的事件数组", reasoning + batch, Status::Complete, Status::Complete, 2, 1);
+    expect("<think> 段之后的事件数组", "<think>[\"a\", {]</think>" + batch, Status::Complete, Status::Complete, 2, 1);
+    expect("说明文字之后的事件数组", "Events:\n" + batch, Status::Incomplete, Status::Complete, 2, 1);
+    expect("事件数组在中途中断", "[" + event + ", " + event.substr(0, 40), Status::Incomplete, Status::Incomplete, 1, 0);
+    expect("事件数组语法错误", "[" + event + ", {\"name\": oops}]", Status::Invalid, Status::Invalid, 1, 0);
+
+    if (failures == 0) {
+        std::cout << "StreamingEventParser: 全部通过" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -1,9 +1,103 @@
 #include <iostream>
 #include "SimulationEnvironment.h"
+#include "LLMClient.h"
+#include "Logger.h"
 #include <limits>
 #include <cstdlib>
-#include <windows.h>
+#include <algorithm>
 #include <iomanip>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 命令行参数
+struct CommandLineOptions {
+    bool batch = false;          // 运行批量模拟后退出（不进入菜单）
+    int events = 0;              // 批量模拟事件数量（0 表示使用配置文件）
+    int sampleInterval = -1;     // 批量模拟采样间隔（-1 表示使用配置文件）
+    size_t agents = 0;           // 代理数量（0 表示使用配置文件）
+    unsigned long long seed = 0; // 随机种子（0 表示使用配置文件）
+    bool broadcast = false;      // 开启广播模式
+    size_t cohort = 0;           // 广播群组大小（0 表示使用配置文件）
+    bool help = false;           // 显示帮助后退出
+    std::string importEvents;    // 从该目录导入JSON事件文件到事件库后退出
+    std::string exportEvents;    // 把事件库导出为该目录下的JSON事件文件后退出
+};
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " [选项]" << std::endl;
+    std::cout << "  不带 --batch 时进入交互式菜单" << std::endl;
+    std::cout << "  --batch            运行批量模拟（无界面）并报告吞吐量，然后退出" << std::endl;
+    std::cout << "  --events N         批量模拟的事件数量（默认读取 batch_events）" << std::endl;
+    std::cout << "  --sample N         每 N 个事件输出一行进度，0 表示关闭（默认读取 batch_sample_interval）" << std::endl;
+    std::cout << "  --agents N         代理数量（默认读取 num_agents）" << std::endl;
+    std::cout << "  --seed N           随机种子（默认读取 random_seed）" << std::endl;
+    std::cout << "  --broadcast        开启广播模式（默认读取 broadcast_events）" << std::endl;
+    std::cout << "  --cohort N         广播群组大小（默认读取 broadcast_cohort_size）" << std::endl;
+    std::cout << "  --import-events 目录  把目录下的 *.json 事件文件导入事件库 llm_events/events.bin，然后退出" << std::endl;
+    std::cout << "  --export-events 目录  把事件库中的事件导出为目录下的 JSON 文件，然后退出" << std::endl;
+    std::cout << "  --help             显示本帮助" << std::endl;
+}
+
+// 解析命令行参数，参数无效时返回 false
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--batch") {
+            options.batch = true;
+            continue;
+        }
+        if (arg == "--broadcast") {
+            options.broadcast = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h") {
+            options.help = true;
+            continue;
+        }
+        
+        if (arg == "--import-events" || arg == "--export-events") {
+            if (i + 1 >= argc) {
+                std::cerr << "选项 " << arg << " 缺少目录" << std::endl;
+                return false;
+            }
+            (arg == "--import-events" ? options.importEvents : options.exportEvents) = argv[++i];
+            continue;
+        }
+        
+        // 其余选项都需要一个非负整数值
+        if (arg != "--events" && arg != "--sample" && arg != "--agents" && arg != "--seed" && arg != "--cohort") {
+            std::cerr << "未知选项: " << arg << std::endl;
+            return false;
+        }
+        if (i + 1 >= argc || argv[i + 1][0] == '-') {
+            std::cerr << "选项 " << arg << " 缺少数值" << std::endl;
+            return false;
+        }
+        unsigned long long value;
+        try {
+            value = std::stoull(argv[++i]);
+        } catch (...) {
+            std::cerr << "选项 " << arg << " 的数值无效: " << argv[i] << std::endl;
+            return false;
+        }
+        
+        if (arg == "--events") {
+            options.events = static_cast<int>(std::min<unsigned long long>(value, std::numeric_limits<int>::max()));
+        } else if (arg == "--sample") {
+            options.sampleInterval = static_cast<int>(std::min<unsigned long long>(value, std::numeric_limits<int>::max()));
+        } else if (arg == "--agents") {
+            options.agents = static_cast<size_t>(value);
+        } else if (arg == "--seed") {
+            options.seed = value;
+        } else {
+            options.cohort = static_cast<size_t>(value);
+        }
+    }
+    return true;
+}
 
 void clearInputBuffer() {
     std::cin.clear();
@@ -32,13 +126,70 @@ void displayDetailedAgentInfo(const SimulationEnvironment& env) {
     for (const auto& status : detailedStatus) {
         std::cout << status << std::endl;
     }
+    
+    if (env.getNumAgents() > detailedStatus.size()) {
+        std::cout << "... 共 " << env.getNumAgents() << " 个代理，" << env.getPopulationSummary() << std::endl;
+    }
+    
+    // 与整个种群比较的最相似代理（余弦相似度）
+    std::cout << "------------------------------------------" << std::endl;
+    std::cout << "最相似的代理：" << std::endl;
+    for (const auto& status : env.getSimilarAgentsStatus()) {
+        std::cout << status << std::endl;
+    }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
         // 设置控制台代码页为 UTF-8，支持中文输出
+        #ifdef _WIN32
         SetConsoleOutputCP(65001);
         SetConsoleCP(65001);
+        #endif
+        
+        CommandLineOptions options;
+        if (!parseCommandLine(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (options.help) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        
+        // 日志级别和限速（log_level、log_rate_limit）
+        Logger::instance().configure("config.json");
+        
+        // 事件库导入/导出：只初始化LLM客户端（打开事件库），完成后退出
+        if (!options.importEvents.empty() || !options.exportEvents.empty()) {
+            LLMClient& client = LLMClient::getInstance();
+            client.initialize("config.json");
+            if (!options.importEvents.empty()) {
+                size_t imported = client.importEventsFromJson(options.importEvents);
+                Logger::instance().flush();
+                std::cout << "导入 " << imported << " 个事件，事件库共 " << client.getSavedEventCount() << " 个事件" << std::endl;
+            }
+            if (!options.exportEvents.empty()) {
+                size_t exported = client.exportEventsToJson(options.exportEvents);
+                Logger::instance().flush();
+                std::cout << "导出 " << exported << " 个事件到 " << options.exportEvents << std::endl;
+            }
+            return 0;
+        }
+        
+        // 批量模式：不进入菜单，跑完即退出
+        if (options.batch) {
+            SimulationEnvironment env(options.agents, options.seed);
+            env.initialize();
+            if (options.broadcast) {
+                env.setBroadcastMode(true);
+            }
+            if (options.cohort > 0) {
+                env.setBroadcastCohortSize(options.cohort);
+            }
+            env.runBatchSimulation(options.events, options.sampleInterval);
+            return 0;
+        }
         
         std::cout << "==========================================" << std::endl;
         std::cout << "     决策向量与随机事件模拟系统 (AMPHOREUS)     " << std::endl;
@@ -46,11 +197,19 @@ int main() {
         std::cout << "系统已简化：只保留决策向量和随机事件功能" << std::endl;
         std::cout << std::endl;
         
-        SimulationEnvironment env;
+        SimulationEnvironment env(options.agents, options.seed);
         env.initialize();
+        if (options.broadcast) {
+            env.setBroadcastMode(true);
+        }
+        if (options.cohort > 0) {
+            env.setBroadcastCohortSize(options.cohort);
+        }
         
         bool running = true;
         while (running) {
+            // 菜单直接写控制台，先写完之前的日志
+            Logger::instance().flush();
             std::cout << std::endl;
             std::cout << "主菜单：" << std::endl;
             std::cout << "1. 运行交互式模拟（实时显示代理状态）" << std::endl;
@@ -60,8 +219,10 @@ int main() {
             std::cout << "5. 设置事件概率" << std::endl;
             std::cout << "6. 添加自定义事件" << std::endl;
             std::cout << "7. 查看事件历史" << std::endl;
-            std::cout << "8. 退出" << std::endl;
-            std::cout << "输入选项 (1-8): ";
+            std::cout << "8. 设置代理数量（当前 " << env.getNumAgents() << "）" << std::endl;
+            std::cout << "9. 切换广播模式（当前 " << (env.isBroadcastMode() ? "开" : "关") << "）" << std::endl;
+            std::cout << "10. 退出" << std::endl;
+            std::cout << "输入选项 (1-10): ";
             
             int choice;
             std::cin >> choice;
@@ -157,6 +318,31 @@ int main() {
                 }
                 
                 case 8: {
+                    std::cout << "请输入新的代理数量: ";
+                    long long numAgents;
+                    if (std::cin >> numAgents && numAgents > 0) {
+                        env.setNumAgents(static_cast<size_t>(numAgents));
+                    } else {
+                        std::cout << "输入无效，代理数量保持不变。" << std::endl;
+                    }
+                    clearInputBuffer();
+                    break;
+                }
+                
+                case 9: {
+                    env.setBroadcastMode(!env.isBroadcastMode());
+                    if (env.isBroadcastMode()) {
+                        std::cout << "广播模式已开启：每个事件作用于"
+                                  << (env.getBroadcastCohortSize() == 0 ? std::string("整个种群")
+                                      : std::to_string(env.getBroadcastCohortSize()) + " 个代理的群组")
+                                  << "。" << std::endl;
+                    } else {
+                        std::cout << "广播模式已关闭：每个事件作用于单个随机代理。" << std::endl;
+                    }
+                    break;
+                }
+                
+                case 10: {
                     running = false;
                     std::cout << "退出系统..." << std::endl;
                     break;
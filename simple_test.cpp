@@ -33,19 +33,19 @@ int main() {
     std::cout << "正在请求LLM生成包含10个选项的随机事件..." << std::endl;
     
     try {
-        LLMClient::RandomEvent event = LLMClient::getInstance().generateRandomEvent();
+        LLMClient::EventHandle event = LLMClient::getInstance().generateRandomEvent();
         
         std::cout << "\n事件生成成功!" << std::endl;
-        std::cout << "事件名称: " << event.name << std::endl;
-        std::cout << "事件描述: " << event.description << std::endl;
-        std::cout << "选项数量: " << event.options.size() << std::endl;
+        std::cout << "事件名称: " << event->name << std::endl;
+        std::cout << "事件描述: " << event->description << std::endl;
+        std::cout << "选项数量: " << event->options.size() << std::endl;
         
-        if (!event.options.empty()) {
+        if (!event->options.empty()) {
             std::cout << "\n第一个选项详情:" << std::endl;
-            std::cout << "  文本: " << event.options[0].text << std::endl;
-            std::cout << "  结果描述: " << event.options[0].outcomeText << std::endl;
-            std::cout << "  决策要求向量维度: " << event.options[0].decisionRequirement.size() << std::endl;
-            std::cout << "  决策反馈向量维度: " << event.options[0].decisionFeedback.size() << std::endl;
+            std::cout << "  文本: " << event->options[0].text << std::endl;
+            std::cout << "  结果描述: " << event->options[0].outcomeText << std::endl;
+            std::cout << "  决策要求向量维度: " << event->options[0].decisionRequirement.size() << std::endl;
+            std::cout << "  决策反馈向量维度: " << event->options[0].decisionFeedback.size() << std::endl;
         }
         
         std::cout << "\n=== 测试总结 ===" << std::endl;